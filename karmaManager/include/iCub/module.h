@@ -106,6 +106,7 @@ protected:
     bool                        executeGiveAction(int ARM);
     bool                        executeSpeech( const std::string &speech );
     double                      executeVirtualDraw(blobsData &blobsDetails);
+    double                      executeVirtualDrawSweep(blobsData &blobsDetails);
     double                      executeToolDrawNear(blobsData &blobsDetails);
     int                         executeToolAttach(const yarp::sig::Vector &tool);
     yarp::os::Bottle            executeKarmaOptimize( const yarp::sig::Vector &tool, const std::string &objName);
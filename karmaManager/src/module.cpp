@@ -934,45 +934,18 @@ int Manager::executeToolSearchOnLoc( const string &objName )
 
         //Attach the tool
         executeToolAttach(toolSmall);
-        double virtualtmp = 0.01; 
 
         //setup all parameters to get the best possible configuration
-        while (virtualtmp > 0.0 && virtualtmp < 0.08 )
-        {
-            virtualtmp = executeVirtualDraw(blobsDetails[smallIndex]);
-            if (virtualtmp > 0.1)
-                blobsDetails[smallIndex].bestDistance -= 0.005;
-            else if (virtualtmp > 1.0)
-                blobsDetails[smallIndex].bestDistance -= 0.1;
-            else
-                blobsDetails[smallIndex].bestDistance += 0.005;    
-            
-            fprintf(stdout, "the reply is: %lf \n",virtualtmp);
-        }
-
-        //do it one last time to get the correct confidence
-        blobsDetails[smallIndex].vdrawError = executeVirtualDraw(blobsDetails[smallIndex]);
+        //evaluating all the distances at once
+        blobsDetails[smallIndex].vdrawError = executeVirtualDrawSweep(blobsDetails[smallIndex]);
         fprintf (stdout, "\n\nTHE BEST ANGLE IS %lf WITH DISTANCE %lf  with confidence %lf\n\n",blobsDetails[smallIndex].bestAngle, blobsDetails[smallIndex].bestDistance, blobsDetails[smallIndex].vdrawError );
 
         //Attach the tool
         executeToolAttach(toolBig);
-        virtualtmp = 0.01; 
-        //setup all parameters to get the best possible configuration
-        while (virtualtmp > 0.0 && virtualtmp < 0.08 )
-        {
-            virtualtmp = executeVirtualDraw(blobsDetails[bigIndex]);
-            if (virtualtmp > 0.1)
-                blobsDetails[bigIndex].bestDistance -= 0.005;
-            else if (virtualtmp > 1.0)
-                blobsDetails[bigIndex].bestDistance -= 0.1;
-            else 
-                blobsDetails[bigIndex].bestDistance += 0.005;
-
-            fprintf(stdout, "the reply is: %lf \n",virtualtmp);
-        }
 
-        //do it one last time to get the correct confidence
-        blobsDetails[bigIndex].vdrawError = executeVirtualDraw(blobsDetails[bigIndex]);
+        //setup all parameters to get the best possible configuration
+        //evaluating all the distances at once
+        blobsDetails[bigIndex].vdrawError = executeVirtualDrawSweep(blobsDetails[bigIndex]);
         fprintf (stdout, "\n\nTHE BEST ANGLE IS %lf WITH DISTANCE %lf and confidence %lf\n\n",blobsDetails[bigIndex].bestAngle, blobsDetails[bigIndex].bestDistance, blobsDetails[bigIndex].vdrawError );
 
         int whichArm = 0;
@@ -1196,6 +1169,58 @@ double Manager::executeVirtualDraw(blobsData &blobsDetails)
     return result;
 }
 /**********************************************************/
+double Manager::executeVirtualDrawSweep(blobsData &blobsDetails)
+{
+    //the draw is lengthened by 0.005 m as long as the virtual
+    //draw keeps being good: all the lengths are tested in one go
+    fprintf(stdout,"Will now send the sweep to karmaMotor:\n");
+    Bottle karmaMotor,KarmaReply;
+    karmaMotor.addString("sweep");
+    karmaMotor.addDouble(objectPos[0]);
+    karmaMotor.addDouble(objectPos[1]);
+    karmaMotor.addDouble(objectPos[2]);
+    Bottle &theta = karmaMotor.addList();
+    theta.addString("theta");
+    theta.addDouble(blobsDetails.bestAngle);
+    Bottle &radius = karmaMotor.addList();
+    radius.addString("radius");
+    radius.addDouble(0.1); //10 cm
+    Bottle &dist = karmaMotor.addList();
+    dist.addString("dist");
+    dist.addString("range");
+    dist.addDouble(blobsDetails.bestDistance);
+    dist.addDouble(blobsDetails.bestDistance+0.3);
+    dist.addDouble(0.005);
+
+    fprintf(stdout,"%s\n",karmaMotor.toString().c_str());
+    rpcMotorKarma.write(karmaMotor, KarmaReply);
+    fprintf(stdout,"sweep is %s:\n",KarmaReply.toString().c_str());
+
+    // the table is the group (table (t r d q) ...)
+    Bottle &table = KarmaReply.findGroup("table");
+    if (table.size() < 2)
+        return executeVirtualDraw(blobsDetails);
+
+    double result = 0.0;
+    for (int i=1; i<table.size(); i++)
+    {
+        Bottle *entry = table.get(i).asList();
+        if ((entry == NULL) || (entry->size() < 4))
+            break;
+
+        double quality = entry->get(3).asDouble();
+        if (i == 1)
+            result = quality;
+        if (quality <= 0.0 || quality >= 0.08)
+            break;
+
+        blobsDetails.bestDistance = entry->get(2).asDouble();
+        result = quality;
+    }
+
+    return result;
+}
+/**********************************************************/
 bool Manager::executeGiveAction(int ARM)
 {
 
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __ACTIONEXEC_H__
+#define __ACTIONEXEC_H__
+
+#include <string>
+#include <deque>
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Semaphore.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/dev/CartesianControl.h>
+
+#include "iCub/telemetry.h"
+
+/**********************************************************/
+struct ActionSegment
+{
+    std::string       name;
+    yarp::sig::Vector xd;
+    yarp::sig::Vector od;
+    double            trajTime;
+    double            timeout;  // maximum duration of the segment
+    double            blend;    // fraction of the motion after which the
+                                // next segment is issued; 1.0 to wait for
+                                // the motion to be done
+};
+
+
+/**********************************************************/
+class ActionExecutor
+{
+protected:
+    class MotionEvent : public yarp::dev::CartesianEvent
+    {
+        ActionExecutor &owner;
+    public:
+        MotionEvent(ActionExecutor &owner_) : owner(owner_) { }
+        void cartesianEventCallback() { owner.onEvent(cartesianEventVariables.time); }
+    };
+
+    yarp::dev::ICartesianControl *iarm;
+    const bool                   *interrupt;
+    ActionRecord                 *record;
+    std::deque<ActionSegment>     segments;
+    yarp::os::Bottle              timings;
+    size_t                        completed;
+    yarp::os::Semaphore           sem;
+    yarp::os::Semaphore           mutexEvents;
+    bool                          armed;    // events accepted for the current segment
+    double                        tArmed;   // time the current segment was issued
+    MotionEvent                   doneEvent;
+    bool                          useEvents;
+
+    void armEvents(const bool sw);
+    void onEvent(const double t);
+    bool isInterrupted() const;
+    bool wait(const ActionSegment &segment, const double t0);
+    bool waitEvent(const ActionSegment &segment, const double t0);
+    bool waitPolling(const ActionSegment &segment, const double t0);
+
+public:
+    ActionExecutor(yarp::dev::ICartesianControl *iarm, const bool *interrupt=NULL);
+    void clear();
+    void setRecord(ActionRecord *record) { this->record=record; }
+    void add(const std::string &name, const yarp::sig::Vector &xd,
+             const yarp::sig::Vector &od, const double trajTime,
+             const double timeout, const double blend=1.0);
+    bool execute();
+    const yarp::os::Bottle &getTimings() const { return timings; }
+    size_t getNumSegments() const              { return segments.size(); }
+    size_t getNumCompleted() const             { return completed; }
+    ~ActionExecutor();
+};
+
+#endif
+
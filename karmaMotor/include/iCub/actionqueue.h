@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __ACTIONQUEUE_H__
+#define __ACTIONQUEUE_H__
+
+#include <string>
+#include <deque>
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Thread.h>
+#include <yarp/os/Semaphore.h>
+#include <yarp/os/BufferedPort.h>
+
+// State shared by a running action and whoever may cancel it.
+/**********************************************************/
+struct ActionControl
+{
+    int  id;            // id of the queued action; -1 for direct requests
+    bool interrupt;     // raised to interrupt this action only
+    int  blocking;      // arm whose idle hand held the workspace; -1 if none
+
+    ActionControl() : id(-1), interrupt(false), blocking(-1) { }
+};
+
+
+/**********************************************************/
+class ActionHandler
+{
+public:
+    // run the command synchronously on behalf of the given
+    // lane; true if acknowledged
+    virtual bool execute(const yarp::os::Bottle &command, yarp::os::Bottle &reply,
+                         const std::string &lane, ActionControl &control)=0;
+    // interrupt the given action only
+    virtual void abort(ActionControl &control)=0;
+    virtual ~ActionHandler() { }
+};
+
+
+// Actions are executed in order within each lane, whereas the
+// lanes run concurrently, each one with its own motion thread.
+/**********************************************************/
+class ActionQueue
+{
+protected:
+    struct Action
+    {
+        int              id;
+        int              lane;
+        yarp::os::Bottle command;
+        std::string      status;
+        yarp::os::Bottle reply;
+        double           tSubmit;
+        double           tStart;
+        double           tEnd;
+    };
+
+    class Lane : public yarp::os::Thread
+    {
+    public:
+        ActionQueue        &queue;
+        int                 idx;
+        std::string         name;
+        yarp::os::Semaphore pending;
+        std::deque<Action>  queued;
+        Action              running;
+        ActionControl       control;
+        bool                isBusy;
+        bool                cancelRequested;
+
+        Lane(ActionQueue &queue_, const int idx_, const std::string &name_) :
+             queue(queue_), idx(idx_), name(name_), pending(0),
+             isBusy(false), cancelRequested(false) { }
+        void onStop() { pending.post(); }
+        void run()    { queue.serve(*this); }
+    };
+
+    ActionHandler                            &handler;
+    yarp::os::BufferedPort<yarp::os::Bottle> &eventPort;
+    yarp::os::Semaphore                       mutex;
+    yarp::os::Semaphore                       mutexEvents;
+
+    std::deque<Lane*>  lanes;
+    std::deque<Action> finished;    // most recent at the back
+    int                nextId;
+
+    void publish(const Action &action);
+    void fill(const Action &action, yarp::os::Bottle &info) const;
+    void archive(const Action &action);
+    void serve(Lane &lane);
+
+public:
+    ActionQueue(ActionHandler &handler, yarp::os::BufferedPort<yarp::os::Bottle> &eventPort,
+                const std::deque<std::string> &laneNames);
+    int  getLane(const std::string &name) const;
+    int  submit(const yarp::os::Bottle &command, const int lane=0);
+    bool status(const int id, yarp::os::Bottle &info);
+    bool cancel(const int id);
+    void start();
+    void stop();
+    ~ActionQueue();
+};
+
+#endif
+
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __ARMARBITER_H__
+#define __ARMARBITER_H__
+
+#include <deque>
+
+#include <yarp/os/Semaphore.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/dev/CartesianControl.h>
+
+// Arms (0 left, 1 right) are granted to one action at a time.
+// Before moving, each action reserves the region of the table swept
+// by the hand (the box bounding its waypoints, grown by a margin
+// accounting for the hand and the forearm); regions of actions
+// running concurrently on the two arms must not overlap.
+// Once released after moving, an arm keeps the region around its
+// hand until the hand has moved away from there (e.g. sent back
+// home), since an idle arm is still standing in the workspace; a
+// reservation waiting for such a hand fails after a timeout.
+/**********************************************************/
+class ArmArbiter
+{
+protected:
+    struct Reservation
+    {
+        bool   busy;
+        const bool *owner;  // interrupt flag of the holding action
+        bool   region;
+        double xmin,xmax;
+        double ymin,ymax;
+    };
+
+    yarp::os::Semaphore mutex;
+    Reservation         reservations[2];
+    yarp::dev::ICartesianControl *arms[2];
+    double              margin;
+    double              idleTimeout;
+
+    bool overlap(const Reservation &r1, const Reservation &r2) const;
+    bool isInterrupted(const bool *interrupt) const;
+    bool getHand(const int arm, yarp::sig::Vector &x) const;
+
+public:
+    ArmArbiter();
+    void setMargin(const double margin);
+    void setIdleTimeout(const double timeout);
+    void setArms(yarp::dev::ICartesianControl *left,
+                 yarp::dev::ICartesianControl *right);
+    bool acquire(const int arm, const bool *interrupt=NULL);
+    bool reserve(const int arm, const std::deque<yarp::sig::Vector> &points,
+                 const bool *interrupt=NULL, int *blocking=NULL);
+    bool acquireAll(const bool *interrupt=NULL);
+    bool isOwner(const int arm, const bool *interrupt);
+    void release(const int arm, const bool moved=true);
+    void releaseAll();
+};
+
+#endif
+
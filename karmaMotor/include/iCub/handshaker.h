@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __HANDSHAKER_H__
+#define __HANDSHAKER_H__
+
+#include <string>
+#include <vector>
+
+#include <yarp/os/RateThread.h>
+#include <yarp/os/Semaphore.h>
+#include <yarp/dev/PolyDriver.h>
+#include <yarp/dev/ControlBoardInterfaces.h>
+
+// The wrist joint is shaken along a sinusoidal profile, sampled at
+// the thread rate once and for all: each cycle only reads the
+// encoder and feeds the velocity of the profile forward, correcting
+// for the tracking error.
+/**********************************************************/
+class HandShaker : public yarp::os::RateThread
+{
+protected:
+    yarp::dev::IEncoders        *ienc[2];
+    yarp::dev::IVelocityControl *ivel[2];
+    yarp::dev::IControlMode2    *imod[2];
+
+    yarp::os::Semaphore mutex;
+    std::vector<double> posProfile;
+    std::vector<double> velProfile;
+    double              amplitude;
+    double              frequency;
+    double              t0;
+    int                 hand;
+    int                 joint;
+
+    void generateProfile();
+    void run();
+
+public:
+    HandShaker(const int period);
+    bool configure(yarp::dev::PolyDriver &driverL, yarp::dev::PolyDriver &driverR);
+    void setProfile(const double amplitude, const double frequency);
+    bool startShaking(const std::string &hand, const int joint);
+    void stopShaking();
+    bool isShaking();
+    void threadRelease();
+};
+
+#endif
+
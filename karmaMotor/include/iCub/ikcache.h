@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __IKCACHE_H__
+#define __IKCACHE_H__
+
+#include <string>
+#include <list>
+#include <map>
+
+#include <yarp/os/Semaphore.h>
+#include <yarp/sig/Vector.h>
+
+#include "iCub/ikpool.h"
+
+/**********************************************************/
+class IKCache
+{
+protected:
+    struct Entry
+    {
+        std::string       key;
+        yarp::sig::Vector xdhat;
+        yarp::sig::Vector odhat;
+        yarp::sig::Vector qdhat;
+        bool              ok;
+    };
+
+    // most recently used entries at the front
+    std::list<Entry> entries;
+    std::map<std::string,std::list<Entry>::iterator> index;
+    yarp::os::Semaphore mutex;
+    std::string signature;
+    size_t capacity;
+    int hits,misses;
+
+    void insert(const Entry &entry);
+
+public:
+    IKCache();
+    void setCapacity(const size_t capacity);
+    void setSignature(const std::string &signature);
+    static std::string getKey(const std::string &arm, const yarp::sig::Vector &dof,
+                              const IKQuery &query);
+    bool get(const std::string &arm, const yarp::sig::Vector &dof, IKQuery &query);
+    void put(const std::string &arm, const yarp::sig::Vector &dof, const IKQuery &query);
+    void clear();
+    size_t size();
+    void getStats(int &hits, int &misses);
+    bool load(const std::string &fileName);
+    bool save(const std::string &fileName);
+};
+
+#endif
+
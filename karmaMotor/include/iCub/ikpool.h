@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __IKPOOL_H__
+#define __IKPOOL_H__
+
+#include <string>
+#include <deque>
+
+#include <yarp/os/Thread.h>
+#include <yarp/os/Semaphore.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/dev/CartesianControl.h>
+
+#include <iCub/iKin/iKinFwd.h>
+#include <iCub/iKin/iKinIpOpt.h>
+
+// The linear solvers usually employed by IPOPT (e.g. MUMPS) are not
+// thread-safe: all the in-process solves (pools of both arms and
+// simulators) are serialized, unless the solver is declared safe.
+/**********************************************************/
+class IpoptLock
+{
+public:
+    static void setThreadSafe(const bool threadSafe);
+    static void lock();
+    static void unlock();
+};
+
+
+/**********************************************************/
+struct IKQuery
+{
+    yarp::sig::Vector q0;       // starting joints [deg]; empty for the current ones
+    yarp::sig::Vector xd;       // target position
+    yarp::sig::Vector od;       // target orientation; empty for position-only queries
+    yarp::sig::Vector xdhat;    // reached position
+    yarp::sig::Vector odhat;    // reached orientation
+    yarp::sig::Vector qdhat;    // solution [deg]
+    bool              ok;
+};
+
+
+// The secondary tasks of the cartesian solver, to be accounted for
+// by the local solvers as well, so that both come up with the same
+// solutions (e.g. the elbow height set through "task_2"). Local
+// copies are kept, since they change only where the module sets
+// them, thus saving round-trips to the controller.
+/**********************************************************/
+struct IKTasks
+{
+    int               link2nd;      // end of the 2nd task chain; 0 if disabled
+    yarp::sig::Vector xd_2nd;       // 2nd task target position
+    yarp::sig::Vector w_2nd;        // 2nd task weights
+    yarp::sig::Vector restPos;      // rest posture [deg]
+    yarp::sig::Vector restWeights;  // rest posture weights
+
+    IKTasks() : link2nd(0) { }
+};
+
+
+/**********************************************************/
+class ArmSolver
+{
+protected:
+    iCub::iKin::iCubArm      *arm;
+    iCub::iKin::iKinChain    *chain;
+    iCub::iKin::iKinIpOptMin *slv;
+
+public:
+    ArmSolver(const std::string &type);
+    void setLimits(const yarp::sig::Vector &min, const yarp::sig::Vector &max);
+    void solve(IKQuery &query, const yarp::sig::Vector &dof, const yarp::sig::Vector &q,
+               const IKTasks &tasks, const bool task2);
+    ~ArmSolver();
+};
+
+
+class ArmSolverPool;
+
+/**********************************************************/
+class ArmSolverWorker : public yarp::os::Thread
+{
+protected:
+    ArmSolverPool       *pool;
+    int                  id;
+    yarp::os::Semaphore  go;
+    yarp::os::Semaphore  done;
+
+    void run();
+    void onStop();
+
+public:
+    ArmSolverWorker(ArmSolverPool *pool, const int id);
+    void trigger();
+    void waitDone();
+};
+
+
+/**********************************************************/
+class ArmSolverPool
+{
+protected:
+    std::string type;
+
+    // the solver i is used by the worker i, the first one
+    // by the calling thread
+    std::deque<ArmSolver*>       solvers;
+    std::deque<ArmSolverWorker*> workers;
+
+    // state mirrored from the cartesian controller [deg]
+    yarp::sig::Vector dof;
+    yarp::sig::Vector q;
+    IKTasks           tasks;
+    bool              task2;        // the 2nd task applies to the current batch
+    bool              limitsRead;
+
+    yarp::os::Semaphore   mutexJobs;
+    std::deque<IKQuery>  *jobs;
+    size_t                nextJob;
+
+    friend class ArmSolverWorker;
+
+    void processJobs(const int id);
+
+public:
+    ArmSolverPool();
+    bool configure(const std::string &type, const int nThreads);
+    bool isConfigured() const;
+    bool readLimits(yarp::dev::ICartesianControl *iCartCtrl);
+    void useDefaultLimits();
+    void setState(const yarp::sig::Vector &dof, const yarp::sig::Vector &q);
+    bool readRestPosture(yarp::dev::ICartesianControl *iCartCtrl);
+    void setTask2(const int link, const yarp::sig::Vector &xd, const yarp::sig::Vector &w);
+    bool solve(std::deque<IKQuery> &queries, const bool task2=false);
+    void close();
+    ~ArmSolverPool();
+};
+
+#endif
+
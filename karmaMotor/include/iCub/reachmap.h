@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __REACHMAP_H__
+#define __REACHMAP_H__
+
+#include <stddef.h>
+#include <string>
+#include <deque>
+
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+#define REACHMAP_MAGIC          "KRMAP01"
+#define REACHMAP_MAX_TOOLS      8
+#define REACHMAP_UNKNOWN        255
+#define REACHMAP_MAX_ERROR      254
+
+// The map covers the tool tip poses employed by push and draw: the
+// tip lies on the table plane with its y-axis pointing downward and
+// its z-axis (the approach direction) spanning the heading phi in
+// the x-y plane. Each cell stores the error of the IK solution
+// (position in mm plus orientation in deg) in units of 0.5, for
+// each arm (0 left, 1 right) and tool.
+/**********************************************************/
+struct ReachMapHeader
+{
+    char   magic[8];
+    int    nx,ny,nphi,nTools;
+    double xmin,xmax;
+    double ymin,ymax;
+    double z,dz;
+    double tools[REACHMAP_MAX_TOOLS][7];    // tip and axis-angle wrt the hand
+};
+// followed by unsigned char cells[nTools][2][nphi][ny][nx]
+
+
+/**********************************************************/
+class ReachMap
+{
+protected:
+    ReachMapHeader                header;
+    const unsigned char          *cells;
+    void                         *mem;
+    size_t                        memSize;
+    std::deque<yarp::sig::Matrix> toolFrames;
+
+    bool getIndex(const yarp::sig::Vector &x, int &ix, int &iy) const;
+    int  getPhiIndex(const double phi) const;
+
+public:
+    ReachMap();
+    bool   open(const std::string &fileName);
+    void   close();
+    bool   isOpen() const;
+    int    findTool(const yarp::sig::Matrix &frame) const;
+    double getError(const int arm, const int tool, const yarp::sig::Matrix &Htip) const;
+    double getDexterity(const int arm, const int tool, const yarp::sig::Vector &x,
+                        const double thres) const;
+    ~ReachMap();
+
+    static size_t            getCellIndex(const ReachMapHeader &header, const int tool,
+                                          const int arm, const int iphi, const int iy,
+                                          const int ix);
+    static yarp::sig::Matrix getTipPose(const double x, const double y, const double z,
+                                        const double phi);
+    static bool              getHeading(const yarp::sig::Matrix &Htip, double &phi);
+};
+
+#endif
+
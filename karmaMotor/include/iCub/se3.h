@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __SE3_H__
+#define __SE3_H__
+
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+// Rigid transformation stored on the stack, to be used in place of
+// the 4x4 yarp matrices wherever poses are built in bulk: products
+// and inverses do not allocate, while the conversions to the yarp
+// types take place only when poses are handed to the controllers.
+/**********************************************************/
+class SE3
+{
+public:
+    double R[3][3];     // rotation
+    double p[3];        // translation
+
+    SE3()
+    {
+        for (int i=0; i<3; i++)
+        {
+            for (int j=0; j<3; j++)
+                R[i][j]=(i==j)?1.0:0.0;
+            p[i]=0.0;
+        }
+    }
+
+    SE3(const yarp::sig::Matrix &H);
+
+    void setRotation(const double r00, const double r01, const double r02,
+                     const double r10, const double r11, const double r12,
+                     const double r20, const double r21, const double r22)
+    {
+        R[0][0]=r00; R[0][1]=r01; R[0][2]=r02;
+        R[1][0]=r10; R[1][1]=r11; R[1][2]=r12;
+        R[2][0]=r20; R[2][1]=r21; R[2][2]=r22;
+    }
+
+    void setRotation(const SE3 &H)
+    {
+        for (int i=0; i<3; i++)
+            for (int j=0; j<3; j++)
+                R[i][j]=H.R[i][j];
+    }
+
+    void setTranslation(const double x, const double y, const double z)
+    {
+        p[0]=x; p[1]=y; p[2]=z;
+    }
+
+    SE3 operator*(const SE3 &H) const
+    {
+        SE3 ret;
+        for (int i=0; i<3; i++)
+        {
+            for (int j=0; j<3; j++)
+                ret.R[i][j]=R[i][0]*H.R[0][j]+R[i][1]*H.R[1][j]+R[i][2]*H.R[2][j];
+            ret.p[i]=R[i][0]*H.p[0]+R[i][1]*H.p[1]+R[i][2]*H.p[2]+p[i];
+        }
+
+        return ret;
+    }
+
+    SE3 inverse() const
+    {
+        SE3 ret;
+        for (int i=0; i<3; i++)
+        {
+            for (int j=0; j<3; j++)
+                ret.R[i][j]=R[j][i];
+            ret.p[i]=-(R[0][i]*p[0]+R[1][i]*p[1]+R[2][i]*p[2]);
+        }
+
+        return ret;
+    }
+
+    // same conventions of iCub::ctrl::axis2dcm() and dcm2axis()
+    static SE3 rotation(const double ax, const double ay, const double az,
+                        const double theta);
+    void       getAxis(double *o) const;
+
+    // the outputs are resized only if needed
+    void getPosition(yarp::sig::Vector &x) const;
+    void getAxis(yarp::sig::Vector &o) const;
+
+    yarp::sig::Matrix toMatrix() const;
+};
+
+#endif
+
@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __SIMULATOR_H__
+#define __SIMULATOR_H__
+
+#include <string>
+#include <map>
+
+#include <yarp/os/all.h>
+#include <yarp/sig/all.h>
+#include <yarp/dev/all.h>
+
+#include <iCub/iKin/iKinFwd.h>
+#include <iCub/iKin/iKinIpOpt.h>
+
+// Lightweight kinematic backends that replace the controllers of the
+// robot: motions are tracked ideally along minimum-jerk profiles in
+// joint space, whose durations are multiplied by a time scale (0 for
+// instantaneous motions). Devices are available after calling
+// registerSimDevices() as "karmasimcartesian", "karmasimgaze" and
+// "karmasimcontrolboard".
+
+/**********************************************************/
+class SimCartesianControl : public yarp::dev::DeviceDriver,
+                            public yarp::dev::ICartesianControl
+{
+protected:
+    struct Context
+    {
+        yarp::sig::Vector dof;
+        yarp::sig::Matrix HN;
+        yarp::sig::Vector restPos;
+        yarp::sig::Vector restWeights;
+        double            trajTime;
+        double            inTargetTol;
+        bool              trackingMode;
+        bool              referenceMode;
+        std::string       posePriority;
+    };
+
+    yarp::os::Semaphore        mutex;
+    iCub::iKin::iCubArm       *arm;
+    iCub::iKin::iKinChain     *chain;
+    iCub::iKin::iKinIpOptMin  *slv;
+    std::string                type;
+    double                     timeScale;
+
+    Context                    ctx;
+    std::map<int,Context>      contexts;
+    int                        contextIdCnt;
+
+    yarp::sig::Vector          qStart;
+    yarp::sig::Vector          qTarget;
+    double                     tStart;
+    double                     duration;
+
+    double            getPhase(const double t, double *dphase=NULL) const;
+    yarp::sig::Vector getJoints(const double t) const;
+    yarp::sig::Vector fwdKin(const yarp::sig::Vector &q);
+    void              setDOFOnChain(const yarp::sig::Vector &q);
+    bool              solveIK(const yarp::sig::Vector &q0, const yarp::sig::Vector &xd,
+                              const yarp::sig::Vector *od, yarp::sig::Vector &qd);
+    bool              moveTo(const yarp::sig::Vector &xd, const yarp::sig::Vector *od,
+                             const double t);
+
+public:
+    SimCartesianControl();
+    bool open(yarp::os::Searchable &config);
+    bool close();
+
+    bool setTrackingMode(const bool f);
+    bool getTrackingMode(bool *f);
+    bool setReferenceMode(const bool f);
+    bool getReferenceMode(bool *f);
+    bool setPosePriority(const yarp::os::ConstString &p);
+    bool getPosePriority(yarp::os::ConstString &p);
+    bool getPose(yarp::sig::Vector &x, yarp::sig::Vector &o, yarp::os::Stamp *stamp=NULL);
+    bool getPose(const int axis, yarp::sig::Vector &x, yarp::sig::Vector &o,
+                 yarp::os::Stamp *stamp=NULL);
+    bool goToPose(const yarp::sig::Vector &xd, const yarp::sig::Vector &od, const double t=0.0);
+    bool goToPosition(const yarp::sig::Vector &xd, const double t=0.0);
+    bool goToPoseSync(const yarp::sig::Vector &xd, const yarp::sig::Vector &od, const double t=0.0);
+    bool goToPositionSync(const yarp::sig::Vector &xd, const double t=0.0);
+    bool getDesired(yarp::sig::Vector &xdhat, yarp::sig::Vector &odhat, yarp::sig::Vector &qdhat);
+    bool askForPose(const yarp::sig::Vector &xd, const yarp::sig::Vector &od,
+                    yarp::sig::Vector &xdhat, yarp::sig::Vector &odhat, yarp::sig::Vector &qdhat);
+    bool askForPose(const yarp::sig::Vector &q0, const yarp::sig::Vector &xd,
+                    const yarp::sig::Vector &od, yarp::sig::Vector &xdhat,
+                    yarp::sig::Vector &odhat, yarp::sig::Vector &qdhat);
+    bool askForPosition(const yarp::sig::Vector &xd, yarp::sig::Vector &xdhat,
+                        yarp::sig::Vector &odhat, yarp::sig::Vector &qdhat);
+    bool askForPosition(const yarp::sig::Vector &q0, const yarp::sig::Vector &xd,
+                        yarp::sig::Vector &xdhat, yarp::sig::Vector &odhat,
+                        yarp::sig::Vector &qdhat);
+    bool getDOF(yarp::sig::Vector &curDof);
+    bool setDOF(const yarp::sig::Vector &newDof, yarp::sig::Vector &curDof);
+    bool getRestPos(yarp::sig::Vector &curRestPos);
+    bool setRestPos(const yarp::sig::Vector &newRestPos, yarp::sig::Vector &curRestPos);
+    bool getRestWeights(yarp::sig::Vector &curRestWeights);
+    bool setRestWeights(const yarp::sig::Vector &newRestWeights, yarp::sig::Vector &curRestWeights);
+    bool getLimits(const int axis, double *min, double *max);
+    bool setLimits(const int axis, const double min, const double max);
+    bool getTrajTime(double *t);
+    bool setTrajTime(const double t);
+    bool getInTargetTol(double *tol);
+    bool setInTargetTol(const double tol);
+    bool getJointsVelocities(yarp::sig::Vector &qdot);
+    bool getTaskVelocities(yarp::sig::Vector &xdot, yarp::sig::Vector &odot);
+    bool setTaskVelocities(const yarp::sig::Vector &xdot, const yarp::sig::Vector &odot);
+    bool attachTipFrame(const yarp::sig::Vector &x, const yarp::sig::Vector &o);
+    bool getTipFrame(yarp::sig::Vector &x, yarp::sig::Vector &o);
+    bool removeTipFrame();
+    bool checkMotionDone(bool *f);
+    bool waitMotionDone(const double period=0.1, const double timeout=0.0);
+    bool stopControl();
+    bool storeContext(int *id);
+    bool restoreContext(const int id);
+    bool deleteContext(const int id);
+    bool getInfo(yarp::os::Bottle &info);
+    bool registerEvent(yarp::dev::CartesianEvent &event);
+    bool unregisterEvent(yarp::dev::CartesianEvent &event);
+    bool tweakSet(const yarp::os::Bottle &options);
+    bool tweakGet(yarp::os::Bottle &options);
+};
+
+/**********************************************************/
+class SimGazeControl : public yarp::dev::DeviceDriver,
+                       public yarp::dev::IGazeControl
+{
+protected:
+    struct Context
+    {
+        double neckTrajTime;
+        double eyesTrajTime;
+        double vorGain;
+        double ocrGain;
+        double neckTol;
+        bool   trackingMode;
+        bool   stabilizationMode;
+        bool   saccadesStatus;
+        double saccadesInhibitionPeriod;
+        double saccadesActivationAngle;
+        double neckPitch[2];
+        double neckRoll[2];
+        double neckYaw[2];
+        double blockedVergence;
+    };
+
+    yarp::os::Semaphore     mutex;
+    yarp::sig::Vector       eyeCenter[2];
+    yarp::sig::Matrix       Prj[2];
+    double                  timeScale;
+
+    Context                 ctx;
+    std::map<int,Context>   contexts;
+    int                     contextIdCnt;
+    yarp::os::Bottle        stereoOptions;
+
+    yarp::sig::Vector       fpStart;
+    yarp::sig::Vector       fpTarget;
+    double                  tStart;
+    double                  duration;
+
+    yarp::sig::Vector getFixation(const double t) const;
+    yarp::sig::Matrix getEyeFrame(const int camSel, const double t) const;
+    yarp::sig::Vector getHeadCenter() const;
+    bool              lookAt(const yarp::sig::Vector &fp);
+    bool              getRay(const int camSel, const yarp::sig::Vector &px,
+                             yarp::sig::Vector &c, yarp::sig::Vector &d);
+
+public:
+    SimGazeControl();
+    bool open(yarp::os::Searchable &config);
+    bool close();
+
+    bool setTrackingMode(const bool f);
+    bool getTrackingMode(bool *f);
+    bool setStabilizationMode(const bool f);
+    bool getStabilizationMode(bool *f);
+    bool getFixationPoint(yarp::sig::Vector &fp, yarp::os::Stamp *stamp=NULL);
+    bool getAngles(yarp::sig::Vector &ang, yarp::os::Stamp *stamp=NULL);
+    bool lookAtFixationPoint(const yarp::sig::Vector &fp);
+    bool lookAtAbsAngles(const yarp::sig::Vector &ang);
+    bool lookAtRelAngles(const yarp::sig::Vector &ang);
+    bool lookAtMonoPixel(const int camSel, const yarp::sig::Vector &px, const double z=1.0);
+    bool lookAtMonoPixelWithVergence(const int camSel, const yarp::sig::Vector &px, const double ver);
+    bool lookAtStereoPixels(const yarp::sig::Vector &pxl, const yarp::sig::Vector &pxr);
+    bool lookAtFixationPointSync(const yarp::sig::Vector &fp);
+    bool lookAtAbsAnglesSync(const yarp::sig::Vector &ang);
+    bool lookAtRelAnglesSync(const yarp::sig::Vector &ang);
+    bool lookAtMonoPixelSync(const int camSel, const yarp::sig::Vector &px, const double z=1.0);
+    bool lookAtMonoPixelWithVergenceSync(const int camSel, const yarp::sig::Vector &px, const double ver);
+    bool lookAtStereoPixelsSync(const yarp::sig::Vector &pxl, const yarp::sig::Vector &pxr);
+    bool getNeckTrajTime(double *t);
+    bool getEyesTrajTime(double *t);
+    bool getVORGain(double *gain);
+    bool getOCRGain(double *gain);
+    bool getSaccadesStatus(bool *f);
+    bool getSaccadesInhibitionPeriod(double *period);
+    bool getSaccadesActivationAngle(double *angle);
+    bool getPose(const int type, yarp::sig::Vector &x, yarp::sig::Vector &o, yarp::os::Stamp *stamp=NULL);
+    bool getLeftEyePose(yarp::sig::Vector &x, yarp::sig::Vector &o, yarp::os::Stamp *stamp=NULL);
+    bool getRightEyePose(yarp::sig::Vector &x, yarp::sig::Vector &o, yarp::os::Stamp *stamp=NULL);
+    bool getHeadPose(yarp::sig::Vector &x, yarp::sig::Vector &o, yarp::os::Stamp *stamp=NULL);
+    bool get2DPixel(const int camSel, const yarp::sig::Vector &x, yarp::sig::Vector &px);
+    bool get3DPoint(const int camSel, const yarp::sig::Vector &px, const double depth, yarp::sig::Vector &x);
+    bool get3DPointOnPlane(const int camSel, const yarp::sig::Vector &px, const yarp::sig::Vector &plane,
+                           yarp::sig::Vector &x);
+    bool get3DPointFromAngles(const int mode, const yarp::sig::Vector &ang, yarp::sig::Vector &x);
+    bool getAnglesFrom3DPoint(const yarp::sig::Vector &x, yarp::sig::Vector &ang);
+    bool triangulate3DPoint(const yarp::sig::Vector &pxl, const yarp::sig::Vector &pxr, yarp::sig::Vector &x);
+    bool getJointsDesired(yarp::sig::Vector &qdes);
+    bool getJointsVelocities(yarp::sig::Vector &qdot);
+    bool getStereoOptions(yarp::os::Bottle &options);
+    bool setNeckTrajTime(const double t);
+    bool setEyesTrajTime(const double t);
+    bool setVORGain(const double gain);
+    bool setOCRGain(const double gain);
+    bool setSaccadesStatus(const bool f);
+    bool setSaccadesInhibitionPeriod(const double period);
+    bool setSaccadesActivationAngle(const double angle);
+    bool setStereoOptions(const yarp::os::Bottle &options);
+    bool bindNeckPitch(const double min, const double max);
+    bool blockNeckPitch(const double val);
+    bool blockNeckPitch();
+    bool bindNeckRoll(const double min, const double max);
+    bool blockNeckRoll(const double val);
+    bool blockNeckRoll();
+    bool bindNeckYaw(const double min, const double max);
+    bool blockNeckYaw(const double val);
+    bool blockNeckYaw();
+    bool blockEyes(const double ver);
+    bool blockEyes();
+    bool getNeckPitchRange(double *min, double *max);
+    bool getNeckRollRange(double *min, double *max);
+    bool getNeckYawRange(double *min, double *max);
+    bool getBlockedVergence(double *ver);
+    bool clearNeckPitch();
+    bool clearNeckRoll();
+    bool clearNeckYaw();
+    bool clearEyes();
+    bool getNeckAngleUserTolerance(double *angle);
+    bool setNeckAngleUserTolerance(const double angle);
+    bool checkMotionDone(bool *f);
+    bool waitMotionDone(const double period=0.1, const double timeout=0.0);
+    bool checkSaccadeDone(bool *f);
+    bool waitSaccadeDone(const double period=0.1, const double timeout=0.0);
+    bool stopControl();
+    bool storeContext(int *id);
+    bool restoreContext(const int id);
+    bool deleteContext(const int id);
+    bool getInfo(yarp::os::Bottle &info);
+    bool registerEvent(yarp::dev::GazeEvent &event);
+    bool unregisterEvent(yarp::dev::GazeEvent &event);
+    bool tweakSet(const yarp::os::Bottle &options);
+    bool tweakGet(yarp::os::Bottle &options);
+};
+
+/**********************************************************/
+class SimControlBoard : public yarp::dev::DeviceDriver,
+                        public yarp::dev::IEncoders,
+                        public yarp::dev::IVelocityControl,
+                        public yarp::dev::IControlMode2
+{
+protected:
+    yarp::os::Semaphore mutex;
+    int                 nAxes;
+    yarp::sig::Vector   q;
+    yarp::sig::Vector   qdot;
+    yarp::sig::Vector   acc;
+    yarp::sig::Vector   modes;
+    double              tLast;
+
+    void integrate();
+    bool isValidAxis(const int j) const;
+
+public:
+    SimControlBoard();
+    bool open(yarp::os::Searchable &config);
+    bool close();
+
+    bool getAxes(int *ax);
+    bool resetEncoder(int j);
+    bool resetEncoders();
+    bool setEncoder(int j, double val);
+    bool setEncoders(const double *vals);
+    bool getEncoder(int j, double *v);
+    bool getEncoders(double *encs);
+    bool getEncoderSpeeds(double *spds);
+    bool getEncoderSpeed(int j, double *sp);
+    bool getEncoderAccelerations(double *accs);
+    bool getEncoderAcceleration(int j, double *spds);
+
+    bool setVelocityMode();
+    bool velocityMove(int j, double sp);
+    bool velocityMove(const double *sp);
+    bool setRefAcceleration(int j, double acc);
+    bool setRefAccelerations(const double *accs);
+    bool getRefAcceleration(int j, double *acc);
+    bool getRefAccelerations(double *accs);
+    bool stop(int j);
+    bool stop();
+
+    bool setPositionMode(int j);
+    bool setVelocityMode(int j);
+    bool setTorqueMode(int j);
+    bool setImpedancePositionMode(int j);
+    bool setImpedanceVelocityMode(int j);
+    bool setOpenLoopMode(int j);
+    bool getControlMode(int j, int *mode);
+    bool getControlModes(int *modes);
+    bool getControlModes(const int n_joint, const int *joints, int *modes);
+    bool setControlMode(const int j, const int mode);
+    bool setControlModes(const int n_joint, const int *joints, int *modes);
+    bool setControlModes(int *modes);
+};
+
+/**********************************************************/
+void registerSimDevices();
+
+#endif
+
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include <stdio.h>
+#include <string>
+#include <deque>
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Semaphore.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/dev/CartesianControl.h>
+
+#define TELEMETRY_MAGIC     "KRTLM01"
+
+// Records of the binary log, appended one after the other to the
+// magic string (8 bytes): a header followed by nPhases phases.
+/**********************************************************/
+struct TelemetryHeader
+{
+    int    id;              // id of the submitted action; -1 for direct requests
+    int    nPhases;
+    double tStart;          // absolute time of the request
+    double total;           // duration of the action
+    double errPos;          // final position error [m]; -1 if not measured
+    double errRot;          // final orientation error [rad]; -1 if not measured
+    char   action[8];
+    char   arm[8];
+};
+
+/**********************************************************/
+struct TelemetryPhase
+{
+    char   name[16];
+    double duration;
+    int    done;            // outcome of the wait on the motion
+    int    pad;
+};
+
+
+/**********************************************************/
+class ActionRecord
+{
+protected:
+    struct Phase
+    {
+        std::string name;
+        double      duration;
+        bool        done;
+    };
+
+    int               id;
+    std::string       action;
+    std::string       arm;
+    std::deque<Phase> phases;
+    double            tStart;
+    double            tPhase;
+    std::string       phase;
+    double            errPos;
+    double            errRot;
+
+    friend class Telemetry;
+
+public:
+    ActionRecord(const std::string &action);
+    void setId(const int id)            { this->id=id;   }
+    void setArm(const std::string &arm) { this->arm=arm; }
+    void begin(const std::string &phase);
+    void end(const bool done=true);
+    void add(const std::string &phase, const double duration, const bool done);
+    void measurePoseError(yarp::dev::ICartesianControl *iarm,
+                          const yarp::sig::Vector &xd, const yarp::sig::Vector &od);
+};
+
+
+/**********************************************************/
+class Telemetry
+{
+protected:
+    yarp::os::BufferedPort<yarp::os::Bottle> port;
+    yarp::os::Semaphore                      mutex;
+    FILE                                    *log;
+
+public:
+    Telemetry();
+    bool open(const std::string &portName, const std::string &logFile="");
+    void close();
+    void publish(const ActionRecord &record);
+    ~Telemetry();
+};
+
+#endif
+
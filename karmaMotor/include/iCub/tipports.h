@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __TIPPORTS_H__
+#define __TIPPORTS_H__
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Semaphore.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/dev/GazeControl.h>
+
+// The detections of the tool tip drive the gaze as soon as they
+// arrive; the gaze is deemed settled once the mean detection over
+// a time window gets close enough to the center of the image.
+/**********************************************************/
+class TipTrackerPort : public yarp::os::BufferedPort<yarp::os::Bottle>
+{
+protected:
+    yarp::dev::IGazeControl *iGaze;
+    yarp::os::Semaphore      mutex;
+    yarp::os::Semaphore      settled;
+    yarp::sig::Vector        pxCum;
+    bool                     tracking;
+    int                      camSel;
+    int                      cnt;
+    double                   t0;
+
+    void onRead(yarp::os::Bottle &target);
+
+public:
+    TipTrackerPort();
+    void track(yarp::dev::IGazeControl *iGaze, const int camSel);
+    void stopTracking();
+    bool waitSettled(const double timeout);
+};
+
+
+// The finder pushes the number of acquired items through its
+// status port, which is waited for here.
+/**********************************************************/
+class FinderStatusPort : public yarp::os::BufferedPort<yarp::os::Bottle>
+{
+protected:
+    yarp::os::Semaphore mutex;
+    yarp::os::Semaphore reached;
+    int                 num;
+    int                 target;
+
+    void onRead(yarp::os::Bottle &status);
+
+public:
+    FinderStatusPort();
+    void setTarget(const int target);
+    bool waitTarget(const double timeout);
+};
+
+#endif
+
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <stdio.h>
+#include <algorithm>
+
+#include <yarp/os/Time.h>
+
+#include "iCub/actionexec.h"
+
+// period of the fallback polling when the controller does not
+// deliver motion events
+#define ACTIONEXEC_POLLING_PERIOD   0.01
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::dev;
+
+
+/**********************************************************/
+ActionExecutor::ActionExecutor(ICartesianControl *iarm, const bool *interrupt) :
+                               iarm(iarm), interrupt(interrupt), record(NULL), completed(0),
+                               sem(0), mutexEvents(1), armed(false), tArmed(0.0),
+                               doneEvent(*this)
+{
+    doneEvent.cartesianEventParameters.type="motion-done";
+    useEvents=iarm->registerEvent(doneEvent);
+}
+/**********************************************************/
+void ActionExecutor::clear()
+{
+    segments.clear();
+    timings.clear();
+    completed=0;
+}
+/**********************************************************/
+void ActionExecutor::add(const string &name, const Vector &xd, const Vector &od,
+                         const double trajTime, const double timeout,
+                         const double blend)
+{
+    ActionSegment segment;
+    segment.name=name;
+    segment.xd=xd;
+    segment.od=od;
+    segment.trajTime=trajTime;
+    segment.timeout=timeout;
+    segment.blend=std::max(std::min(blend,1.0),0.0);
+    segments.push_back(segment);
+}
+/**********************************************************/
+void ActionExecutor::armEvents(const bool sw)
+{
+    mutexEvents.wait();
+    armed=sw;
+    tArmed=Time::now();
+    while (sem.check());
+    mutexEvents.post();
+}
+/**********************************************************/
+void ActionExecutor::onEvent(const double t)
+{
+    // the events generated before the current segment was issued,
+    // e.g. a late motion-done of a segment that timed out, belong
+    // to the previous segments and are discarded
+    mutexEvents.wait();
+    if (armed && (t>=tArmed))
+        sem.post();
+    mutexEvents.post();
+}
+/**********************************************************/
+bool ActionExecutor::isInterrupted() const
+{
+    return ((interrupt!=NULL) && *interrupt);
+}
+/**********************************************************/
+bool ActionExecutor::waitEvent(const ActionSegment &segment, const double t0)
+{
+    double timeout=std::max(segment.timeout,segment.trajTime);
+    if (segment.blend<1.0)
+    {
+        // via-point: the next segment is issued while this
+        // motion is still ongoing
+        MotionEvent ongoingEvent(*this);
+        ongoingEvent.cartesianEventParameters.type="motion-ongoing";
+        ongoingEvent.cartesianEventParameters.motionOngoingCheckPoint=segment.blend;
+        if (iarm->registerEvent(ongoingEvent))
+        {
+            bool ok=false;
+            while (!isInterrupted() && !ok && (Time::now()-t0<timeout))
+                ok=sem.waitWithTimeout(ACTIONEXEC_POLLING_PERIOD*10.0);
+            iarm->unregisterEvent(ongoingEvent);
+            return ok;
+        }
+
+        // the check point is not available: rely on the
+        // minimum-jerk timing
+        while (!isInterrupted() && (Time::now()-t0<segment.blend*segment.trajTime))
+            Time::delay(ACTIONEXEC_POLLING_PERIOD);
+        return !isInterrupted();
+    }
+
+    bool done=false;
+    while (!isInterrupted() && !done && (Time::now()-t0<timeout))
+        done=sem.waitWithTimeout(ACTIONEXEC_POLLING_PERIOD*10.0);
+
+    return done;
+}
+/**********************************************************/
+bool ActionExecutor::waitPolling(const ActionSegment &segment, const double t0)
+{
+    double timeout=std::max(segment.timeout,segment.trajTime);
+    if (segment.blend<1.0)
+    {
+        while (!isInterrupted() && (Time::now()-t0<segment.blend*segment.trajTime))
+            Time::delay(ACTIONEXEC_POLLING_PERIOD);
+        return !isInterrupted();
+    }
+
+    bool done=false;
+    while (!isInterrupted() && !done && (Time::now()-t0<timeout))
+    {
+        Time::delay(ACTIONEXEC_POLLING_PERIOD);
+        iarm->checkMotionDone(&done);
+    }
+
+    return done;
+}
+/**********************************************************/
+bool ActionExecutor::wait(const ActionSegment &segment, const double t0)
+{
+    return (useEvents?waitEvent(segment,t0):waitPolling(segment,t0));
+}
+/**********************************************************/
+bool ActionExecutor::execute()
+{
+    timings.clear();
+    completed=0;
+    double tStart=Time::now();
+    bool ok=true;
+
+    for (size_t i=0; i<segments.size(); i++)
+    {
+        if (isInterrupted())
+        {
+            ok=false;
+            break;
+        }
+
+        const ActionSegment &segment=segments[i];
+        printf("moving to: x=(%s); o=(%s)\n",segment.xd.toString(3,3).c_str(),
+               segment.od.toString(3,3).c_str());
+
+        // no event is accepted while the segment is being issued;
+        // afterwards, only those generated for the new motion
+        armEvents(false);
+        double t0=Time::now();
+        iarm->goToPoseSync(segment.xd,segment.od,segment.trajTime);
+        armEvents(true);
+
+        bool reached=wait(segment,t0);
+        double dt=Time::now()-t0;
+
+        Bottle &timing=timings.addList();
+        timing.addString(segment.name.c_str());
+        timing.addDouble(dt);
+        if (record!=NULL)
+            record->add(segment.name,dt,reached);
+        if (!reached)
+        {
+            printf("%s: motion not completed within %g [s]\n",segment.name.c_str(),dt);
+            ok=false;
+        }
+
+        // a segment is carried out, even if late, unless interrupted
+        if (reached || !isInterrupted())
+            completed++;
+    }
+
+    if ((record!=NULL) && (segments.size()>0))
+        record->measurePoseError(iarm,segments.back().xd,segments.back().od);
+
+    Bottle &timing=timings.addList();
+    timing.addString("total");
+    timing.addDouble(Time::now()-tStart);
+    printf("phase timings: %s\n",timings.toString().c_str());
+
+    return ok;
+}
+/**********************************************************/
+ActionExecutor::~ActionExecutor()
+{
+    if (useEvents)
+        iarm->unregisterEvent(doneEvent);
+}
+
@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <stdio.h>
+
+#include <yarp/os/Time.h>
+
+#include "iCub/actionqueue.h"
+
+// number of completed actions whose status can still be polled
+#define ACTIONQUEUE_HISTORY     100
+
+using namespace std;
+using namespace yarp::os;
+
+
+/**********************************************************/
+ActionQueue::ActionQueue(ActionHandler &handler, BufferedPort<Bottle> &eventPort,
+                         const deque<string> &laneNames) :
+                         handler(handler), eventPort(eventPort), nextId(0)
+{
+    for (size_t i=0; i<laneNames.size(); i++)
+        lanes.push_back(new Lane(*this,(int)i,laneNames[i]));
+}
+/**********************************************************/
+int ActionQueue::getLane(const string &name) const
+{
+    for (size_t i=0; i<lanes.size(); i++)
+        if (lanes[i]->name==name)
+            return (int)i;
+
+    return -1;
+}
+/**********************************************************/
+int ActionQueue::submit(const Bottle &command, const int lane)
+{
+    if ((lane<0) || (lane>=(int)lanes.size()))
+        return -1;
+
+    Action action;
+    action.lane=lane;
+    action.command=command;
+    action.status="queued";
+    action.tSubmit=Time::now();
+    action.tStart=action.tEnd=0.0;
+
+    mutex.wait();
+    action.id=nextId++;
+    lanes[lane]->queued.push_back(action);
+    mutex.post();
+
+    publish(action);
+    lanes[lane]->pending.post();
+
+    return action.id;
+}
+/**********************************************************/
+void ActionQueue::fill(const Action &action, Bottle &info) const
+{
+    info.addString(action.status.c_str());
+    if (action.status=="queued")
+        info.addDouble(Time::now()-action.tSubmit);
+    else if (action.status=="running")
+        info.addDouble(Time::now()-action.tStart);
+    else
+    {
+        info.addDouble(action.tEnd-action.tStart);
+        info.addList()=action.reply;
+    }
+}
+/**********************************************************/
+bool ActionQueue::status(const int id, Bottle &info)
+{
+    bool found=false;
+
+    mutex.wait();
+    for (size_t l=0; !found && (l<lanes.size()); l++)
+    {
+        Lane &lane=*lanes[l];
+        if (lane.isBusy && (lane.running.id==id))
+        {
+            fill(lane.running,info);
+            found=true;
+        }
+
+        for (size_t i=0; !found && (i<lane.queued.size()); i++)
+        {
+            if (lane.queued[i].id==id)
+            {
+                fill(lane.queued[i],info);
+                info.addInt((int)i);    // position in the lane
+                found=true;
+            }
+        }
+    }
+
+    for (size_t i=0; !found && (i<finished.size()); i++)
+    {
+        if (finished[i].id==id)
+        {
+            fill(finished[i],info);
+            found=true;
+        }
+    }
+    mutex.post();
+
+    return found;
+}
+/**********************************************************/
+bool ActionQueue::cancel(const int id)
+{
+    mutex.wait();
+    for (size_t l=0; l<lanes.size(); l++)
+    {
+        Lane &lane=*lanes[l];
+        if (lane.isBusy && (lane.running.id==id))
+        {
+            // the handler is interrupted outside the lock
+            // as it may take a while
+            lane.cancelRequested=true;
+            mutex.post();
+
+            handler.abort(lane.control);
+            return true;
+        }
+
+        for (deque<Action>::iterator it=lane.queued.begin(); it!=lane.queued.end(); it++)
+        {
+            if (it->id==id)
+            {
+                Action action=*it;
+                lane.queued.erase(it);
+
+                action.status="cancelled";
+                action.tStart=action.tEnd=Time::now();
+                archive(action);
+                mutex.post();
+
+                publish(action);
+                return true;
+            }
+        }
+    }
+    mutex.post();
+
+    return false;
+}
+/**********************************************************/
+void ActionQueue::archive(const Action &action)
+{
+    finished.push_back(action);
+    while (finished.size()>ACTIONQUEUE_HISTORY)
+        finished.pop_front();
+}
+/**********************************************************/
+void ActionQueue::publish(const Action &action)
+{
+    mutexEvents.wait();
+    Bottle &event=eventPort.prepare();
+    event.clear();
+    event.addInt(action.id);
+    event.addString(action.status.c_str());
+    if ((action.status!="queued") && (action.status!="running"))
+        event.addList()=action.reply;
+
+    eventPort.writeStrict();
+    mutexEvents.post();
+}
+/**********************************************************/
+void ActionQueue::serve(Lane &lane)
+{
+    while (!lane.isStopping())
+    {
+        lane.pending.wait();
+        if (lane.isStopping())
+            break;
+
+        // the lane may be empty due to cancelled actions
+        mutex.wait();
+        if (lane.queued.empty())
+        {
+            mutex.post();
+            continue;
+        }
+
+        lane.running=lane.queued.front();
+        lane.queued.pop_front();
+        lane.running.status="running";
+        lane.running.tStart=Time::now();
+        lane.isBusy=true;
+        lane.cancelRequested=false;
+        lane.control.id=lane.running.id;
+        lane.control.interrupt=false;
+        lane.control.blocking=-1;
+        Action action=lane.running;
+        mutex.post();
+
+        publish(action);
+
+        Bottle reply;
+        bool ok=handler.execute(action.command,reply,lane.name,lane.control);
+
+        mutex.wait();
+        action.reply=reply;
+        action.tEnd=Time::now();
+        if (lane.cancelRequested)
+            action.status="cancelled";
+        else
+            action.status=(ok?"done":"failed");
+        lane.isBusy=false;
+        archive(action);
+        mutex.post();
+
+        printf("action #%d (%s) %s in %.3f [s]\n",action.id,lane.name.c_str(),
+               action.status.c_str(),action.tEnd-action.tStart);
+        publish(action);
+    }
+}
+/**********************************************************/
+void ActionQueue::start()
+{
+    for (size_t i=0; i<lanes.size(); i++)
+        lanes[i]->start();
+}
+/**********************************************************/
+void ActionQueue::stop()
+{
+    for (size_t i=0; i<lanes.size(); i++)
+        lanes[i]->stop();
+}
+/**********************************************************/
+ActionQueue::~ActionQueue()
+{
+    for (size_t i=0; i<lanes.size(); i++)
+        delete lanes[i];
+}
+
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <cstdio>
+#include <algorithm>
+
+#include <yarp/os/Time.h>
+
+#include "iCub/armarbiter.h"
+
+#define ARMARBITER_PERIOD   0.01
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::dev;
+
+
+/**********************************************************/
+ArmArbiter::ArmArbiter() : margin(0.1), idleTimeout(10.0)
+{
+    for (int i=0; i<2; i++)
+    {
+        reservations[i].busy=false;
+        reservations[i].owner=NULL;
+        reservations[i].region=false;
+        arms[i]=NULL;
+    }
+}
+/**********************************************************/
+void ArmArbiter::setMargin(const double margin)
+{
+    this->margin=std::max(margin,0.0);
+}
+/**********************************************************/
+void ArmArbiter::setIdleTimeout(const double timeout)
+{
+    idleTimeout=timeout;
+}
+/**********************************************************/
+void ArmArbiter::setArms(ICartesianControl *left, ICartesianControl *right)
+{
+    arms[0]=left;
+    arms[1]=right;
+}
+/**********************************************************/
+bool ArmArbiter::getHand(const int arm, Vector &x) const
+{
+    Vector o;
+    return ((arms[arm]!=NULL) && arms[arm]->getPose(x,o));
+}
+/**********************************************************/
+bool ArmArbiter::overlap(const Reservation &r1, const Reservation &r2) const
+{
+    if (!r1.region || !r2.region)
+        return false;
+
+    return ((r1.xmin<=r2.xmax) && (r2.xmin<=r1.xmax) &&
+            (r1.ymin<=r2.ymax) && (r2.ymin<=r1.ymax));
+}
+/**********************************************************/
+bool ArmArbiter::isInterrupted(const bool *interrupt) const
+{
+    return ((interrupt!=NULL) && *interrupt);
+}
+/**********************************************************/
+bool ArmArbiter::acquire(const int arm, const bool *interrupt)
+{
+    while (!isInterrupted(interrupt))
+    {
+        mutex.wait();
+        if (!reservations[arm].busy)
+        {
+            // the region around the hand is kept
+            // until the new one is reserved
+            reservations[arm].busy=true;
+            reservations[arm].owner=interrupt;
+            mutex.post();
+            return true;
+        }
+        mutex.post();
+
+        Time::delay(ARMARBITER_PERIOD);
+    }
+
+    return false;
+}
+/**********************************************************/
+bool ArmArbiter::reserve(const int arm, const deque<Vector> &points,
+                         const bool *interrupt, int *blocking)
+{
+    if (points.size()==0)
+        return true;
+
+    Reservation r;
+    r.busy=r.region=true;
+    r.owner=interrupt;
+    r.xmin=r.xmax=points[0][0];
+    r.ymin=r.ymax=points[0][1];
+    for (size_t i=1; i<points.size(); i++)
+    {
+        r.xmin=std::min(r.xmin,points[i][0]); r.xmax=std::max(r.xmax,points[i][0]);
+        r.ymin=std::min(r.ymin,points[i][1]); r.ymax=std::max(r.ymax,points[i][1]);
+    }
+    r.xmin-=margin; r.xmax+=margin;
+    r.ymin-=margin; r.ymax+=margin;
+
+    // the reservation of the other arm is kept as long as its
+    // action is running, or as long as its idle hand is still
+    // within the region, which is waited for up to the timeout
+    const char *otherName=(arm==0)?"right":"left";
+    double tIdle=-1.0;
+    while (!isInterrupted(interrupt))
+    {
+        Vector x;
+        bool hand=getHand(1-arm,x);
+
+        mutex.wait();
+        Reservation &other=reservations[1-arm];
+        if (!other.busy && other.region && hand)
+        {
+            if ((x[0]<other.xmin) || (x[0]>other.xmax) ||
+                (x[1]<other.ymin) || (x[1]>other.ymax))
+                other.region=false;
+        }
+
+        if (!overlap(r,other))
+        {
+            reservations[arm]=r;
+            mutex.post();
+            return true;
+        }
+
+        bool idle=!other.busy;
+        mutex.post();
+
+        if (!idle)
+            tIdle=-1.0;
+        else if (tIdle<0.0)
+        {
+            printf("waiting for the idle %s hand to leave the workspace\n",otherName);
+            tIdle=Time::now();
+        }
+        else if ((idleTimeout>0.0) && (Time::now()-tIdle>idleTimeout))
+        {
+            printf("the idle %s hand is blocking the workspace: reservation failed\n",otherName);
+            if (blocking!=NULL)
+                *blocking=1-arm;
+            return false;
+        }
+
+        Time::delay(ARMARBITER_PERIOD);
+    }
+
+    return false;
+}
+/**********************************************************/
+bool ArmArbiter::acquireAll(const bool *interrupt)
+{
+    // both arms at once, so as not to hold one while
+    // waiting for the other
+    while (!isInterrupted(interrupt))
+    {
+        mutex.wait();
+        if (!reservations[0].busy && !reservations[1].busy)
+        {
+            for (int i=0; i<2; i++)
+            {
+                reservations[i].busy=true;
+                reservations[i].owner=interrupt;
+            }
+            mutex.post();
+            return true;
+        }
+        mutex.post();
+
+        Time::delay(ARMARBITER_PERIOD);
+    }
+
+    return false;
+}
+/**********************************************************/
+bool ArmArbiter::isOwner(const int arm, const bool *interrupt)
+{
+    mutex.wait();
+    bool ret=reservations[arm].busy && (reservations[arm].owner==interrupt);
+    mutex.post();
+
+    return ret;
+}
+/**********************************************************/
+void ArmArbiter::release(const int arm, const bool moved)
+{
+    // the hand is left where the action has brought it;
+    // if not moved, the previous region is kept as it is
+    Vector x;
+    bool hand=moved && getHand(arm,x);
+
+    mutex.wait();
+    Reservation &r=reservations[arm];
+    r.busy=false;
+    r.owner=NULL;
+    if (moved)
+        r.region=hand;
+    if (hand)
+    {
+        r.xmin=x[0]-margin; r.xmax=x[0]+margin;
+        r.ymin=x[1]-margin; r.ymax=x[1]+margin;
+    }
+    mutex.post();
+}
+/**********************************************************/
+void ArmArbiter::releaseAll()
+{
+    release(0);
+    release(1);
+}
+
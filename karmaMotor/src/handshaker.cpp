@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <math.h>
+#include <algorithm>
+
+#include <yarp/os/Time.h>
+
+#include "iCub/handshaker.h"
+
+// gain of the correction on the position error [1/s]
+#define HANDSHAKER_GAIN     10.0
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+
+
+/**********************************************************/
+HandShaker::HandShaker(const int period) : RateThread(period),
+                                           amplitude(6.0), frequency(3.0),
+                                           t0(0.0), hand(-1), joint(4)
+{
+    for (int i=0; i<2; i++)
+    {
+        ienc[i]=NULL;
+        ivel[i]=NULL;
+        imod[i]=NULL;
+    }
+}
+/**********************************************************/
+bool HandShaker::configure(PolyDriver &driverL, PolyDriver &driverR)
+{
+    // the interfaces are retrieved once and for all
+    PolyDriver *drivers[2]={&driverL,&driverR};
+    for (int i=0; i<2; i++)
+    {
+        if (!drivers[i]->view(ienc[i]) || !drivers[i]->view(ivel[i]) ||
+            !drivers[i]->view(imod[i]))
+            return false;
+    }
+
+    generateProfile();
+    return true;
+}
+/**********************************************************/
+void HandShaker::setProfile(const double amplitude, const double frequency)
+{
+    mutex.wait();
+    this->amplitude=fabs(amplitude);
+    this->frequency=std::max(fabs(frequency),0.1);
+    generateProfile();
+    mutex.post();
+}
+/**********************************************************/
+void HandShaker::generateProfile()
+{
+    // one period of oscillation centered in the joint zero,
+    // sampled at the thread rate
+    double Ts=getRate()/1000.0;
+    int n=std::max((int)floor(1.0/(frequency*Ts)+0.5),2);
+    double omega=2.0*M_PI*frequency;
+
+    posProfile.resize(n);
+    velProfile.resize(n);
+    for (int k=0; k<n; k++)
+    {
+        double phase=2.0*M_PI*k/n;
+        posProfile[k]=amplitude*sin(phase);
+        velProfile[k]=omega*amplitude*cos(phase);
+    }
+}
+/**********************************************************/
+bool HandShaker::startShaking(const string &hand, const int joint)
+{
+    int i=(hand=="left")?0:1;
+    if (imod[i]==NULL)
+        return false;
+
+    mutex.wait();
+    imod[i]->setControlMode(joint,VOCAB_CM_VELOCITY);
+    this->hand=i;
+    this->joint=joint;
+    t0=Time::now();
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+void HandShaker::stopShaking()
+{
+    mutex.wait();
+    if (hand>=0)
+    {
+        ivel[hand]->stop(joint);
+        hand=-1;
+    }
+    mutex.post();
+}
+/**********************************************************/
+bool HandShaker::isShaking()
+{
+    mutex.wait();
+    bool ret=(hand>=0);
+    mutex.post();
+
+    return ret;
+}
+/**********************************************************/
+void HandShaker::run()
+{
+    mutex.wait();
+    if (hand>=0)
+    {
+        // the sample is picked by the elapsed time, so that
+        // the profile does not stretch out with the jitter
+        double Ts=getRate()/1000.0;
+        size_t k=(size_t)floor((Time::now()-t0)/Ts)%posProfile.size();
+
+        double pos;
+        if (ienc[hand]->getEncoder(joint,&pos))
+        {
+            double vel=velProfile[k]+HANDSHAKER_GAIN*(posProfile[k]-pos);
+            ivel[hand]->velocityMove(joint,vel);
+        }
+    }
+    mutex.post();
+}
+/**********************************************************/
+void HandShaker::threadRelease()
+{
+    stopShaking();
+}
+
@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <stdio.h>
+#include <math.h>
+#include <sstream>
+
+#include <yarp/os/Bottle.h>
+
+#include "iCub/ikcache.h"
+
+// quantization of the keys: 1 mm on the position, about 0.3 deg
+// on the orientation and 0.5 deg on the starting joints
+#define IKCACHE_RES_POS     0.001
+#define IKCACHE_RES_ROT     0.005
+#define IKCACHE_RES_JOINT   0.5
+#define IKCACHE_VERSION     2
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+
+
+/**********************************************************/
+static int quantize(const double val, const double res)
+{
+    return (int)floor(val/res+0.5);
+}
+/**********************************************************/
+IKCache::IKCache() : capacity(10000), hits(0), misses(0)
+{
+}
+/**********************************************************/
+void IKCache::setCapacity(const size_t capacity)
+{
+    mutex.wait();
+    this->capacity=capacity;
+    while (entries.size()>capacity)
+    {
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+    mutex.post();
+}
+/**********************************************************/
+void IKCache::setSignature(const string &signature)
+{
+    // the solutions depend on the solver and its settings (e.g. the
+    // kinematics and the elbow task), which are thus stored in the
+    // header of the file: caches produced otherwise get discarded
+    mutex.wait();
+    this->signature=signature;
+    mutex.post();
+}
+/**********************************************************/
+string IKCache::getKey(const string &arm, const Vector &dof, const IKQuery &query)
+{
+    // the tool frame is already folded into the hand target
+    ostringstream str;
+    str<<arm<<"|";
+    for (size_t i=0; i<dof.length(); i++)
+        str<<((dof[i]>0.0)?"1":"0");
+
+    str<<"|";
+    for (size_t i=0; i<query.xd.length(); i++)
+        str<<quantize(query.xd[i],IKCACHE_RES_POS)<<",";
+
+    // axis-angle folded into the rotation vector to get rid of
+    // the sign ambiguity
+    str<<"|";
+    if (query.od.length()>=4)
+        for (int i=0; i<3; i++)
+            str<<quantize(query.od[i]*query.od[3],IKCACHE_RES_ROT)<<",";
+
+    str<<"|";
+    for (size_t i=0; i<query.q0.length(); i++)
+        str<<quantize(query.q0[i],IKCACHE_RES_JOINT)<<",";
+
+    return str.str();
+}
+/**********************************************************/
+void IKCache::insert(const Entry &entry)
+{
+    map<string,list<Entry>::iterator>::iterator it=index.find(entry.key);
+    if (it!=index.end())
+    {
+        entries.erase(it->second);
+        index.erase(it);
+    }
+
+    if (capacity==0)
+        return;
+
+    entries.push_front(entry);
+    index[entry.key]=entries.begin();
+
+    while (entries.size()>capacity)
+    {
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
+/**********************************************************/
+bool IKCache::get(const string &arm, const Vector &dof, IKQuery &query)
+{
+    string key=getKey(arm,dof,query);
+
+    mutex.wait();
+    map<string,list<Entry>::iterator>::iterator it=index.find(key);
+    bool found=(it!=index.end());
+    if (found)
+    {
+        // move to the front
+        entries.splice(entries.begin(),entries,it->second);
+        const Entry &entry=entries.front();
+        query.xdhat=entry.xdhat;
+        query.odhat=entry.odhat;
+        query.qdhat=entry.qdhat;
+        query.ok=entry.ok;
+        hits++;
+    }
+    else
+        misses++;
+    mutex.post();
+
+    return found;
+}
+/**********************************************************/
+void IKCache::put(const string &arm, const Vector &dof, const IKQuery &query)
+{
+    Entry entry;
+    entry.key=getKey(arm,dof,query);
+    entry.xdhat=query.xdhat;
+    entry.odhat=query.odhat;
+    entry.qdhat=query.qdhat;
+    entry.ok=query.ok;
+
+    mutex.wait();
+    insert(entry);
+    mutex.post();
+}
+/**********************************************************/
+void IKCache::clear()
+{
+    mutex.wait();
+    entries.clear();
+    index.clear();
+    hits=misses=0;
+    mutex.post();
+}
+/**********************************************************/
+size_t IKCache::size()
+{
+    mutex.wait();
+    size_t ret=entries.size();
+    mutex.post();
+
+    return ret;
+}
+/**********************************************************/
+void IKCache::getStats(int &hits, int &misses)
+{
+    mutex.wait();
+    hits=this->hits;
+    misses=this->misses;
+    mutex.post();
+}
+/**********************************************************/
+bool IKCache::load(const string &fileName)
+{
+    FILE *fin=fopen(fileName.c_str(),"r");
+    if (fin==NULL)
+        return false;
+
+    char line[4096];
+    bool ok=false;
+    if (fgets(line,sizeof(line),fin)!=NULL)
+    {
+        Bottle header(line);
+        ok=(header.get(0).asString()=="ikcache") &&
+           (header.get(1).asInt()==IKCACHE_VERSION);
+        if (ok && (header.get(2).asString().c_str()!=signature))
+        {
+            printf("cached poses obtained with \"%s\" rather than \"%s\": discarded\n",
+                   header.get(2).asString().c_str(),signature.c_str());
+            ok=false;
+        }
+    }
+
+    mutex.wait();
+    // entries are stored from the least recently used on
+    while (ok && (fgets(line,sizeof(line),fin)!=NULL))
+    {
+        Bottle b(line);
+        if (b.size()<5)
+            continue;
+
+        Entry entry;
+        entry.key=b.get(0).asString().c_str();
+        entry.ok=(b.get(1).asInt()!=0);
+
+        Vector *v[3]={&entry.xdhat,&entry.odhat,&entry.qdhat};
+        for (int i=0; i<3; i++)
+        {
+            if (Bottle *pB=b.get(2+i).asList())
+            {
+                v[i]->resize(pB->size());
+                for (int j=0; j<pB->size(); j++)
+                    (*v[i])[j]=pB->get(j).asDouble();
+            }
+        }
+
+        insert(entry);
+    }
+    mutex.post();
+
+    fclose(fin);
+    return ok;
+}
+/**********************************************************/
+bool IKCache::save(const string &fileName)
+{
+    FILE *fout=fopen(fileName.c_str(),"w");
+    if (fout==NULL)
+        return false;
+
+    mutex.wait();
+    Bottle header;
+    header.addString("ikcache");
+    header.addInt(IKCACHE_VERSION);
+    header.addString(signature.c_str());
+    fprintf(fout,"%s\n",header.toString().c_str());
+
+    for (list<Entry>::reverse_iterator it=entries.rbegin(); it!=entries.rend(); it++)
+    {
+        Bottle b;
+        b.addString(it->key.c_str());
+        b.addInt(it->ok?1:0);
+
+        const Vector *v[3]={&it->xdhat,&it->odhat,&it->qdhat};
+        for (int i=0; i<3; i++)
+        {
+            Bottle &part=b.addList();
+            for (size_t j=0; j<v[i]->length(); j++)
+                part.addDouble((*v[i])[j]);
+        }
+
+        fprintf(fout,"%s\n",b.toString().c_str());
+    }
+    mutex.post();
+
+    fclose(fout);
+    return true;
+}
+
@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <algorithm>
+
+#include <yarp/os/Bottle.h>
+#include <yarp/math/Math.h>
+
+#include <iCub/ctrl/math.h>
+
+#include "iCub/ikpool.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::ctrl;
+using namespace iCub::iKin;
+
+
+static Semaphore ipoptMutex;
+static bool      ipoptThreadSafe=false;
+
+/**********************************************************/
+void IpoptLock::setThreadSafe(const bool threadSafe)
+{
+    ipoptThreadSafe=threadSafe;
+}
+/**********************************************************/
+void IpoptLock::lock()
+{
+    if (!ipoptThreadSafe)
+        ipoptMutex.wait();
+}
+/**********************************************************/
+void IpoptLock::unlock()
+{
+    if (!ipoptThreadSafe)
+        ipoptMutex.post();
+}
+/**********************************************************/
+ArmSolver::ArmSolver(const string &type)
+{
+    arm=new iCubArm(type);
+    chain=arm->asChain();
+    slv=new iKinIpOptMin(*chain,IKINCTRL_POSE_FULL,1e-3,1e-6,100);
+}
+/**********************************************************/
+void ArmSolver::setLimits(const Vector &min, const Vector &max)
+{
+    size_t len=std::min(std::min(min.length(),max.length()),(size_t)chain->getN());
+    for (size_t i=0; i<len; i++)
+    {
+        (*chain)[i].setMin(CTRL_DEG2RAD*min[i]);
+        (*chain)[i].setMax(CTRL_DEG2RAD*max[i]);
+    }
+}
+/**********************************************************/
+void ArmSolver::solve(IKQuery &query, const Vector &dof, const Vector &q,
+                      const IKTasks &tasks, const bool task2)
+{
+    unsigned int N=chain->getN();
+    query.ok=false;
+    if ((query.xd.length()<3) || (dof.length()<N) || (q.length()<N))
+        return;
+
+    Vector q0=(query.q0.length()>=N)?query.q0.subVector(0,N-1):q.subVector(0,N-1);
+    q0=CTRL_DEG2RAD*q0;
+
+    // the joints not enabled stay where they are
+    Vector qdof;
+    for (unsigned int i=0; i<N; i++)
+    {
+        chain->releaseLink(i);
+        if (dof[i]>0.0)
+            qdof.push_back(q0[i]);
+        else
+            chain->blockLink(i,q0[i]);
+    }
+    chain->setAng(qdof);
+
+    Vector xd=query.xd.subVector(0,2);
+    if (query.od.length()>=4)
+    {
+        for (int i=0; i<4; i++)
+            xd.push_back(query.od[i]);
+        slv->set_ctrlPose(IKINCTRL_POSE_FULL);
+    }
+    else
+        slv->set_ctrlPose(IKINCTRL_POSE_XYZ);
+
+    // secondary tasks as in the cartesian solver
+    double weight2nd=0.0;
+    Vector xd_2nd(3,0.0),w_2nd(3,0.0);
+    if (task2 && (tasks.link2nd>0) && (tasks.xd_2nd.length()>=3) && (tasks.w_2nd.length()>=3))
+    {
+        slv->specify2ndTaskEndEff(tasks.link2nd);
+        xd_2nd=tasks.xd_2nd.subVector(0,2);
+        w_2nd=tasks.w_2nd.subVector(0,2);
+        weight2nd=1.0;
+    }
+
+    double weight3rd=0.0;
+    Vector qd_3rd,w_3rd;
+    for (unsigned int i=0; i<N; i++)
+    {
+        if (dof[i]>0.0)
+        {
+            qd_3rd.push_back((tasks.restPos.length()>i)?CTRL_DEG2RAD*tasks.restPos[i]:0.0);
+            w_3rd.push_back((tasks.restWeights.length()>i)?tasks.restWeights[i]:0.0);
+        }
+    }
+    if (norm(w_3rd)>0.0)
+        weight3rd=1.0;
+
+    IpoptLock::lock();
+    qdof=slv->solve(chain->getAng(),xd,weight2nd,xd_2nd,w_2nd,
+                    weight3rd,qd_3rd,w_3rd);
+    IpoptLock::unlock();
+    chain->setAng(qdof);
+
+    Vector qd=q0;
+    for (unsigned int i=0,j=0; (i<N) && (j<qdof.length()); i++)
+        if (dof[i]>0.0)
+            qd[i]=qdof[j++];
+
+    Vector pose=chain->EndEffPose();
+    query.xdhat=pose.subVector(0,2);
+    query.odhat=pose.subVector(3,6);
+    query.qdhat=CTRL_RAD2DEG*qd;
+    query.ok=true;
+}
+/**********************************************************/
+ArmSolver::~ArmSolver()
+{
+    delete slv;
+    delete arm;
+}
+/**********************************************************/
+ArmSolverWorker::ArmSolverWorker(ArmSolverPool *pool, const int id) :
+                                 pool(pool), id(id), go(0), done(0)
+{
+}
+/**********************************************************/
+void ArmSolverWorker::run()
+{
+    while (true)
+    {
+        go.wait();
+        if (isStopping())
+            break;
+
+        pool->processJobs(id);
+        done.post();
+    }
+}
+/**********************************************************/
+void ArmSolverWorker::onStop()
+{
+    go.post();
+}
+/**********************************************************/
+void ArmSolverWorker::trigger()
+{
+    go.post();
+}
+/**********************************************************/
+void ArmSolverWorker::waitDone()
+{
+    done.wait();
+}
+/**********************************************************/
+ArmSolverPool::ArmSolverPool() : task2(false), limitsRead(false), jobs(NULL), nextJob(0)
+{
+}
+/**********************************************************/
+bool ArmSolverPool::configure(const string &type, const int nThreads)
+{
+    close();
+
+    this->type=type;
+    limitsRead=false;
+    for (int i=0; i<std::max(nThreads,1); i++)
+    {
+        solvers.push_back(new ArmSolver(type));
+        if (i>0)
+        {
+            ArmSolverWorker *worker=new ArmSolverWorker(this,i);
+            worker->start();
+            workers.push_back(worker);
+        }
+    }
+
+    return true;
+}
+/**********************************************************/
+bool ArmSolverPool::isConfigured() const
+{
+    return ((solvers.size()>0) && limitsRead);
+}
+/**********************************************************/
+bool ArmSolverPool::readLimits(ICartesianControl *iCartCtrl)
+{
+    // limits are read once since they do not change at run-time,
+    // thus saving round-trips at each query
+    if ((solvers.size()==0) || (iCartCtrl==NULL))
+        return false;
+
+    Vector curDof;
+    if (!iCartCtrl->getDOF(curDof))
+        return false;
+
+    Vector min(curDof.length()),max(curDof.length());
+    for (size_t i=0; i<curDof.length(); i++)
+    {
+        if (!iCartCtrl->getLimits((int)i,&min[i],&max[i]))
+            return false;
+    }
+
+    for (size_t i=0; i<solvers.size(); i++)
+        solvers[i]->setLimits(min,max);
+
+    limitsRead=true;
+    return true;
+}
+/**********************************************************/
+void ArmSolverPool::useDefaultLimits()
+{
+    // rely on the limits of the kinematic model when no
+    // controller is available (e.g. offline tools)
+    limitsRead=(solvers.size()>0);
+}
+/**********************************************************/
+void ArmSolverPool::setState(const Vector &dof, const Vector &q)
+{
+    this->dof=dof;
+    this->q=q;
+}
+/**********************************************************/
+bool ArmSolverPool::readRestPosture(ICartesianControl *iCartCtrl)
+{
+    // the rest posture is read once as for the limits,
+    // since it is never changed at run-time
+    if (iCartCtrl==NULL)
+        return false;
+
+    return (iCartCtrl->getRestPos(tasks.restPos) &&
+            iCartCtrl->getRestWeights(tasks.restWeights));
+}
+/**********************************************************/
+void ArmSolverPool::setTask2(const int link, const Vector &xd, const Vector &w)
+{
+    // same settings handed over to the controller through "task_2"
+    tasks.link2nd=link;
+    tasks.xd_2nd=xd;
+    tasks.w_2nd=w;
+}
+/**********************************************************/
+void ArmSolverPool::processJobs(const int id)
+{
+    ArmSolver *solver=solvers[id];
+    while (true)
+    {
+        mutexJobs.wait();
+        size_t k=nextJob++;
+        mutexJobs.post();
+
+        if (k>=jobs->size())
+            break;
+
+        solver->solve((*jobs)[k],dof,q,tasks,task2);
+    }
+}
+/**********************************************************/
+bool ArmSolverPool::solve(deque<IKQuery> &queries, const bool task2)
+{
+    if (!isConfigured())
+        return false;
+
+    this->task2=task2;
+    jobs=&queries;
+    nextJob=0;
+
+    // wake up only the workers that can get a job
+    size_t nWorkers=std::min(workers.size(),queries.size()>0?queries.size()-1:0);
+    for (size_t i=0; i<nWorkers; i++)
+        workers[i]->trigger();
+
+    processJobs(0);
+
+    for (size_t i=0; i<nWorkers; i++)
+        workers[i]->waitDone();
+
+    jobs=NULL;
+
+    bool ok=true;
+    for (size_t k=0; k<queries.size(); k++)
+        ok&=queries[k].ok;
+
+    return ok;
+}
+/**********************************************************/
+void ArmSolverPool::close()
+{
+    for (size_t i=0; i<workers.size(); i++)
+    {
+        workers[i]->stop();
+        delete workers[i];
+    }
+    workers.clear();
+
+    for (size_t i=0; i<solvers.size(); i++)
+        delete solvers[i];
+    solvers.clear();
+}
+/**********************************************************/
+ArmSolverPool::~ArmSolverPool()
+{
+    close();
+}
+
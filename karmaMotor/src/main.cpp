@@ -0,0 +1,3429 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/**
+\defgroup karmaMotor Motor Part of the KARMA Experiment
+
+Motor Control Module that allows the robot to push/draw the
+object and explore a tool.
+
+\section intro_sec Description
+This module aims to control the robot hands in order to properly
+execute the push and the draw actions of an object within the
+KARMA experiment to then learn the corresponding affordance. \n
+It also enable the tool exploration.
+
+\section lib_sec Libraries
+- YARP libraries.
+- icubmod library.
+- iKin library.
+- IPOPT library.
+
+\section parameters_sec Parameters
+--robot \e robot
+- Select the robot to connect to.
+
+--name \e name
+- Select the stem-name of the module used to open up ports.
+  By default \e name is <i>karmaMotor</i>.
+
+--elbow_set <i>(<height> <weight>)</i>
+- To specify how to weigh the task to keep the elbow high.
+
+--movTime \e movTime
+- Time duration for the horizontal hand pose (pronation) pushing and draw actions.
+
+--find_planner \e switch
+- If "on", the poses explored to find the tool are chosen on the
+  fly among a set of candidates as those maximizing the expected
+  information on the tool tip, instead of following the fixed
+  sequence. The reachability is checked only for the candidates
+  ranked first, and the intermediate estimates of the tip are
+  requested to the finder in fast mode. By default it is "off".
+
+--find_tol \e tol
+- With the planner, the exploration stops as soon as the largest
+  standard deviation of the tool tip estimate is lower than
+  \e tol meters. By default it is 0.005 m.
+
+--find_max_poses \e n
+- Maximum number of poses explored by the planner. By default it
+  is 8.
+
+--find_items \e n
+- Number of samples acquired at each pose explored by the
+  planner. By default it is 20.
+
+--local_ik \e switch
+- If "on", the feasibility and quality of the candidate poses
+  (push, virtual draw and tool exploration) are evaluated by a
+  pool of in-process arm solvers instead of querying the remote
+  cartesian solver. The local solvers mirror the secondary tasks
+  of the remote one, i.e. the elbow height and the rest posture,
+  and start from the joints streamed by the torso and arm
+  encoders, so that no round-trip is involved. By default it is
+  "on".
+
+--ik_threads \e n
+- Number of local arm solvers working in parallel. By default
+  it is 1 since the linear solver employed by IPOPT might not be
+  thread-safe: in that case the solves are serialized across
+  the whole module, including the actions running on the two
+  arms concurrently. Values greater than 1 declare the linear
+  solver thread-safe and lift such a serialization.
+
+--ik_cache_size \e n
+- Maximum number of solutions kept in the cache of the pose
+  queries, which are keyed by arm, elbow task, enabled joints and
+  target pose quantized to 1 mm and 0.3 deg; least recently used
+  entries are dropped first. 0 disables the cache. By default
+  it is 10000.
+
+--ik_cache_file \e file
+- If given, the cache is loaded from \e file at start-up and
+  saved back at shutdown. The file is discarded if produced with
+  a different solver (local or remote), arm kinematics or elbow
+  settings, as recorded in its header.
+
+--reach_map \e file
+- The reachability map of the table workspace as built offline
+  by \ref karmaMotorReachMap. When the map covers the requested
+  poses (height and tool included), it drives the selection of
+  the arm in push, push2 and draw, replaces the solver in the
+  choice of the push direction and prunes the sweep candidates.
+
+--reach_thres \e thres
+- Error (position in mm plus orientation in deg) above which a
+  pose of the map is deemed unreachable. By default it is 20.
+
+--shake_period \e period
+- Period in ms of the thread shaking the hand during the tool
+  exploration. By default it is 10 ms.
+
+--shake_amplitude \e amp
+- Amplitude in degrees of the wrist oscillation. By default it
+  is 6 deg.
+
+--shake_frequency \e freq
+- Frequency in Hz of the wrist oscillation. By default it is
+  3 Hz.
+
+--arm_margin \e margin
+- Clearance in meters added around the waypoints of the hand
+  when arbitrating the workspace shared by the two arms. By
+  default it is 0.1. The same clearance is kept around the hand
+  of an idle arm: actions of the other arm sweeping there wait
+  until that hand is moved away (e.g. back home).
+
+--arm_wait \e timeout
+- Maximum time in seconds an action waits for the idle hand of
+  the other arm to leave its region of the workspace. Past that,
+  the action fails and the reply is <i>[nack] (blocked arm)</i>
+  naming the blocking arm. A non-positive value waits
+  indefinitely. By default it is 10 s.
+
+--telemetry_log \e file
+- If given, the records published on the telemetry port are also
+  appended to \e file in binary form (see iCub/telemetry.h).
+
+--sim
+- If given, the robot controllers are replaced by in-process
+  kinematic simulators: arms and gaze track the commanded targets
+  ideally along minimum-jerk profiles, so that the actions and
+  their sequencing can be run offline without robot, simulator
+  nor yarpserver (ports are opened in local mode).
+
+--sim_time_scale \e scale
+- Multiplier of the durations of the simulated motions; 0 makes
+  them instantaneous. By default it is 1.0.
+
+\section portsa_sec Ports Accessed
+Assume that iCubInterface (with ICartesianControl interface
+implemented) is running.
+
+\section portsc_sec Ports Created
+- \e /karmaMotor/rpc receives the information to execute the
+  motor action as a Bottle. It manages the following commands:
+  -# <b>Push</b>: <i>[push] cx cy cz theta radius</i>. \n
+  The coordinates <i>(cx,cy,cz)</i> represent in meters the
+  position of the object's centroid to be pushed; <i>theta</i>,
+  given in degrees, and <i>radius</i>, specified in meters,
+  account for the point from which push the object, that is
+  located onto the circle centered in <i>(cx,cy,cz)</i> and
+  contained in the x-y plane. \n
+  The reply <i>[ack] ((phase time) ...)</i> is returned as soon
+  as the push is accomplished, along with the durations in seconds
+  of the approach, descend, push and retract phases and of the
+  whole action. The reply is <i>[nack]</i> if the action is
+  interrupted, or <i>[nack] (blocked arm)</i> if the idle hand of
+  the other arm does not leave the workspace in time (see
+  --arm_wait); motions not completed within their timeout do not
+  make the push fail, being reported through the telemetry.
+  -# <b>Push sequence</b>: <i>[pseq] ((cx cy cz theta radius) ...)
+  [check]</i>. \n
+  Execute the given pushes in order without going back home in
+  between: the consecutive pushes handled by the same arm are run
+  back to back, the hand being lifted from each retract straight
+  to the approach of the next target. If \e check is given, the
+  module connected to /karmaMotor/check:rpc is queried after each
+  push and the sequence goes on only if it replies <i>[ack]</i>,
+  optionally followed by the updated <i>cx cy cz</i> of the next
+  target. \n
+  The reply <i>[ack] n ((phase time) ...)</i> reports the number
+  of pushes accomplished and the durations of their phases, which
+  are labeled with the index of the target; the reply starts with
+  <i>[nack]</i> if the sequence has not been completed. The same
+  policy as for the single push applies: late motions are
+  tolerated, whereas the sequence stops as soon as it is
+  interrupted or the check fails.
+  -# <b>Push</b>: <i>[pusp] pose cx cy cz theta radius</i>. \n
+  The variable <i>pose</i> controls the hand pose during action,
+  0 for neutral pose, 1 for hand in pronation;
+  The coordinates <i>(cx,cy,cz)</i> represent in meters the
+  position of the object's centroid to be pushed; <i>theta</i>,
+  given in degrees, and <i>radius</i>, specified in meters,
+  account for the point from which push the object, that is
+  located onto the circle centered in <i>(cx,cy,cz)</i> and
+  contained in the x-y plane. \n
+  The reply <i>[ack]</i> is returned as soon as the push is
+  accomplished.
+  -# <b>Draw</b>: <i>[draw] cx cy cz theta radius dist</i>. \n
+  The coordinates <i>(cx,cy,cz)</i> represent in meters the
+  position of the object's centroid to be drawn closer;
+  <i>theta</i>, given in degrees, and <i>radius</i>, specified
+  in meters, account for the point from which draw the object,
+  that is located onto the circle centered in <i>(cx,cy,cz)</i>
+  and contained in the x-y plane. The parameter <i>dist</i>
+  specifies the length in meters of the draw action. \n
+  The reply <i>[ack]</i> is returned as soon as the draw is
+  accomplished, or <i>[nack] (blocked arm)</i> if the idle hand
+  of the other arm does not leave the workspace in time.
+  -# <b>Virtual draw</b>: <i>[vdraw] cx cy cz theta radius
+   dist</i>. \n Simulate the draw without performing any
+   movement in order to test the quality of the action. \n
+   The reply <i>[ack] val</i> is returned at the end of the
+   simulation, where <i>val</i> accounts for the quality of the
+   action: the lower it is the better the action is.
+  -# <b>Sweep</b>: <i>[sweep] cx cy cz (theta ...) (radius ...)
+   (dist ...) [(tool arm x y z [ax ay az angle])] [(thres
+   val)]</i>. \n
+   Evaluate as the virtual draw all the combinations of the
+   given parameters at once. Each parameter is specified either
+   as a list of values <i>(key v0 v1 ...)</i> or as a range
+   <i>(key range min max step)</i>. The optional tool is used in
+   place of the attached one for this request only. \n
+   The reply is <i>[ack] (best theta radius dist val) (table
+   (theta radius dist val) ...)</i>, where the best entry is the
+   one with the lowest quality value below <i>thres</i> (0.1 by
+   default); it is omitted if no entry is feasible. At most 1000
+   combinations can be requested. Entries out of reach according
+   to the reachability map get the value 100.
+   -# <b>Draw</b>: <i>[drap] pose cx cy cz theta radius dist</i>. \n
+  The variable <i>pose</i> controls the hand pose during action,
+  0 for neutral pose, 1 for hand in pronation;
+  The coordinates <i>(cx,cy,cz)</i> represent in meters the
+  position of the object's centroid to be drawn closer;
+  <i>theta</i>, given in degrees, and <i>radius</i>, specified
+  in meters, account for the point from which draw the object,
+  that is located onto the circle centered in <i>(cx,cy,cz)</i>
+  and contained in the x-y plane. The parameter <i>dist</i>
+  specifies the length in meters of the draw action. \n
+  The reply <i>[ack]</i> is returned as soon as the draw is
+  accomplished.
+  -# <b>Tool-attach</b>: <i>[tool] [attach] arm x y z [ax ay az
+  theta]</i>. \n
+  Attach a tool to the given arm whose dimensions are specified
+  in the frame attached to the hand. The subsequent action will
+  make use of this tool. The optional axis-angle <i>(ax ay az
+  theta)</i> specifies the orientation of the tool frame wrt the
+  hand, as estimated by the finder from multiple features; if
+  not given, the orientation is derived from the tip only.
+  -# <b>Tool-attach</b>: <i>[toop] [attach] arm x y z</i>. \n
+  An alternative method to attach a tool to the given arm whose
+  dimensions are specified in the frame attached to the hand,
+  the reference frame attached to the tool is the same as
+  the hand reference frame simply translated to the tool tip.
+  The subsequent action will make use of this tool.
+  -# <b>Tool-get</b>: <i>[tool] [get]</i>. \n
+  Retrieve tool information as <i>[ack] arm x y z</i>.
+  -# <b>Tool-remove</b>: <i>[tool] [remove]</i>. \n
+  Remove the attached tool.
+  -# <b>Cache</b>: <i>[cache] [clear|stats|save]</i>. \n
+  Handle the cache of the pose queries: <i>[stats]</i> replies
+  with <i>[ack] size hits misses</i>; <i>[save]</i> writes the
+  cache to the file given with --ik_cache_file. The cache should
+  be cleared whenever the kinematics or the joint limits change.
+  -# <b>Find</b>: <i>[find] arm eye [tool]</i>. \n
+  An exploration is performed which aims at finding the tool
+  dimension. It is possible to select the arm for executing the
+  movement as well as the eye from which the motion is observed.
+  If <i>eye</i> is "both", the finder is operated in stereo mode
+  and fewer poses are explored; the gaze keeps on tracking the
+  tip as seen from the left camera.
+  The reply <i>[ack] x y z (error e) (cov ...) (cond k)</i>
+  returns the tool's dimensions with respect to reference frame
+  attached to the robot hand, along with the uncertainty of the
+  estimate as computed by the finder. \n
+  If the name <i>tool</i> is given and the tool is found in the
+  finder's library, its stored tip is verified with one pose
+  and a handful of samples; the full exploration is carried out
+  only if the verification fails, then the result gets saved in
+  the library under <i>tool</i>.
+  -# <b>Submit</b>: <i>[subm] [lane] cmd ...</i>. \n
+  Queue any of the commands above to be executed in the
+  background and reply immediately with <i>[ack] id</i>. Actions
+  are executed in order within each lane, whereas the lanes
+  <i>any</i> (the default), <i>left</i> and <i>right</i> run
+  concurrently; actions of the <i>left</i> and <i>right</i> lanes
+  employ the corresponding arm unless a tool is attached. Each
+  arm serves one action at a time and the table regions swept by
+  the two arms must not overlap, otherwise the later action waits;
+  the tool exploration holds both arms.
+  -# <b>Status</b>: <i>[stat] id</i>. \n
+  The reply is <i>[ack] status time ...</i>, where <i>status</i>
+  is one of <i>queued</i>, <i>running</i>, <i>done</i>,
+  <i>failed</i> or <i>cancelled</i> and <i>time</i> is the time
+  spent in that status; queued actions report their position in
+  the queue, whereas completed actions report the reply of the
+  command as a list.
+  -# <b>Cancel</b>: <i>[canc] id</i>. \n
+  Remove a queued action or interrupt the running one.
+
+- \e /karmaMotor/events:o streams <i>id status [(reply)]</i>
+  whenever a submitted action changes its status.
+
+- \e /karmaMotor/telemetry:o streams a record at the end of
+  each push, push sequence, push2, draw and tool exploration:
+  <i>id action arm total ((phase duration done) ...)
+  (err_pos err_rot)</i>, where \e id is the one returned by
+  \e subm (-1 for the actions requested directly), the phases
+  cover the planning, the wait for the arm, the set-up of the
+  context, the IK queries and the motions (\e done being
+  the outcome of the wait for the motion), while the errors in
+  meters and radians refer to the final pose of the hand.
+
+- \e /karmaMotor/stop:i receives request for immediate stop of
+  any ongoing processing.
+
+- \e /karmaMotor/vision:i receives the information about the
+  pixel corresponding to the tool tip during the tool
+  exploration phase.
+
+- \e /karmaMotor/finder:rpc communicates with the module in
+  charge of solving for the tool's dimensions.
+
+- \e /karmaMotor/check:rpc queries the perception module in
+  between the pushes of a sequence with <i>[chck] i</i>, where
+  \e i is the index of the push just accomplished.
+
+- \e /karmaMotor/finder:i receives the number of items acquired
+  by the finder through its status port, which avoids polling
+  it during the tool exploration.
+
+\section tested_os_sec Tested OS
+Windows, Linux
+
+\author Ugo Pattacini
+*/
+
+#include <stdio.h>
+#include <string>
+#include <deque>
+#include <algorithm>
+
+#include <yarp/os/all.h>
+#include <yarp/dev/all.h>
+#include <yarp/sig/all.h>
+#include <yarp/math/Math.h>
+#include <yarp/math/SVD.h>
+
+#include <iCub/ctrl/math.h>
+
+#include "iCub/simulator.h"
+#include "iCub/ikpool.h"
+#include "iCub/ikcache.h"
+#include "iCub/reachmap.h"
+#include "iCub/actionexec.h"
+#include "iCub/actionqueue.h"
+#include "iCub/armarbiter.h"
+#include "iCub/handshaker.h"
+#include "iCub/tipports.h"
+#include "iCub/se3.h"
+#include "iCub/telemetry.h"
+
+YARP_DECLARE_DEVICES(icubmod)
+
+#define SWEEP_MAX_CANDIDATES    1000
+#define SWEEP_PRUNED_QUALITY    100.0
+#define PUSH_APPROACH_BLEND     0.8
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::dev;
+using namespace yarp::math;
+using namespace iCub::ctrl;
+
+
+/************************************************************************/
+struct ExplorationPose
+{
+    Vector xd,od;
+    Vector offset;
+    int    shake_joint;
+    bool   reachable;   // already checked against the solver
+};
+
+
+/************************************************************************/
+struct DrawCandidate
+{
+    double theta,radius,dist;
+    Vector xd1,od1,xd2,od2;
+    ICartesianControl *arm;
+    bool pruned;
+    double quality;
+};
+
+
+/************************************************************************/
+struct PushPlan
+{
+    Vector c;
+    double theta,radius;
+    SE3 H1,H2;
+    Vector xd1,od1,xd2,od2;
+    Vector xd1eps,od1eps,xd2eps,od2eps;
+    ICartesianControl *arm;
+    Vector xd,od,xc;    // selected pose and push target
+    double trajTime;
+};
+
+
+/************************************************************************/
+class KarmaMotor: public RFModule, public PortReader, public ActionHandler
+{
+protected:
+    PolyDriver driverG;
+    PolyDriver driverL;
+    PolyDriver driverR;
+    PolyDriver driverHL;
+    PolyDriver driverHR;
+    PolyDriver driverT;
+
+    IGazeControl      *iGaze;
+    ICartesianControl *iCartCtrlL;
+    ICartesianControl *iCartCtrlR;
+
+    ArmSolverPool ikPoolL;
+    ArmSolverPool ikPoolR;
+    IEncoders    *iencT;
+    IEncoders    *iencL;
+    IEncoders    *iencR;
+    bool local_ik;
+
+    IKCache ikCache;
+    string ik_cache_file;
+
+    ReachMap reachMap;
+    double reach_thres;
+
+    ActionQueue *actionQueue;
+    ArmArbiter   arbiter;
+    Semaphore    mutexState;
+    deque<ActionControl*> activeActions;
+
+    string pushHand;
+    Matrix toolFrame;
+
+    HandShaker *handShaker;
+    int shake_joint;
+    double mov_time;
+
+    bool elbow_set;
+    double elbow_height,elbow_weight;
+
+    bool find_planner;
+    double find_tol;
+    int find_max_poses;
+    int find_items;
+
+    TipTrackerPort       visionPort;
+    FinderStatusPort     finderStatusPort;
+    RpcClient            finderPort;
+    RpcClient            checkPort;
+    RpcServer            rpcPort;
+    Port                 stopPort;
+    BufferedPort<Bottle> eventPort;
+    Telemetry            telemetry;
+
+    /************************************************************************/
+    double dist(const Matrix &M)
+    {
+        double ret=0.0;
+        for (int r=0; r<M.rows(); r++)
+            for (int c=0; c<M.cols(); c++)
+                ret+=M(r,c)*M(r,c);
+
+        return sqrt(ret);
+    }
+
+    /************************************************************************/
+    bool read(ConnectionReader &connection)
+    {
+        Bottle cmd; cmd.read(connection);
+        interruptModule();
+        return true;
+    }
+
+    /************************************************************************/
+    bool execute(const Bottle &command, Bottle &reply, const string &lane,
+                 ActionControl &control)
+    {
+        // the arm lanes force the arm of the actions left selectable
+        dispatch(command,reply,(lane=="any")?"":lane,control);
+        return (reply.get(0).asVocab()==Vocab::encode("ack"));
+    }
+
+    /************************************************************************/
+    void abort(ActionControl &control)
+    {
+        // only the controllers driven by the given action are stopped
+        control.interrupt=true;
+
+        bool arms[2];
+        for (int i=0; i<2; i++)
+            arms[i]=arbiter.isOwner(i,&control.interrupt);
+
+        if (arms[0])
+            iCartCtrlL->stopControl();
+        if (arms[1])
+            iCartCtrlR->stopControl();
+
+        // the tool exploration holds both arms along with the gaze
+        if (arms[0] && arms[1])
+        {
+            iGaze->stopControl();
+            handShaker->stopShaking();
+        }
+    }
+
+    /************************************************************************/
+    bool respond(const Bottle &command, Bottle &reply)
+    {
+        int ack=Vocab::encode("ack");
+        int nack=Vocab::encode("nack");
+
+        int cmd=command.get(0).asVocab();
+        switch (cmd)
+        {
+            //-----------------
+            case VOCAB4('s','u','b','m'):
+            {
+                Bottle action=command.tail();
+                int lane=actionQueue->getLane(action.get(0).asString().c_str());
+                if (lane>=0)
+                    action=action.tail();
+                else
+                    lane=0;
+
+                int tag=action.get(0).asVocab();
+                if ((action.size()>0) && (tag!=VOCAB4('s','u','b','m')) &&
+                    (tag!=VOCAB4('s','t','a','t')) && (tag!=VOCAB4('c','a','n','c')))
+                {
+                    reply.addVocab(ack);
+                    reply.addInt(actionQueue->submit(action,lane));
+                }
+                else
+                    reply.addVocab(nack);
+
+                return true;
+            }
+
+            //-----------------
+            case VOCAB4('s','t','a','t'):
+            {
+                Bottle info;
+                if ((command.size()>1) && actionQueue->status(command.get(1).asInt(),info))
+                {
+                    reply.addVocab(ack);
+                    reply.append(info);
+                }
+                else
+                    reply.addVocab(nack);
+
+                return true;
+            }
+
+            //-----------------
+            case VOCAB4('c','a','n','c'):
+            {
+                if ((command.size()>1) && actionQueue->cancel(command.get(1).asInt()))
+                    reply.addVocab(ack);
+                else
+                    reply.addVocab(nack);
+
+                return true;
+            }
+
+            //-----------------
+            default:
+            {
+                ActionControl control;
+                return dispatch(command,reply,"",control);
+            }
+        }
+    }
+
+    /************************************************************************/
+    void addBlocking(const ActionControl &control, Bottle &reply)
+    {
+        if (control.blocking>=0)
+        {
+            Bottle &blockedPart=reply.addList();
+            blockedPart.addString("blocked");
+            blockedPart.addString((control.blocking==0)?"left":"right");
+        }
+    }
+
+    /************************************************************************/
+    bool dispatch(const Bottle &command, Bottle &reply, const string &lane,
+                  ActionControl &control)
+    {
+        int ack=Vocab::encode("ack");
+        int nack=Vocab::encode("nack");
+
+        // snapshot of the tool, as actions may run concurrently
+        mutexState.wait();
+        string actionHand=pushHand;
+        Matrix actionFrame=toolFrame;
+        activeActions.push_back(&control);
+        mutexState.post();
+        if (!lane.empty() && (actionHand=="selectable"))
+            actionHand=lane;
+
+        int cmd=command.get(0).asVocab();
+        switch (cmd)
+        {
+            //-----------------
+            case VOCAB4('p','u','s','h'):
+            {
+                Bottle payload=command.tail();
+                if (payload.size()>=5)
+                {
+                    Vector c(3);
+                    double theta;
+                    double radius;
+
+                    c[0]=payload.get(0).asDouble();
+                    c[1]=payload.get(1).asDouble();
+                    c[2]=payload.get(2).asDouble();
+                    theta=payload.get(3).asDouble();
+                    radius=payload.get(4).asDouble();
+
+                    Bottle timings;
+                    if (push(control,c,theta,radius,actionHand,actionFrame,timings))
+                    {
+                        reply.addVocab(ack);
+                        reply.addList()=timings;
+                    }
+                    else
+                    {
+                        reply.addVocab(nack);
+                        addBlocking(control,reply);
+                    }
+                }
+
+                break;
+            }
+
+            //-----------------
+            case VOCAB4('p','s','e','q'):
+            {
+                deque<Vector> targets;
+                if (Bottle *pB=command.get(1).asList())
+                {
+                    for (int i=0; i<pB->size(); i++)
+                    {
+                        Bottle *pTarget=pB->get(i).asList();
+                        if ((pTarget!=NULL) && (pTarget->size()>=5))
+                        {
+                            Vector target(5);
+                            for (int j=0; j<5; j++)
+                                target[j]=pTarget->get(j).asDouble();
+                            targets.push_back(target);
+                        }
+                    }
+                }
+
+                if (targets.size()>0)
+                {
+                    bool check=(command.get(2).asString()=="check");
+
+                    Bottle timings;
+                    int done;
+                    if (pushSeq(control,targets,check,actionHand,actionFrame,timings,done))
+                        reply.addVocab(ack);
+                    else
+                        reply.addVocab(nack);
+                    reply.addInt(done);
+                    reply.addList()=timings;
+                    addBlocking(control,reply);
+                }
+
+                break;
+            }
+
+            //-----------------
+            case VOCAB4('d','r','a','w'):
+            case VOCAB4('v','d','r','a'):
+            {
+                Bottle payload=command.tail();
+                if (payload.size()>=6)
+                {
+                    Vector c(3);
+                    double theta;
+                    double radius;
+                    double dist;
+
+                    c[0]=payload.get(0).asDouble();
+                    c[1]=payload.get(1).asDouble();
+                    c[2]=payload.get(2).asDouble();
+                    theta=payload.get(3).asDouble();
+                    radius=payload.get(4).asDouble();
+                    dist=payload.get(5).asDouble();
+
+                    double res=draw(control,cmd==VOCAB4('v','d','r','a'),c,theta,
+                                    radius,dist,actionHand,actionFrame);
+
+                    reply.addVocab((control.blocking<0)?ack:nack);
+                    if (cmd==VOCAB4('v','d','r','a'))
+                        reply.addDouble(res);
+                    addBlocking(control,reply);
+                }
+
+                break;
+            }
+
+            //-----------------
+            case VOCAB4('s','w','e','e'):
+            {
+                Bottle payload=command.tail();
+                if (payload.size()>=3)
+                {
+                    Vector c(3);
+                    c[0]=payload.get(0).asDouble();
+                    c[1]=payload.get(1).asDouble();
+                    c[2]=payload.get(2).asDouble();
+
+                    deque<double> thetas,radii,dists;
+                    if (!getSweepValues(payload,"theta",thetas) ||
+                        !getSweepValues(payload,"radius",radii) ||
+                        !getSweepValues(payload,"dist",dists) ||
+                        (thetas.size()*radii.size()*dists.size()>SWEEP_MAX_CANDIDATES))
+                    {
+                        reply.addVocab(nack);
+                        break;
+                    }
+
+                    // the tool can be specified for this request only
+                    string hand=actionHand;
+                    Matrix frame=actionFrame;
+                    Bottle &toolPart=payload.findGroup("tool");
+                    if ((toolPart.size()>0) && !getTool(toolPart.tail(),hand,frame))
+                    {
+                        reply.addVocab(nack);
+                        break;
+                    }
+
+                    double thres=0.1;
+                    Bottle &thresPart=payload.findGroup("thres");
+                    if (thresPart.size()>=2)
+                        thres=thresPart.get(1).asDouble();
+
+                    deque<DrawCandidate> candidates;
+                    sweepDraw(control,c,thetas,radii,dists,hand,frame,candidates);
+
+                    reply.addVocab(ack);
+                    int best=-1;
+                    for (size_t i=0; i<candidates.size(); i++)
+                    {
+                        if ((candidates[i].quality<thres) &&
+                            ((best<0) || (candidates[i].quality<candidates[best].quality)))
+                            best=(int)i;
+                    }
+
+                    if (best>=0)
+                    {
+                        Bottle &bestPart=reply.addList();
+                        bestPart.addString("best");
+                        bestPart.addDouble(candidates[best].theta);
+                        bestPart.addDouble(candidates[best].radius);
+                        bestPart.addDouble(candidates[best].dist);
+                        bestPart.addDouble(candidates[best].quality);
+                    }
+
+                    Bottle &tablePart=reply.addList();
+                    tablePart.addString("table");
+                    for (size_t i=0; i<candidates.size(); i++)
+                    {
+                        Bottle &entry=tablePart.addList();
+                        entry.addDouble(candidates[i].theta);
+                        entry.addDouble(candidates[i].radius);
+                        entry.addDouble(candidates[i].dist);
+                        entry.addDouble(candidates[i].quality);
+                    }
+                }
+
+                break;
+            }
+
+            //-----------------
+            case VOCAB4('c','a','c','h'):
+            {
+                if (command.size()>1)
+                {
+                    int tag=command.get(1).asVocab();
+                    if (tag==Vocab::encode("clear"))
+                    {
+                        ikCache.clear();
+                        reply.addVocab(ack);
+                    }
+                    else if (tag==Vocab::encode("stats"))
+                    {
+                        int hits,misses;
+                        ikCache.getStats(hits,misses);
+                        reply.addVocab(ack);
+                        reply.addInt((int)ikCache.size());
+                        reply.addInt(hits);
+                        reply.addInt(misses);
+                    }
+                    else if (tag==Vocab::encode("save"))
+                    {
+                        if (!ik_cache_file.empty() && ikCache.save(ik_cache_file))
+                            reply.addVocab(ack);
+                        else
+                            reply.addVocab(nack);
+                    }
+                }
+
+                break;
+            }
+
+            //-----------------
+            case VOCAB4('f','i','n','d'):
+            {
+                Bottle payload=command.tail();
+                if (payload.size()>=2)
+                {
+                    string arm=payload.get(0).asString().c_str();
+                    string eye=payload.get(1).asString().c_str();
+                    string tool=(payload.size()>=3)?payload.get(2).asString().c_str():"";
+                    Bottle solution;
+
+                    if (findToolTip(control,arm,eye,solution,tool))
+                    {
+                        reply.addVocab(ack);
+                        reply.append(solution.tail());
+                    }
+                    else
+                        reply.addVocab(nack);
+                }
+
+                break;
+            }
+
+            //-----------------
+            case VOCAB4('t','o','o','l'):
+            {
+                mutexState.wait();
+                if (command.size()>1)
+                {
+                    Bottle subcommand=command.tail();
+                    int tag=subcommand.get(0).asVocab();
+                    if (tag==Vocab::encode("attach"))
+                    {
+                        Bottle payload=subcommand.tail();
+                        if (getTool(payload,pushHand,toolFrame))
+                            reply.addVocab(ack);
+                    }
+                    else if (tag==Vocab::encode("get"))
+                    {
+                        reply.addVocab(ack);
+                        reply.addString(pushHand.c_str());
+                        reply.addDouble(toolFrame(0,3));
+                        reply.addDouble(toolFrame(1,3));
+                        reply.addDouble(toolFrame(2,3));
+                    }
+                    else if (tag==Vocab::encode("remove"))
+                    {
+                        pushHand="selectable";
+                        toolFrame=eye(4,4);
+
+                        reply.addVocab(ack);
+                    }
+                }
+                mutexState.post();
+
+                break;
+            }
+
+            //-----------------
+            case VOCAB4('p','u','s','p'):
+            {
+                Bottle payload=command.tail();
+                if (payload.size()>=6)
+                {
+                    int pose;
+                    Vector c(3);
+                    double theta;
+                    double radius;
+
+                    pose=payload.get(0).asInt();
+                    c[0]=payload.get(1).asDouble();
+                    c[1]=payload.get(2).asDouble();
+                    c[2]=payload.get(3).asDouble();
+                    theta=payload.get(4).asDouble();
+                    radius=payload.get(5).asDouble();
+
+                    if (push2(control,pose,c,theta,radius,actionHand,actionFrame))
+                        reply.addVocab(ack);
+                    else
+                    {
+                        reply.addVocab(nack);
+                        addBlocking(control,reply);
+                    }
+                }
+
+                break;
+            }
+
+            //-----------------
+            case VOCAB4('d','r','a','p'):
+            case VOCAB4('v','d','r','p'):
+            {
+                Bottle payload=command.tail();
+                if (payload.size()>=7)
+                {
+                    int pose;
+                    Vector c(3);
+                    double theta;
+                    double radius;
+                    double dist;
+
+                    pose=payload.get(0).asDouble();
+                    c[0]=payload.get(1).asDouble();
+                    c[1]=payload.get(2).asDouble();
+                    c[2]=payload.get(3).asDouble();
+                    theta=payload.get(4).asDouble();
+                    radius=payload.get(5).asDouble();
+                    dist=payload.get(6).asDouble();
+
+                    double res=draw2(control,cmd==VOCAB4('v','d','r','p'),pose,c,theta,
+                                     radius,dist,actionHand,actionFrame);
+
+                    reply.addVocab((control.blocking<0)?ack:nack);
+                    if (cmd==VOCAB4('v','d','r','p'))
+                        reply.addDouble(res);
+                    addBlocking(control,reply);
+                }
+
+                break;
+            }
+
+            //-----------------
+            case VOCAB4('t','o','o','p'):
+            {
+                mutexState.wait();
+                if (command.size()>1)
+                {
+                    Bottle subcommand=command.tail();
+                    int tag=subcommand.get(0).asVocab();
+                    if (tag==Vocab::encode("attach"))
+                    {
+                        Bottle payload=subcommand.tail();
+                        if (payload.size()>=4)
+                        {
+                            pushHand=payload.get(0).asString().c_str();
+
+                            Vector point(4);
+                            point[0]=payload.get(1).asDouble();
+                            point[1]=payload.get(2).asDouble();
+                            point[2]=payload.get(3).asDouble();
+                            point[3]=1.0;
+
+                            toolFrame.eye();
+                            toolFrame.setCol(3,point);
+
+                            reply.addVocab(ack);
+                        }
+                    }
+                    else if (tag==Vocab::encode("get"))
+                    {
+                        reply.addVocab(ack);
+                        reply.addString(pushHand.c_str());
+                        reply.addDouble(toolFrame(0,3));
+                        reply.addDouble(toolFrame(1,3));
+                        reply.addDouble(toolFrame(2,3));
+                    }
+                    else if (tag==Vocab::encode("remove"))
+                    {
+                        pushHand="selectable";
+                        toolFrame=eye(4,4);
+
+                        reply.addVocab(ack);
+                    }
+                }
+                mutexState.post();
+
+                break;
+            }
+
+            //-----------------
+            default:
+                endAction(control);
+                return RFModule::respond(command,reply);
+        }
+
+        endAction(control);
+        return true;
+    }
+
+    /************************************************************************/
+    void endAction(ActionControl &control)
+    {
+        mutexState.wait();
+        for (deque<ActionControl*>::iterator it=activeActions.begin(); it!=activeActions.end(); it++)
+        {
+            if (*it==&control)
+            {
+                activeActions.erase(it);
+                break;
+            }
+        }
+        mutexState.post();
+    }
+
+    /************************************************************************/
+    bool getTool(const Bottle &payload, string &hand, Matrix &frame)
+    {
+        if (payload.size()<4)
+            return false;
+
+        hand=payload.get(0).asString().c_str();
+
+        Vector point(4);
+        point[0]=payload.get(1).asDouble();
+        point[1]=payload.get(2).asDouble();
+        point[2]=payload.get(3).asDouble();
+        point[3]=1.0;
+
+        Vector r(4,0.0);
+        if (payload.size()>=8)
+        {
+            for (int i=0; i<4; i++)
+                r[i]=payload.get(4+i).asDouble();
+        }
+        else
+        {
+            r[2]=-1.0;
+            r[3]=atan2(-point[1],point[0]);
+        }
+        frame=axis2dcm(r);
+        frame.setCol(3,point);
+
+        return true;
+    }
+
+    /************************************************************************/
+    bool getSweepValues(const Bottle &payload, const string &key, deque<double> &values)
+    {
+        // either (key v0 v1 ...) or (key range min max step)
+        Bottle &group=payload.findGroup(key.c_str());
+        if (group.size()<2)
+            return false;
+
+        values.clear();
+        if (group.get(1).asString()=="range")
+        {
+            if (group.size()<5)
+                return false;
+
+            double min=group.get(2).asDouble();
+            double max=group.get(3).asDouble();
+            double step=group.get(4).asDouble();
+            if ((step<=0.0) || (max<min))
+                return false;
+
+            for (int i=0; min+i*step<=max+1e-9; i++)
+            {
+                values.push_back(min+i*step);
+                if (values.size()>SWEEP_MAX_CANDIDATES)
+                    return false;
+            }
+        }
+        else
+        {
+            for (int i=1; i<group.size(); i++)
+                values.push_back(group.get(i).asDouble());
+        }
+
+        return (values.size()>0);
+    }
+
+    /************************************************************************/
+    double getReachError(ICartesianControl *arm, const Vector &xd, const Vector &od,
+                         const Matrix &frame)
+    {
+        // the map is indexed by the pose of the tool tip;
+        // negative values stand for unknown
+        if (!reachMap.isOpen())
+            return -1.0;
+
+        int tool=reachMap.findTool(frame);
+        if (tool<0)
+            return -1.0;
+
+        Matrix H=axis2dcm(od);
+        H(0,3)=xd[0]; H(1,3)=xd[1]; H(2,3)=xd[2];
+        return reachMap.getError((arm==iCartCtrlR)?1:0,tool,H*frame);
+    }
+
+    /************************************************************************/
+    ICartesianControl *selectArm(const Vector &xd1, const Vector &od1, const Vector &xd2,
+                                 const Vector &od2, const Matrix &frame,
+                                 ICartesianControl *fallback)
+    {
+        // the arm attaining both poses with the lowest error;
+        // the given one is kept when the map cannot tell
+        double eL1=getReachError(iCartCtrlL,xd1,od1,frame);
+        double eL2=getReachError(iCartCtrlL,xd2,od2,frame);
+        double eR1=getReachError(iCartCtrlR,xd1,od1,frame);
+        double eR2=getReachError(iCartCtrlR,xd2,od2,frame);
+        if ((eL1<0.0) || (eL2<0.0) || (eR1<0.0) || (eR2<0.0))
+            return fallback;
+
+        double eL=std::max(eL1,eL2);
+        double eR=std::max(eR1,eR2);
+        printf("reachability map: left e=%g; right e=%g\n",eL,eR);
+        if (eL==eR)
+            return fallback;
+
+        return ((eL<eR)?iCartCtrlL:iCartCtrlR);
+    }
+
+    /************************************************************************/
+    string selectArm(const Vector &x1, const Vector &x2, const Matrix &frame,
+                     const string &fallback)
+    {
+        // the arm with the highest dexterity at both positions
+        if (!reachMap.isOpen())
+            return fallback;
+
+        int tool=reachMap.findTool(frame);
+        if (tool<0)
+            return fallback;
+
+        double dL=std::min(reachMap.getDexterity(0,tool,x1,reach_thres),
+                           reachMap.getDexterity(0,tool,x2,reach_thres));
+        double dR=std::min(reachMap.getDexterity(1,tool,x1,reach_thres),
+                           reachMap.getDexterity(1,tool,x2,reach_thres));
+        if ((dL<0.0) || (dR<0.0) || (dL==dR))
+            return fallback;
+
+        printf("reachability map: left dexterity=%g; right dexterity=%g\n",dL,dR);
+        return ((dL>dR)?"left":"right");
+    }
+
+    /***************************************************************/
+    void changeElbowHeight(ICartesianControl *iCartCtrl)
+    {
+        if (elbow_set)
+        {
+            Bottle tweakOptions;
+            Bottle &optTask2=tweakOptions.addList();
+            optTask2.addString("task_2");
+            Bottle &plTask2=optTask2.addList();
+            plTask2.addInt(6);
+            Bottle &posPart=plTask2.addList();
+            posPart.addDouble(0.0);
+            posPart.addDouble(0.0);
+            posPart.addDouble(elbow_height);
+            Bottle &weightsPart=plTask2.addList();
+            weightsPart.addDouble(0.0);
+            weightsPart.addDouble(0.0);
+            weightsPart.addDouble(elbow_weight);
+            iCartCtrl->tweakSet(tweakOptions);
+        }
+    }
+
+    /************************************************************************/
+    bool getArmJoints(ICartesianControl *iCartCtrl, Vector &q)
+    {
+        // the encoders are streamed, hence no round-trip is needed;
+        // the controller is asked otherwise (e.g. the simulator,
+        // which runs in process)
+        IEncoders *iencArm=(iCartCtrl==iCartCtrlR)?iencR:iencL;
+        if ((iencT!=NULL) && (iencArm!=NULL))
+        {
+            int nT,nA;
+            iencT->getAxes(&nT);
+            iencArm->getAxes(&nA);
+            Vector t(nT),a(nA);
+            if ((nT>=3) && (nA>=7) && iencT->getEncoders(t.data()) &&
+                iencArm->getEncoders(a.data()))
+            {
+                // the torso joints are reversed in the arm chain
+                q.resize(10);
+                q[0]=t[2]; q[1]=t[1]; q[2]=t[0];
+                for (int i=0; i<7; i++)
+                    q[3+i]=a[i];
+                return true;
+            }
+        }
+
+        Vector xdhat,odhat;
+        return iCartCtrl->getDesired(xdhat,odhat,q);
+    }
+
+    /************************************************************************/
+    bool solvePoses(ICartesianControl *iCartCtrl, deque<IKQuery> &queries, const Vector &dof,
+                    const bool elbow)
+    {
+        // what-if queries are answered in process by the local solvers,
+        // starting from the current configuration of the arm and with
+        // the same secondary tasks (elbow and rest posture);
+        // the remote solver is queried otherwise
+        ArmSolverPool &pool=(iCartCtrl==iCartCtrlR)?ikPoolR:ikPoolL;
+        if (local_ik && pool.isConfigured())
+        {
+            Vector q;
+            if (getArmJoints(iCartCtrl,q))
+            {
+                pool.setState(dof,q);
+                return pool.solve(queries,elbow && elbow_set);
+            }
+        }
+
+        bool ok=true;
+        for (size_t i=0; i<queries.size(); i++)
+        {
+            IKQuery &query=queries[i];
+            if (query.q0.length()>0)
+                query.ok=iCartCtrl->askForPose(query.q0,query.xd,query.od,
+                                               query.xdhat,query.odhat,query.qdhat);
+            else
+                query.ok=iCartCtrl->askForPose(query.xd,query.od,
+                                               query.xdhat,query.odhat,query.qdhat);
+            ok&=query.ok;
+        }
+
+        return ok;
+    }
+
+    /************************************************************************/
+    bool askForPoses(ICartesianControl *iCartCtrl, deque<IKQuery> &queries, const Vector &dof,
+                     const bool elbow)
+    {
+        // targets recur across trials: only the unknown ones
+        // are forwarded to the solvers; solutions obtained with
+        // the elbow task (see changeElbowHeight) are kept apart
+        string arm=(iCartCtrl==iCartCtrlR)?"right":"left";
+        if (elbow && elbow_set)
+            arm+="+elbow";
+        deque<size_t> idx;
+        deque<IKQuery> pending;
+        for (size_t i=0; i<queries.size(); i++)
+        {
+            if (!ikCache.get(arm,dof,queries[i]))
+            {
+                idx.push_back(i);
+                pending.push_back(queries[i]);
+            }
+        }
+
+        if (pending.size()>0)
+        {
+            solvePoses(iCartCtrl,pending,dof,elbow);
+            for (size_t i=0; i<pending.size(); i++)
+            {
+                queries[idx[i]]=pending[i];
+                if (pending[i].ok)
+                    ikCache.put(arm,dof,pending[i]);
+            }
+        }
+
+        bool ok=true;
+        for (size_t i=0; i<queries.size(); i++)
+            ok&=queries[i].ok;
+
+        return ok;
+    }
+
+    /************************************************************************/
+    int getArmIndex(ICartesianControl *iCartCtrl)
+    {
+        return ((iCartCtrl==iCartCtrlR)?1:0);
+    }
+
+    /************************************************************************/
+    string getArmName(ICartesianControl *iCartCtrl)
+    {
+        return ((iCartCtrl==iCartCtrlR)?"right":"left");
+    }
+
+    /************************************************************************/
+    void getPushPoses(const Vector &c, const double theta, const double radius,
+                      const string &armType, const Matrix &frame, PushPlan &plan)
+    {
+        plan.c=c;
+        plan.theta=theta;
+        plan.radius=radius;
+
+        // wrt root frame: frame centered at c with x-axis pointing rightward,
+        // y-axis pointing forward and z-axis pointing upward
+        SE3 H0;
+        H0.setRotation(0.0,-1.0,0.0,
+                       1.0, 0.0,0.0,
+                       0.0, 0.0,1.0);
+        H0.setTranslation(c[0],c[1],c[2]);
+
+        double theta_rad=CTRL_DEG2RAD*theta;
+        double _c=cos(theta_rad);
+        double _s=sin(theta_rad);
+        double epsilon=0.05;
+
+        // wrt H0 frame: frame centered at R*[_c,_s] with z-axis pointing inward
+        // and x-axis tangential
+        SE3 &H1=plan.H1;
+        H1.setRotation(-_s, 0.0,-_c,
+                        _c, 0.0,-_s,
+                       0.0,-1.0,0.0);
+        H1.setTranslation(radius*_c,radius*_s,0.0);
+
+        // wrt H0 frame: frame centered at R*[_c,_s] with z-axis pointing outward
+        // and x-axis tangential
+        SE3 &H2=plan.H2;
+        H2.setRotation( _s, 0.0, _c,
+                       -_c, 0.0, _s,
+                       0.0,-1.0,0.0);
+        H2.setTranslation(radius*_c,radius*_s,0.0);
+
+        // matrices that serve to account for pushing with the back of the hand
+        SE3 H1eps=H1; SE3 H2eps=H2;
+        H1eps.p[0]+=epsilon*_c; H1eps.p[1]+=epsilon*_s;
+        H2eps.p[0]+=epsilon*_c; H2eps.p[1]+=epsilon*_s;
+
+        // go back into root frame and apply tool (if any)
+        SE3 invFrame=SE3(frame).inverse();
+        H1=H0*H1*invFrame;
+        H2=H0*H2*invFrame;
+        H1eps=H0*H1eps*invFrame;
+        H2eps=H0*H2eps*invFrame;
+
+        Vector &xd1=plan.xd1; Vector &od1=plan.od1;
+        Vector &xd2=plan.xd2; Vector &od2=plan.od2;
+        H1.getPosition(xd1); H1.getAxis(od1);
+        H2.getPosition(xd2); H2.getAxis(od2);
+        H1eps.getPosition(plan.xd1eps); H1eps.getAxis(plan.od1eps);
+        H2eps.getPosition(plan.xd2eps); H2eps.getAxis(plan.od2eps);
+
+        printf("identified locations...\n");
+        printf("xd1=(%s) od1=(%s)\n",xd1.toString(3,3).c_str(),od1.toString(3,3).c_str());
+        printf("xd2=(%s) od2=(%s)\n",xd2.toString(3,3).c_str(),od2.toString(3,3).c_str());
+
+        // choose the arm
+        if (armType=="selectable")
+        {
+            if (xd1[1]>=0.0)
+                plan.arm=iCartCtrlR;
+            else
+                plan.arm=iCartCtrlL;
+
+            plan.arm=selectArm(xd1,od1,xd2,od2,frame,plan.arm);
+        }
+        else if (armType=="left")
+            plan.arm=iCartCtrlL;
+        else
+            plan.arm=iCartCtrlR;
+    }
+
+    /************************************************************************/
+    int setPushContext(ICartesianControl *iCartCtrl, Vector &dof)
+    {
+        int context;
+        iCartCtrl->storeContext(&context);
+
+        Bottle options;
+        Bottle &straightOpt=options.addList();
+        straightOpt.addString("straightness");
+        straightOpt.addDouble(10.0);
+        iCartCtrl->tweakSet(options);
+        changeElbowHeight(iCartCtrl);
+
+        iCartCtrl->getDOF(dof);
+
+        dof=1.0; dof[1]=0.0;
+        iCartCtrl->setDOF(dof,dof);
+
+        return context;
+    }
+
+    /************************************************************************/
+    void selectPushPose(PushPlan &plan, const string &armType, const Matrix &frame,
+                        const Vector &dof)
+    {
+        ICartesianControl *iCartCtrl=plan.arm;
+        const Vector &c=plan.c;
+        const double theta=plan.theta;
+        const double radius=plan.radius;
+        double theta_rad=CTRL_DEG2RAD*theta;
+        double _theta=CTRL_RAD2DEG*atan2(sin(theta_rad),cos(theta_rad));    // to have theta in [-180.0,180.0]
+        Vector &xd1=plan.xd1; Vector &od1=plan.od1;
+        Vector &xd2=plan.xd2; Vector &od2=plan.od2;
+
+        // try out different poses: the map spares the solver
+        // whenever it covers both of them
+        double d1=getReachError(iCartCtrl,xd1,od1,frame);
+        double d2=getReachError(iCartCtrl,xd2,od2,frame);
+        if ((d1>=0.0) && (d2>=0.0))
+        {
+            printf("solutions from the reachability map...\n");
+            printf("#1: e=%.3f\n#2: e=%.3f\n",d1,d2);
+        }
+        else
+        {
+            deque<IKQuery> queries(2);
+            queries[0].xd=xd1; queries[0].od=od1;
+            queries[1].xd=xd2; queries[1].od=od2;
+            askForPoses(iCartCtrl,queries,dof,true);
+
+            Vector &xdhat1=queries[0].xdhat; Vector &odhat1=queries[0].odhat;
+            Vector &xdhat2=queries[1].xdhat; Vector &odhat2=queries[1].odhat;
+
+            Matrix Hhat1=axis2dcm(odhat1); Hhat1(0,3)=xdhat1[0]; Hhat1(1,3)=xdhat1[1]; Hhat1(2,3)=xdhat1[2];
+            Matrix Hhat2=axis2dcm(odhat2); Hhat2(0,3)=xdhat2[0]; Hhat2(1,3)=xdhat2[1]; Hhat2(2,3)=xdhat2[2];
+
+            d1=dist(plan.H1.toMatrix()-Hhat1);
+            d2=dist(plan.H2.toMatrix()-Hhat2);
+
+            printf("solutions...\n");
+            printf("#1: xdhat1=(%s) odhat1=(%s); e=%.3f\n",xdhat1.toString(3,3).c_str(),odhat1.toString(3,3).c_str(),d1);
+            printf("#2: xdhat2=(%s) odhat2=(%s); e=%.3f\n",xdhat2.toString(3,3).c_str(),odhat2.toString(3,3).c_str(),d2);
+        }
+        printf("selection: ");
+
+        // compare solutions and choose the best
+        Vector *xd,*od;
+        if (fabs(_theta-90.0)<45.0)
+        {
+            printf("(detected singularity) ");
+            if (iCartCtrl==iCartCtrlR)
+            {
+                xd=&xd1;
+                od=&od1;
+            }
+            else
+            {
+                xd=&xd2;
+                od=&od2;
+            }
+        }
+        else if (fabs(_theta+90.0)<45.0)
+        {
+            printf("(detected singularity) ");
+            if (iCartCtrl==iCartCtrlR)
+            {
+                xd=&xd2;
+                od=&od2;
+            }
+            else
+            {
+                xd=&xd1;
+                od=&od1;
+            }
+        }
+        else if (d1<d2)
+        {
+            xd=&xd1;
+            od=&od1;
+        }
+        else
+        {
+            xd=&xd2;
+            od=&od2;
+        }
+
+        if (xd==&xd1)
+            printf("#1 ");
+        else
+            printf("#2 ");
+
+        if ((iCartCtrl==iCartCtrlR) && (_theta<0.0) && (xd==&xd2))
+        {
+            printf("(increased radius)");
+            xd=&plan.xd2eps;
+            od=&plan.od2eps;
+        }
+        else if ((iCartCtrl==iCartCtrlL) && (_theta<0.0) && (xd==&xd1))
+        {
+            printf("(increased radius)");
+            xd=&plan.xd1eps;
+            od=&plan.od1eps;
+        }
+
+        printf(": xd=(%s); od=(%s)\n",xd->toString(3,3).c_str(),od->toString(3,3).c_str());
+
+        double rmin,rmax,tmin,tmax;
+        if (((fabs(theta)<10.0) || (fabs(theta-180.0)<10.0)))
+        {
+            rmin=0.04; rmax=0.18;
+            tmin=0.40; tmax=0.60;
+        }
+        else
+        {
+            rmin=0.04; rmax=0.18;
+            tmin=0.50; tmax=0.80;
+        }
+
+        // safe guard for using the tool
+        if (armType!="selectable")
+        {
+            tmin*=1.3;
+            tmax*=1.3;
+        }
+
+        plan.trajTime=tmin+((tmax-tmin)/(rmax-rmin))*(radius-rmin);
+        plan.trajTime=std::max(std::min(tmax,plan.trajTime),tmin);
+
+        // the tool tip is brought onto the center
+        SE3 H=SE3::rotation((*od)[0],(*od)[1],(*od)[2],(*od)[3]);
+        H.setTranslation(c[0],c[1],c[2]);
+        SE3 T; T.setTranslation(-frame(0,3),-frame(1,3),-frame(2,3));
+        (H*T).getPosition(plan.xc);
+
+        plan.xd=*xd;
+        plan.od=*od;
+    }
+
+    /************************************************************************/
+    void getPushWaypoints(const PushPlan &plan, deque<Vector> &waypoints)
+    {
+        Vector offs(3,0.0); offs[2]=0.1;
+        waypoints.push_back(plan.xd+offs);
+        waypoints.push_back(plan.xd);
+        waypoints.push_back(plan.xc);
+    }
+
+    /************************************************************************/
+    void addPushSegments(ActionExecutor &executor, const PushPlan &plan, const string &suffix,
+                         const bool transit, const bool blendTransit)
+    {
+        // the approach from above blends into the descent, whereas
+        // the push starts only once the hand has come to rest; in a
+        // sequence, the hand is then lifted on the way to the next
+        // target without stopping
+        Vector offs(3,0.0); offs[2]=0.1;
+        executor.add("approach"+suffix,plan.xd+offs,plan.od,1.0,4.0,PUSH_APPROACH_BLEND);
+        executor.add("descend"+suffix,plan.xd,plan.od,1.0,4.0);
+        executor.add("push"+suffix,plan.xc,plan.od,plan.trajTime,3.0);
+        executor.add("retract"+suffix,plan.xd,plan.od,1.0,2.0,
+                     transit?PUSH_APPROACH_BLEND:1.0);
+        if (transit)
+            executor.add("lift"+suffix,plan.xd+offs,plan.od,1.0,2.0,
+                         blendTransit?PUSH_APPROACH_BLEND:1.0);
+    }
+
+    /************************************************************************/
+    bool push(ActionControl &control, const Vector &c, const double theta, const double radius,
+              const string &armType, const Matrix &frame, Bottle &timings)
+    {
+        ActionRecord record("push");
+        record.setId(control.id);
+        record.begin("plan");
+        PushPlan plan;
+        getPushPoses(c,theta,radius,armType,frame,plan);
+        ICartesianControl *iCartCtrl=plan.arm;
+        record.setArm(getArmName(iCartCtrl));
+        record.end();
+
+        // the arm is granted to this action only
+        int arm=getArmIndex(iCartCtrl);
+        record.begin("arbiter");
+        if (!arbiter.acquire(arm,&control.interrupt))
+        {
+            record.end(false);
+            telemetry.publish(record);
+            return false;
+        }
+        record.end();
+
+        // deal with the arm context
+        record.begin("context");
+        Vector dof;
+        int context=setPushContext(iCartCtrl,dof);
+        record.end();
+
+        record.begin("ik");
+        selectPushPose(plan,armType,frame,dof);
+        record.end();
+
+        deque<Vector> waypoints;
+        getPushWaypoints(plan,waypoints);
+
+        record.begin("reserve");
+        bool granted=arbiter.reserve(arm,waypoints,&control.interrupt,&control.blocking);
+        record.end(granted);
+        bool ok=false;
+        if (granted)
+        {
+            ActionExecutor executor(iCartCtrl,&control.interrupt);
+            executor.setRecord(&record);
+            addPushSegments(executor,plan,"",false,false);
+            executor.execute();
+            timings=executor.getTimings();
+
+            // motions not completed in time are tolerated (they are
+            // reported in the telemetry), whereas interruptions are not
+            ok=(executor.getNumCompleted()==executor.getNumSegments());
+        }
+
+        iCartCtrl->restoreContext(context);
+        iCartCtrl->deleteContext(context);
+        arbiter.release(arm,granted);
+        telemetry.publish(record);
+
+        return ok;
+    }
+
+    /************************************************************************/
+    bool checkPush(const int i, Vector &target)
+    {
+        // nothing to check with if no perception module is connected
+        if (checkPort.getOutputCount()==0)
+            return true;
+
+        Bottle command,reply;
+        command.addVocab(Vocab::encode("chck"));
+        command.addInt(i);
+        checkPort.write(command,reply);
+        if (reply.get(0).asVocab()!=Vocab::encode("ack"))
+        {
+            printf("check after push #%d failed: sequence aborted\n",i);
+            return false;
+        }
+
+        // the object may have moved: the next push is then
+        // referred to its updated position
+        if (reply.size()>=4)
+            for (int j=0; j<3; j++)
+                target[j]=reply.get(1+j).asDouble();
+
+        return true;
+    }
+
+    /************************************************************************/
+    bool pushSeq(ActionControl &control, deque<Vector> &targets, const bool check, const string &armType,
+                 const Matrix &frame, Bottle &timings, int &done)
+    {
+        timings.clear();
+        done=0;
+
+        ActionRecord record("pseq");
+        record.setId(control.id);
+        double t0=Time::now();
+        bool ok=true;
+        size_t i=0;
+        while (ok && !control.interrupt && (i<targets.size()))
+        {
+            // the following targets taken by the same arm are executed
+            // in one go, the retract of each push flowing into the approach
+            // of the next one; with the check in between, targets go one
+            // at a time as they might be displaced
+            record.begin("plan");
+            deque<PushPlan> run(1);
+            getPushPoses(targets[i].subVector(0,2),targets[i][3],targets[i][4],
+                         armType,frame,run[0]);
+            ICartesianControl *iCartCtrl=run[0].arm;
+            while (!check && (i+run.size()<targets.size()))
+            {
+                const Vector &target=targets[i+run.size()];
+                PushPlan plan;
+                getPushPoses(target.subVector(0,2),target[3],target[4],armType,frame,plan);
+                if (plan.arm!=iCartCtrl)
+                    break;
+
+                run.push_back(plan);
+            }
+            record.setArm(getArmName(iCartCtrl));
+            record.end();
+
+            int arm=getArmIndex(iCartCtrl);
+            record.begin("arbiter");
+            if (!arbiter.acquire(arm,&control.interrupt))
+            {
+                record.end(false);
+                break;
+            }
+            record.end();
+
+            record.begin("context");
+            Vector dof;
+            int context=setPushContext(iCartCtrl,dof);
+            record.end();
+
+            record.begin("ik");
+            deque<Vector> waypoints;
+            for (size_t j=0; j<run.size(); j++)
+            {
+                selectPushPose(run[j],armType,frame,dof);
+                getPushWaypoints(run[j],waypoints);
+            }
+            record.end();
+
+            record.begin("reserve");
+            ok=arbiter.reserve(arm,waypoints,&control.interrupt,&control.blocking);
+            record.end(ok);
+            bool moved=ok;
+            if (ok)
+            {
+                // each push is accomplished once its retract is carried out
+                ActionExecutor executor(iCartCtrl,&control.interrupt);
+                executor.setRecord(&record);
+                deque<size_t> retracts;
+                for (size_t j=0; j<run.size(); j++)
+                {
+                    char suffix[16];
+                    bool transit=(i+j+1<targets.size());
+                    sprintf(suffix,"_%d",(int)(i+j));
+                    addPushSegments(executor,run[j],suffix,transit,j+1<run.size());
+                    retracts.push_back(executor.getNumSegments()-(transit?1:0));
+                }
+
+                // same policy as the single push: late motions are
+                // tolerated, interruptions are not
+                executor.execute();
+                for (size_t j=0; j<retracts.size(); j++)
+                    if (retracts[j]<=executor.getNumCompleted())
+                        done++;
+                ok=(executor.getNumCompleted()==executor.getNumSegments());
+
+                // the total is given for the whole sequence
+                const Bottle &runTimings=executor.getTimings();
+                for (int j=0; j<runTimings.size()-1; j++)
+                    timings.add(runTimings.get(j));
+            }
+
+            iCartCtrl->restoreContext(context);
+            iCartCtrl->deleteContext(context);
+            arbiter.release(arm,moved);
+
+            i+=run.size();
+            if (ok && check && !control.interrupt && (i<targets.size()))
+            {
+                record.begin("check");
+                ok=checkPush((int)i-1,targets[i]);
+                record.end(ok);
+            }
+        }
+
+        Bottle &timing=timings.addList();
+        timing.addString("total");
+        timing.addDouble(Time::now()-t0);
+        telemetry.publish(record);
+
+        return (done==(int)targets.size());
+    }
+
+    /************************************************************************/
+    bool push2(ActionControl &control, const int pose, const Vector &c, const double theta, const double radius,
+               const string &armType="selectable", const Matrix &frame=eye(4,4))
+    {
+        ICartesianControl *iCartCtrl;
+        ActionRecord record("push2");
+        record.setId(control.id);
+
+        double theta_rad = CTRL_DEG2RAD*theta;
+        double _c = cos(theta_rad);
+        double _s = sin(theta_rad);
+        double _theta = CTRL_RAD2DEG*atan2(_s,_c);    // to have theta in [-180.0,180.0]
+
+
+        // Transformation: Object frame to Robot frame, translation of origin from object to robot frame.
+        SE3 O2R;
+        O2R.p[0] = c[0];    //x
+        O2R.p[1] = c[1];    //y
+        O2R.p[2] = c[2];    //z
+
+
+        // Transformation: Target Position frame to Object frame, translation of origin from target position to object frame.
+        // target position located at cylindrical coordinates (radius,theta,offZ) in the Object frame
+        // P1'->P1->P2->P1
+        //      End-effector is placed at P1' above the acting position P1
+        //      Lowered into acting position P1
+        //      Moved to P2, thus performing the pushing action
+        //      Moded back to P1 position
+
+        // P1', First target position, situated above P1 so that the end-effector does not collide with the object
+        double offZ = 0.1;
+        double alfa_rad = CTRL_DEG2RAD*(_theta+0);
+        double magn = radius;
+
+        SE3 P2O0;
+        P2O0.p[0] = cos(alfa_rad)*magn;
+        P2O0.p[1] = sin(alfa_rad)*magn;
+        P2O0.p[2] = offZ;
+
+        // P1, second target position, starting position for the pushing action
+        offZ = 0;
+        alfa_rad = CTRL_DEG2RAD*(_theta+0);
+        magn = radius;
+
+        SE3 P2O1;
+        P2O1.p[0] = cos(alfa_rad)*magn;
+        P2O1.p[1] = sin(alfa_rad)*magn;
+        P2O1.p[2] = offZ;
+
+        // P2, third target position, where the end effector moves during the pushing action
+        offZ = 0;
+        alfa_rad = CTRL_DEG2RAD*(_theta+180);
+        magn = radius;
+
+        SE3 P2O2;
+        P2O2.p[0] = cos(alfa_rad)*magn;
+        P2O2.p[1] = sin(alfa_rad)*magn;
+        P2O2.p[2] = offZ;
+
+        // P3, fourth target position, where the end effector moves after the pushing action
+        offZ = 0.1;
+        alfa_rad = CTRL_DEG2RAD*(_theta+180);
+        magn = radius;
+
+        SE3 P2O3;
+        P2O3.p[0] = cos(alfa_rad)*magn;
+        P2O3.p[1] = sin(alfa_rad)*magn;
+        P2O3.p[2] = offZ;
+
+
+        // Transformations: Hand frame to Target Position frame, Defines several possible orientations of both hands (only rotation, no translation)
+        // Hand in a rotation neutral pose can be set with the palm or back of the hand towards the object
+        // Hand in a pronation pose can be set with the top or bottom edge of the hand towards the object
+
+
+        SE3 H2P;    // Choosen Hand
+
+        //pose=0 rotation=neutral | pose=1 rotation=pronation
+        float psi = -30;
+        float fi = 0;
+        string side = armType;
+        if (side == "selectable")
+        {
+            Vector x1,x2;
+            (O2R*P2O1).getPosition(x1);
+            (O2R*P2O2).getPosition(x2);
+            side = selectArm(x1,x2,frame,(c[1] >= 0.0) ? "right" : "left");
+        }
+
+        if (side == "right")
+        {
+            iCartCtrl = iCartCtrlR;
+            fi = 120;
+        }
+        else
+        {
+            iCartCtrl = iCartCtrlL;
+            fi =  -120;
+        }
+
+        if (pose==0)
+        {
+            fi = 0;
+            psi = -50;
+        }
+
+        float fi_rad  = CTRL_DEG2RAD*fi;
+        float psi_rad = CTRL_DEG2RAD*psi;
+
+        SE3 Ax;
+        Ax.setRotation(1.0,           0.0,          0.0,
+                       0.0,  cos(fi_rad), sin(fi_rad),
+                       0.0, -sin(fi_rad), cos(fi_rad));
+
+        SE3 Az;
+        Az.setRotation( cos(psi_rad), sin(psi_rad), 0.0,
+                       -sin(psi_rad), cos(psi_rad), 0.0,
+                                 0.0,          0.0, 1.0);
+
+        SE3 HR;
+        HR.setRotation(-1.0,  0.0,  0.0,
+                        0.0,  0.0, -1.0,
+                        0.0, -1.0,  0.0);
+
+        H2P = HR*Ax*Az;
+
+        // Transformation: Tool frame to Hand frame. Translation of origin from tool tip to hand palm center
+        SE3 T2H = SE3(frame).inverse();
+
+        // Transformation: Tool frame to robot frame, its the combination off all the single transformations
+        SE3 T2R;
+
+        T2R = O2R*P2O1*H2P;
+
+        Vector xd1,od1;
+        T2R.getPosition(xd1);
+        T2R.getAxis(od1);
+
+        printf("in-place locations...\n");
+        printf("xd1=(%s) od1=(%s)\n",xd1.toString(3,3).c_str(),od1.toString(3,3).c_str());
+
+        T2R = T2R*T2H;
+
+        T2R.getPosition(xd1);
+        T2R.getAxis(od1);
+
+        printf("apply tool (if any)...\n");
+        printf("xd1=(%s) od1=(%s)\n",xd1.toString(3,3).c_str(),od1.toString(3,3).c_str());
+
+        // the arm is granted to this action only, along with the
+        // workspace it sweeps
+        deque<Vector> waypoints;
+        const SE3 *P2O[4] = {&P2O0,&P2O1,&P2O2,&P2O3};
+        for (int i=0; i<4; i++)
+        {
+            Vector x;
+            (O2R*(*P2O[i])*H2P*T2H).getPosition(x);
+            waypoints.push_back(x);
+        }
+
+        int arm=getArmIndex(iCartCtrl);
+        record.setArm(side);
+        record.begin("arbiter");
+        if (!arbiter.acquire(arm,&control.interrupt))
+        {
+            record.end(false);
+            telemetry.publish(record);
+            return false;
+        }
+        record.end();
+
+        record.begin("reserve");
+        if (!arbiter.reserve(arm,waypoints,&control.interrupt,&control.blocking))
+        {
+            record.end(false);
+            telemetry.publish(record);
+            arbiter.release(arm,false);
+            return false;
+        }
+        record.end();
+
+        // deal with the arm context
+        record.begin("context");
+        int context;
+        iCartCtrl->storeContext(&context);
+
+        Bottle options;
+        Bottle &straightOpt = options.addList();
+        straightOpt.addString("straightness");
+        straightOpt.addDouble(10.0);
+        iCartCtrl->tweakSet(options);
+        //changeElbowHeight();
+
+        Vector dof;
+        iCartCtrl->getDOF(dof);
+
+        dof=1.0; dof[1]=0.0;
+        iCartCtrl->setDOF(dof,dof);
+        record.end();
+
+        // execute the movement
+        Vector xd;
+        Vector od;
+        if (!control.interrupt)
+        {
+            T2R = O2R*P2O0*H2P*T2H;
+            T2R.getPosition(xd);
+            T2R.getAxis(od);
+
+            printf("moving to: x=(%s); o=(%s)\n",xd.toString(3,3).c_str(),od.toString(3,3).c_str());
+            record.begin("approach");
+            iCartCtrl->goToPoseSync(xd,od,1.0);
+            record.end(iCartCtrl->waitMotionDone(0.1,4.0));
+        }
+
+        if (!control.interrupt)
+        {
+            T2R = O2R*P2O1*H2P*T2H;
+            T2R.getPosition(xd);
+            T2R.getAxis(od);
+
+            printf("moving to: x=(%s); o=(%s)\n",xd.toString(3,3).c_str(),od.toString(3,3).c_str());
+            record.begin("descend");
+            iCartCtrl->goToPoseSync(xd,od,1.0);
+            record.end(iCartCtrl->waitMotionDone(0.1,4.0));
+        }
+
+        if (!control.interrupt)
+        {
+            T2R = O2R*P2O2*H2P*T2H;
+            T2R.getPosition(xd);
+            T2R.getAxis(od);
+
+            printf("moving to: x=(%s); o=(%s)\n",xd.toString(3,3).c_str(),od.toString(3,3).c_str());
+            record.begin("push");
+            iCartCtrl->goToPoseSync(xd,od,mov_time);
+            record.end(iCartCtrl->waitMotionDone(0.1,3.0));
+        }
+
+        if (!control.interrupt)
+        {
+            T2R = O2R*P2O3*H2P*T2H;
+            T2R.getPosition(xd);
+            T2R.getAxis(od);
+
+            printf("moving to: x=(%s); o=(%s)\n",xd.toString(3,3).c_str(),od.toString(3,3).c_str());
+            record.begin("retract");
+            iCartCtrl->goToPoseSync(xd,od,1.0);
+            record.end(iCartCtrl->waitMotionDone(0.1,2.0));
+        }
+
+        if (!control.interrupt)
+            record.measurePoseError(iCartCtrl,xd,od);
+
+        iCartCtrl->restoreContext(context);
+        iCartCtrl->deleteContext(context);
+        arbiter.release(arm);
+        telemetry.publish(record);
+
+        return true;
+    }
+
+    /************************************************************************/
+    ICartesianControl *getDrawPoses(const Vector &c, const double theta, const double radius,
+                                    const double dist, const string &armType, const Matrix &frame,
+                                    Vector &xd1, Vector &od1, Vector &xd2, Vector &od2,
+                                    const bool verbose=true)
+    {
+        // wrt root frame: frame centered at c0, the projection of c on
+        // the sagittal plane, with x-axis pointing rightward, y-axis
+        // pointing forward and z-axis pointing upward
+        SE3 H0;
+        H0.setRotation(0.0,-1.0,0.0,
+                       1.0, 0.0,0.0,
+                       0.0, 0.0,1.0);
+        H0.setTranslation(c[0],0.0,c[2]);
+
+        double theta_rad=CTRL_DEG2RAD*theta;
+        double _c=cos(theta_rad);
+        double _s=sin(theta_rad);
+
+        // wrt H0 frame: frame translated in R*[_c,_s]
+        SE3 H1;
+        H1.setTranslation(radius*_c,radius*_s,0.0);
+
+        // wrt H1 frame: frame translated in [0,-dist]
+        SE3 H2;
+        H2.setTranslation(0.0,-dist,0.0);
+
+        // go back into root frame
+        H2=H0*H1*H2;
+        H1=H0*H1;
+
+        // apply final axes (the same for both arms)
+        H1.setRotation(-1.0, 0.0, 0.0,
+                        0.0, 0.0,-1.0,
+                        0.0,-1.0, 0.0);
+        H2.setRotation(-1.0, 0.0, 0.0,
+                        0.0, 0.0,-1.0,
+                        0.0,-1.0, 0.0);
+
+        if (verbose)
+        {
+            H1.getPosition(xd1); H1.getAxis(od1);
+            H2.getPosition(xd2); H2.getAxis(od2);
+
+            printf("identified locations on the sagittal plane...\n");
+            printf("xd1=(%s) od1=(%s)\n",xd1.toString(3,3).c_str(),od1.toString(3,3).c_str());
+            printf("xd2=(%s) od2=(%s)\n",xd2.toString(3,3).c_str(),od2.toString(3,3).c_str());
+        }
+
+        // choose the arm
+        ICartesianControl *arm;
+        if (armType=="selectable")
+        {
+            if (H1.p[1]>=0.0)
+                arm=iCartCtrlR;
+            else
+                arm=iCartCtrlL;
+        }
+        else if (armType=="left")
+            arm=iCartCtrlL;
+        else
+            arm=iCartCtrlR;
+
+        // recover the original place: do translation and rotation
+        if (c[1]!=0.0)
+        {
+            SE3 H=SE3::rotation(0.0,0.0,-1.0,atan2(c[1],fabs(c[0])));
+
+            H.setTranslation(H1.p[0],H1.p[1]+c[1],H1.p[2]);
+            H1.setTranslation(0.0,0.0,0.0);
+            H1=H*H1;
+
+            H.setTranslation(H2.p[0],H2.p[1]+c[1],H2.p[2]);
+            H2.setTranslation(0.0,0.0,0.0);
+            H2=H*H2;
+        }
+
+        if (verbose)
+        {
+            H1.getPosition(xd1); H1.getAxis(od1);
+            H2.getPosition(xd2); H2.getAxis(od2);
+
+            printf("in-place locations...\n");
+            printf("xd1=(%s) od1=(%s)\n",xd1.toString(3,3).c_str(),od1.toString(3,3).c_str());
+            printf("xd2=(%s) od2=(%s)\n",xd2.toString(3,3).c_str(),od2.toString(3,3).c_str());
+        }
+
+        // apply tool (if any)
+        SE3 invFrame=SE3(frame).inverse();
+        H1=H1*invFrame;
+        H2=H2*invFrame;
+
+        H1.getPosition(xd1); H1.getAxis(od1);
+        H2.getPosition(xd2); H2.getAxis(od2);
+
+        if (verbose)
+        {
+            printf("apply tool (if any)...\n");
+            printf("xd1=(%s) od1=(%s)\n",xd1.toString(3,3).c_str(),od1.toString(3,3).c_str());
+            printf("xd2=(%s) od2=(%s)\n",xd2.toString(3,3).c_str(),od2.toString(3,3).c_str());
+        }
+
+        if (armType=="selectable")
+            arm=selectArm(xd1,od1,xd2,od2,frame,arm);
+
+        return arm;
+    }
+
+    /************************************************************************/
+    double draw(ActionControl &control, bool simulation, const Vector &c, const double theta, const double radius,
+                const double dist, const string &armType, const Matrix &frame=eye(4,4))
+    {
+        ActionRecord record(simulation?"vdraw":"draw");
+        record.setId(control.id);
+        record.begin("plan");
+        Vector xd1,od1,xd2,od2;
+        ICartesianControl *iCartCtrl=getDrawPoses(c,theta,radius,dist,armType,frame,
+                                                  xd1,od1,xd2,od2);
+        record.setArm(getArmName(iCartCtrl));
+        record.end();
+
+        // the arm is granted to this action only, as its context
+        // gets modified also by the simulation
+        int arm=getArmIndex(iCartCtrl);
+        record.begin("arbiter");
+        if (!arbiter.acquire(arm,&control.interrupt))
+        {
+            record.end(false);
+            telemetry.publish(record);
+            return (simulation?SWEEP_PRUNED_QUALITY:0.0);
+        }
+        record.end();
+
+        // deal with the arm context
+        record.begin("context");
+        int context;
+        iCartCtrl->storeContext(&context);
+
+        Bottle options;
+        Bottle &straightOpt=options.addList();
+        straightOpt.addString("straightness");
+        straightOpt.addDouble(30.0);
+        iCartCtrl->tweakSet(options);
+        changeElbowHeight(iCartCtrl);
+
+        Vector dof;
+        iCartCtrl->getDOF(dof);
+
+        dof=1.0; dof[1]=0.0;
+        iCartCtrl->setDOF(dof,dof);
+        record.end();
+
+        double res=0.0;
+
+        // simulate the movements
+        if (simulation)
+        {
+            // the second pose is reached from the first one
+            record.begin("ik");
+            deque<IKQuery> query(1);
+            query[0].xd=xd1; query[0].od=od1;
+            askForPoses(iCartCtrl,query,dof,true);
+            Vector xdhat1=query[0].xdhat,odhat1=query[0].odhat;
+
+            query[0].q0=query[0].qdhat;
+            query[0].xd=xd2; query[0].od=od2;
+            askForPoses(iCartCtrl,query,dof,true);
+            Vector xdhat2=query[0].xdhat,odhat2=query[0].odhat;
+            record.end();
+
+            double e_x1=norm(xd1-xdhat1);
+            double e_o1=norm(od1-odhat1);
+            printf("testing x=(%s); o=(%s) => xhat=(%s); ohat=(%s) ... |e_x|=%g; |e_o|=%g\n",
+                   xd1.toString(3,3).c_str(),od1.toString(3,3).c_str(),
+                   xdhat1.toString(3,3).c_str(),odhat1.toString(3,3).c_str(),
+                   e_x1,e_o1);
+
+            double e_x2=norm(xd2-xdhat2);
+            double e_o2=norm(od2-odhat2);
+            printf("testing x=(%s); o=(%s) => xhat=(%s); ohat=(%s) ... |e_x|=%g; |e_o|=%g\n",
+                   xd2.toString(3,3).c_str(),od2.toString(3,3).c_str(),
+                   xdhat2.toString(3,3).c_str(),odhat2.toString(3,3).c_str(),
+                   e_x2,e_o2);
+
+            double nearness_penalty=((norm(xdhat1)<0.15)||(norm(xdhat2)<0.15)?10.0:0.0);
+            printf("nearness penalty=%g\n",nearness_penalty);
+            res=e_x1+e_o1+e_x2+e_o2+nearness_penalty;
+            printf("final quality=%g\n",res);
+        }
+        // execute the movements
+        else
+        {
+            Vector offs(3,0.0); offs[2]=0.05;
+            deque<Vector> waypoints;
+            waypoints.push_back(xd1+offs);
+            waypoints.push_back(xd1);
+            waypoints.push_back(xd2);
+            record.begin("reserve");
+            bool granted=arbiter.reserve(arm,waypoints,&control.interrupt,&control.blocking);
+            record.end(granted);
+
+            if (granted && !control.interrupt)
+            {
+                Vector x=xd1+offs;
+
+                printf("moving to: x=(%s); o=(%s)\n",x.toString(3,3).c_str(),od1.toString(3,3).c_str());
+                record.begin("approach");
+                iCartCtrl->goToPoseSync(x,od1,2.0);
+                record.end(iCartCtrl->waitMotionDone(0.1,5.0));
+            }
+
+            if (granted && !control.interrupt)
+            {
+                printf("moving to: x=(%s); o=(%s)\n",xd1.toString(3,3).c_str(),od1.toString(3,3).c_str());
+                record.begin("descend");
+                iCartCtrl->goToPoseSync(xd1,od1,1.5);
+                record.end(iCartCtrl->waitMotionDone(0.1,5.0));
+            }
+
+            if (granted && !control.interrupt)
+            {
+                printf("moving to: x=(%s); o=(%s)\n",xd2.toString(3,3).c_str(),od2.toString(3,3).c_str());
+                record.begin("draw");
+                iCartCtrl->goToPoseSync(xd2,od2,3.5);
+                record.end(iCartCtrl->waitMotionDone(0.1,5.0));
+                record.measurePoseError(iCartCtrl,xd2,od2);
+            }
+        }
+
+        iCartCtrl->restoreContext(context);
+        iCartCtrl->deleteContext(context);
+        arbiter.release(arm,!simulation);
+        telemetry.publish(record);
+
+        return res;
+    }
+
+    /************************************************************************/
+    double getDrawQuality(const IKQuery &query1, const IKQuery &query2)
+    {
+        // the same figure returned by the virtual draw
+        double nearness_penalty=((norm(query1.xdhat)<0.15)||(norm(query2.xdhat)<0.15)?10.0:0.0);
+        return norm(query1.xd-query1.xdhat)+norm(query1.od-query1.odhat)+
+               norm(query2.xd-query2.xdhat)+norm(query2.od-query2.odhat)+
+               nearness_penalty;
+    }
+
+    /************************************************************************/
+    void sweepDraw(ActionControl &control, const Vector &c, const deque<double> &thetas, const deque<double> &radii,
+                   const deque<double> &dists, const string &armType, const Matrix &frame,
+                   deque<DrawCandidate> &candidates)
+    {
+        candidates.clear();
+        for (size_t i=0; i<thetas.size(); i++)
+        {
+            for (size_t j=0; j<radii.size(); j++)
+            {
+                for (size_t k=0; k<dists.size(); k++)
+                {
+                    DrawCandidate candidate;
+                    candidate.theta=thetas[i];
+                    candidate.radius=radii[j];
+                    candidate.dist=dists[k];
+                    // unevaluated until the solver says otherwise
+                    candidate.quality=SWEEP_PRUNED_QUALITY;
+                    candidate.arm=getDrawPoses(c,thetas[i],radii[j],dists[k],armType,frame,
+                                               candidate.xd1,candidate.od1,
+                                               candidate.xd2,candidate.od2,false);
+
+                    // candidates out of reach according to the map
+                    // skip the solver
+                    double e1=getReachError(candidate.arm,candidate.xd1,candidate.od1,frame);
+                    double e2=getReachError(candidate.arm,candidate.xd2,candidate.od2,frame);
+                    candidate.pruned=((e1>reach_thres) || (e2>reach_thres));
+
+                    candidates.push_back(candidate);
+                }
+            }
+        }
+
+        // one batch per arm, within the same context of the draw
+        ICartesianControl *arms[2]={iCartCtrlL,iCartCtrlR};
+        for (int a=0; a<2; a++)
+        {
+            deque<size_t> idx;
+            for (size_t i=0; i<candidates.size(); i++)
+                if ((candidates[i].arm==arms[a]) && !candidates[i].pruned)
+                    idx.push_back(i);
+
+            if (idx.size()==0)
+                continue;
+
+            ICartesianControl *iCartCtrl=arms[a];
+            if (!arbiter.acquire(a,&control.interrupt))
+                break;
+
+            int context;
+            iCartCtrl->storeContext(&context);
+
+            Bottle options;
+            Bottle &straightOpt=options.addList();
+            straightOpt.addString("straightness");
+            straightOpt.addDouble(30.0);
+            iCartCtrl->tweakSet(options);
+            changeElbowHeight(iCartCtrl);
+
+            Vector dof;
+            iCartCtrl->getDOF(dof);
+
+            dof=1.0; dof[1]=0.0;
+            iCartCtrl->setDOF(dof,dof);
+
+            deque<IKQuery> queries1(idx.size());
+            for (size_t i=0; i<idx.size(); i++)
+            {
+                queries1[i].xd=candidates[idx[i]].xd1;
+                queries1[i].od=candidates[idx[i]].od1;
+            }
+            askForPoses(iCartCtrl,queries1,dof,true);
+
+            // the second poses are reached from the first ones
+            deque<IKQuery> queries2(idx.size());
+            for (size_t i=0; i<idx.size(); i++)
+            {
+                queries2[i].q0=queries1[i].qdhat;
+                queries2[i].xd=candidates[idx[i]].xd2;
+                queries2[i].od=candidates[idx[i]].od2;
+            }
+            askForPoses(iCartCtrl,queries2,dof,true);
+
+            for (size_t i=0; i<idx.size(); i++)
+                candidates[idx[i]].quality=getDrawQuality(queries1[i],queries2[i]);
+
+            iCartCtrl->restoreContext(context);
+            iCartCtrl->deleteContext(context);
+            arbiter.release(a,false);
+        }
+
+        printf("sweep: %d candidates evaluated\n",(int)candidates.size());
+    }
+
+    /************************************************************************/
+    double draw2(ActionControl &control, bool simulation, const int pose, const Vector &c, const double theta, const double radius,
+                const double dist, const string &armType, const Matrix &frame=eye(4,4))
+    {
+        ICartesianControl *iCartCtrl;
+
+        // wrt root frame: frame centered at c0, the projection of c on
+        // the sagittal plane, with x-axis pointing rightward, y-axis
+        // pointing forward and z-axis pointing upward
+        SE3 H0;
+        H0.setRotation(0.0,-1.0,0.0,
+                       1.0, 0.0,0.0,
+                       0.0, 0.0,1.0);
+        H0.setTranslation(c[0],0.0,c[2]);
+
+        double theta_rad=CTRL_DEG2RAD*(theta-90);
+        double _c=cos(theta_rad);
+        double _s=sin(theta_rad);
+
+        // wrt H0 frame: frame translated in R*[_c,_s]
+        SE3 H1;
+        H1.setTranslation(radius*_c,radius*_s,0.0);
+
+        // wrt H1 frame: frame translated in [0,-dist]
+        SE3 H2;
+        H2.setTranslation(0.0,-dist,0.0);
+
+        // go back into root frame
+        H2=H0*H1*H2;
+        H1=H0*H1;
+
+        // choose the arm
+        if (armType=="selectable") {
+            if (c[1]>=0.0)
+                iCartCtrl=iCartCtrlR;
+            else
+                iCartCtrl=iCartCtrlL;
+        }
+        else if (armType=="left")
+            iCartCtrl=iCartCtrlL;
+        else
+            iCartCtrl=iCartCtrlR;
+
+
+        // apply final axes
+        //pose=0 rotation=neutral | pose=1 rotation=pronation
+        float fi  = 0;
+        float psi = -30;
+        if (iCartCtrl==iCartCtrlR) {
+            if (pose==0) {
+                fi  = 0;
+                psi = -50;
+            }
+            else {
+                fi  = 120;
+                psi = -30;
+            }
+        }
+        else {
+            if (pose==0) {
+                fi  = 0;
+                psi = -50;
+            }
+            else {
+                fi  =  -120;
+                psi = -30;
+            }
+        }
+
+        float fi_rad  = CTRL_DEG2RAD*fi;
+        float psi_rad = CTRL_DEG2RAD*psi;
+
+        SE3 Ax;
+        Ax.setRotation(1.0,           0.0,          0.0,
+                       0.0,  cos(fi_rad), sin(fi_rad),
+                       0.0, -sin(fi_rad), cos(fi_rad));
+
+        SE3 Az;
+        Az.setRotation( cos(psi_rad), sin(psi_rad), 0.0,
+                       -sin(psi_rad), cos(psi_rad), 0.0,
+                                 0.0,          0.0, 1.0);
+
+        SE3 HR;
+        HR.setRotation(-1.0,  0.0,  0.0,
+                        0.0,  0.0, -1.0,
+                        0.0, -1.0,  0.0);
+
+        SE3 R = HR*Ax*Az;
+        H1.setRotation(R);
+        H2.setRotation(R);
+
+        Vector xd1,od1,xd2,od2;
+        H1.getPosition(xd1); H1.getAxis(od1);
+        H2.getPosition(xd2); H2.getAxis(od2);
+
+        printf("identified locations on the sagittal plane...\n");
+        printf("xd1=(%s) od1=(%s)\n",xd1.toString(3,3).c_str(),od1.toString(3,3).c_str());
+
+        // recover the original place: do translation and rotation
+        if (c[1]!=0.0) {
+            SE3 H=SE3::rotation(0.0,0.0,-1.0,0.0/*atan2(c[1],fabs(c[0]))*/);
+
+            H.setTranslation(H1.p[0],H1.p[1]+c[1],H1.p[2]);
+            H1.setTranslation(0.0,0.0,0.0);
+            H1=H*H1;
+
+            H.setTranslation(H2.p[0],H2.p[1]+c[1],H2.p[2]);
+            H2.setTranslation(0.0,0.0,0.0);
+            H2=H*H2;
+
+            H1.getPosition(xd1); H1.getAxis(od1);
+            H2.getPosition(xd2); H2.getAxis(od2);
+        }
+
+        printf("in-place locations...\n");
+        printf("xd1=(%s) od1=(%s)\n",xd1.toString(3,3).c_str(),od1.toString(3,3).c_str());
+
+        // apply tool (if any)
+        SE3 invFrame=SE3(frame).inverse();
+        H1=H1*invFrame;
+        H2=H2*invFrame;
+
+        H1.getPosition(xd1); H1.getAxis(od1);
+        H2.getPosition(xd2); H2.getAxis(od2);
+
+        printf("apply tool (if any)...\n");
+        printf("xd1=(%s) od1=(%s)\n",xd1.toString(3,3).c_str(),od1.toString(3,3).c_str());
+
+        // the arm is granted to this action only
+        int arm=getArmIndex(iCartCtrl);
+        if (!arbiter.acquire(arm,&control.interrupt))
+            return (simulation?SWEEP_PRUNED_QUALITY:0.0);
+
+        // deal with the arm context
+        int context;
+        iCartCtrl->storeContext(&context);
+
+        Bottle options;
+        Bottle &straightOpt=options.addList();
+        straightOpt.addString("straightness");
+        straightOpt.addDouble(30.0);
+        iCartCtrl->tweakSet(options);
+
+        Vector dof;
+        iCartCtrl->getDOF(dof);
+
+        dof=1.0; dof[1]=0.0;
+        iCartCtrl->setDOF(dof,dof);
+
+        double res=0.0;
+
+        // simulate the movements
+        if (simulation) {
+            // the second pose is reached from the first one
+            deque<IKQuery> query(1);
+            query[0].xd=xd1; query[0].od=od1;
+            askForPoses(iCartCtrl,query,dof,false);
+            Vector xdhat1=query[0].xdhat,odhat1=query[0].odhat;
+
+            query[0].q0=query[0].qdhat;
+            query[0].xd=xd2; query[0].od=od2;
+            askForPoses(iCartCtrl,query,dof,false);
+            Vector xdhat2=query[0].xdhat,odhat2=query[0].odhat;
+
+            double e_x1=norm(xd1-xdhat1);
+            double e_o1=norm(od1-odhat1);
+            printf("testing x=(%s); o=(%s) => xhat=(%s); ohat=(%s) ... |e_x|=%g; |e_o|=%g\n",
+                   xd1.toString(3,3).c_str(),od1.toString(3,3).c_str(),
+                   xdhat1.toString(3,3).c_str(),odhat1.toString(3,3).c_str(),
+                   e_x1,e_o1);
+
+            double e_x2=norm(xd2-xdhat2);
+            double e_o2=norm(od2-odhat2);
+            printf("testing x=(%s); o=(%s) => xhat=(%s); ohat=(%s) ... |e_x|=%g; |e_o|=%g\n",
+                   xd2.toString(3,3).c_str(),od2.toString(3,3).c_str(),
+                   xdhat2.toString(3,3).c_str(),odhat2.toString(3,3).c_str(),
+                   e_x2,e_o2);
+
+            double nearness_penalty=(norm(xdhat2)<0.15?10.0:0.0);
+            printf("nearness penalty=%g\n",nearness_penalty);
+            res=e_x1+e_o1+e_x2+e_o2+nearness_penalty;
+            printf("final quality=%g\n",res);
+        }
+        // execute the movements
+        else {
+            Vector offs(3,0.0); offs[2]=0.05;
+            deque<Vector> waypoints;
+            waypoints.push_back(xd1+offs);
+            waypoints.push_back(xd1);
+            waypoints.push_back(xd2);
+            bool granted=arbiter.reserve(arm,waypoints,&control.interrupt,&control.blocking);
+
+            if (granted && !control.interrupt) {
+                Vector x=xd1+offs;
+
+                printf("moving to: x=(%s); o=(%s)\n",x.toString(3,3).c_str(),od1.toString(3,3).c_str());
+                iCartCtrl->goToPoseSync(x,od1,2.0);
+                iCartCtrl->waitMotionDone(0.1,5.0);
+            }
+
+            if (granted && !control.interrupt) {
+                printf("moving to: x=(%s); o=(%s)\n",xd1.toString(3,3).c_str(),od1.toString(3,3).c_str());
+                iCartCtrl->goToPoseSync(xd1,od1,1.5);
+                iCartCtrl->waitMotionDone(0.1,5.0);
+            }
+
+            if (granted && !control.interrupt) {
+                printf("moving to: x=(%s); o=(%s)\n",xd2.toString(3,3).c_str(),od2.toString(3,3).c_str());
+                iCartCtrl->goToPoseSync(xd2,od2,mov_time); //3.5
+                iCartCtrl->waitMotionDone(0.1,5.0);
+            }
+        }
+
+        iCartCtrl->restoreContext(context);
+        iCartCtrl->deleteContext(context);
+        arbiter.release(arm,!simulation);
+
+        return res;
+    }
+
+    /************************************************************************/
+    void moveTool(ActionControl &control, const string &arm, const string &eye, const Vector &xd, const Vector &od,
+                  const Vector &xOffset, const int maxItems, ActionRecord &record)
+    {
+        ICartesianControl *iCartCtrl=(arm=="left")?iCartCtrlL:iCartCtrlR;
+        iGaze->restoreContext(0);
+
+        if (!control.interrupt)
+        {
+            iGaze->setTrackingMode(true);
+            iGaze->lookAtFixationPoint(xd+xOffset);
+            record.begin("reach");
+            iCartCtrl->goToPoseSync(xd,od,1.0);
+            record.end(iCartCtrl->waitMotionDone(0.1));
+        }
+
+        iGaze->setSaccadesStatus(false);
+        iGaze->setNeckTrajTime(2.5);
+        iGaze->setEyesTrajTime(1.5);
+
+        // shake the hand to ease the detection of the tool tip
+        if (!control.interrupt)
+            handShaker->startShaking(arm,shake_joint);
+
+        // gaze robustly at the tool tip: the detections drive
+        // the gaze directly from the port callback
+        record.begin("gaze");
+        visionPort.track(iGaze,eye=="right"?1:0);
+        bool settled=false;
+        while (!control.interrupt && !settled)
+            settled=visionPort.waitSettled(0.1);
+        record.end(settled);
+
+        // gather sufficient information
+        record.begin("acquire");
+        Bottle command,reply;
+        command.addVocab(Vocab::encode("enable"));
+        finderPort.write(command,reply);
+
+        command.clear();
+        command.addVocab(Vocab::encode("num"));
+        finderPort.write(command,reply);
+        int curItems=reply.get(1).asInt();
+
+        // the finder notifies the number of items as they come;
+        // it is polled only if it does not stream its status
+        if (finderStatusPort.getInputCount()>0)
+        {
+            finderStatusPort.setTarget(curItems+maxItems);
+            while (!control.interrupt && !finderStatusPort.waitTarget(0.1));
+        }
+        else
+        {
+            int nItems=0;
+            while (!control.interrupt && (nItems<curItems+maxItems))
+            {
+                finderPort.write(command,reply);
+                nItems=reply.get(1).asInt();
+                Time::delay(0.1);
+            }
+        }
+
+        command.clear();
+        command.addVocab(Vocab::encode("disable"));
+        finderPort.write(command,reply);
+        record.end(!control.interrupt);
+
+        visionPort.stopTracking();
+        handShaker->stopShaking();
+    }
+
+    /************************************************************************/
+    void getCandidatePoses(const string &arm, deque<ExplorationPose> &candidates)
+    {
+        Matrix R(4,4);
+        R(0,0)=-1.0;
+        R(2,1)=-1.0;
+        R(1,2)=-1.0;
+        R(3,3)=+1.0;
+
+        // the same family of poses used in the fixed exploration
+        double xs[]={-0.35,-0.3};
+        double ys[]={0.0,0.1,0.15};
+        double zs[]={-0.05,0.05,0.15};
+        double rots[]={0.0,20.0,45.0};
+
+        Vector r1(4,0.0); r1[2]=(arm=="left")?-1.0:1.0; r1[3]=CTRL_DEG2RAD*45.0;
+        Vector r2(4,0.0); r2[0]=(arm=="left")?1.0:-1.0; r2[3]=CTRL_DEG2RAD*45.0;
+
+        candidates.clear();
+        for (int i=0; i<2; i++)
+        {
+            for (int j=0; j<3; j++)
+            {
+                for (int k=0; k<3; k++)
+                {
+                    ExplorationPose pose;
+                    pose.xd.resize(3);
+                    pose.xd[0]=xs[i];
+                    pose.xd[1]=(arm=="left")?-ys[j]:ys[j];
+                    pose.xd[2]=zs[k];
+
+                    pose.offset.resize(3,0.0);
+                    pose.offset[1]=(arm=="left")?0.1:-0.1;
+                    pose.offset[2]=0.1;
+                    pose.shake_joint=4;
+                    pose.reachable=false;
+
+                    for (int l=0; l<3; l++)
+                    {
+                        Vector r(4,0.0); r[0]=-1.0;
+                        r[3]=CTRL_DEG2RAD*(arm=="left"?rots[l]:-rots[l]);
+                        pose.od=dcm2axis(axis2dcm(r)*R);
+                        candidates.push_back(pose);
+                    }
+
+                    pose.od=dcm2axis(axis2dcm(r2)*axis2dcm(r1)*R);
+                    pose.offset[1]=(arm=="left")?-0.05:0.05;
+                    pose.shake_joint=6;
+                    candidates.push_back(pose);
+                }
+            }
+        }
+    }
+
+    /************************************************************************/
+    bool isReachable(const IKQuery &query)
+    {
+        if (!query.ok)
+            return false;
+
+        Matrix Rd=axis2dcm(query.od).submatrix(0,2,0,2);
+        Matrix Rhat=axis2dcm(query.odhat).submatrix(0,2,0,2);
+        double angle=dcm2axis(Rd.transposed()*Rhat)[3];
+
+        return ((norm(query.xd-query.xdhat)<0.02) && (fabs(angle)<CTRL_DEG2RAD*10.0));
+    }
+
+    /************************************************************************/
+    bool checkReachable(ICartesianControl *iCartCtrl, ExplorationPose &pose)
+    {
+        // the candidates are checked lazily, only when they
+        // come up as the best ones
+        if (pose.reachable)
+            return true;
+
+        Vector dof;
+        iCartCtrl->getDOF(dof);
+
+        deque<IKQuery> query(1);
+        query[0].xd=pose.xd;
+        query[0].od=pose.od;
+        askForPoses(iCartCtrl,query,dof,false);
+
+        pose.reachable=isReachable(query[0]);
+        return pose.reachable;
+    }
+
+    /************************************************************************/
+    Matrix predictInformation(const ExplorationPose &pose, const Vector &x,
+                              const deque<Vector> &cameras, const double f,
+                              const double sigma2, const int nItems)
+    {
+        // each pixel constrains the tip in the plane orthogonal to
+        // the viewing ray, with an information proportional to
+        // (f/depth)^2 and expressed here in the hand frame
+        Matrix Rh=axis2dcm(pose.od).submatrix(0,2,0,2);
+        Vector p=pose.xd+Rh*x;
+
+        Matrix info(3,3); info.zero();
+        for (size_t i=0; i<cameras.size(); i++)
+        {
+            Vector d=p-cameras[i];
+            double depth=norm(d);
+            if (depth<1e-3)
+                continue;
+            d=d/depth;
+
+            Matrix P=eye(3,3)-outerProduct(d,d);
+            info=info+(nItems*f*f/(sigma2*depth*depth))*(Rh.transposed()*P*Rh);
+        }
+
+        return info;
+    }
+
+    /************************************************************************/
+    bool getFinderEstimate(Vector &x, Matrix &cov, double &error)
+    {
+        // a single-start estimate is enough to drive the planning,
+        // the full search being left to the end of the exploration
+        Bottle command,reply;
+        command.addVocab(Vocab::encode("find"));
+        command.addString("fast");
+        finderPort.write(command,reply);
+
+        if ((reply.get(0).asVocab()!=Vocab::encode("ack")) || (reply.size()<4))
+            return false;
+
+        x.resize(3);
+        for (int i=0; i<3; i++)
+            x[i]=reply.get(1+i).asDouble();
+
+        error=reply.find("error").asDouble();
+
+        Bottle &covPart=reply.findGroup("cov");
+        if (covPart.size()<10)
+            return false;
+
+        cov.resize(3,3);
+        for (int r=0; r<3; r++)
+            for (int c=0; c<3; c++)
+                cov(r,c)=covPart.get(1+3*r+c).asDouble();
+
+        return true;
+    }
+
+    /************************************************************************/
+    void planExploration(ActionControl &control, const string &arm, const string &eye, ActionRecord &record)
+    {
+        ICartesianControl *iCartCtrl=(arm=="left")?iCartCtrlL:iCartCtrlR;
+        deque<ExplorationPose> candidates;
+        getCandidatePoses(arm,candidates);
+        int nChecked=0;
+
+        // camera centers, focal length and a guess of the noise
+        // until the finder provides its own estimates
+        deque<Vector> cameras;
+        Vector xe,oe;
+        if (eye!="right")
+        {
+            iGaze->getLeftEyePose(xe,oe);
+            cameras.push_back(xe);
+        }
+        if (eye!="left")
+        {
+            iGaze->getRightEyePose(xe,oe);
+            cameras.push_back(xe);
+        }
+
+        double f=257.0;
+        Bottle info;
+        iGaze->getInfo(info);
+        if (Bottle *pB=info.find("camera_intrinsics_left").asList())
+            f=pB->get(0).asDouble();
+
+        Vector x(3,0.0);
+        double sigma2=4.0;
+        Matrix I=1e-6*yarp::math::eye(3,3);
+        Matrix Iexplored=I;
+
+        for (int n=0; (n<find_max_poses) && !control.interrupt && (candidates.size()>0); n++)
+        {
+            // the uncertainty of the current estimate is used as soon
+            // as it is available
+            Matrix cov;
+            double error;
+            if ((n>=2) && getFinderEstimate(x,cov,error))
+            {
+                Matrix U(3,3),V(3,3);
+                Vector S(3);
+                SVD(cov,U,S,V);
+                printf("exploration: pose #%d; uncertainty=%g [m]\n",n,sqrt(S[0]));
+                if (sqrt(S[0])<find_tol)
+                    break;
+
+                I=pinv(cov);
+                sigma2=std::max(2.0*error*error/M_PI,0.25);
+            }
+            else
+                I=Iexplored;
+
+            // D-optimal choice: the candidates are ranked by gain and
+            // the first reachable one is taken, dropping the others
+            deque<pair<double,size_t> > ranking;
+            for (size_t i=0; i<candidates.size(); i++)
+            {
+                Matrix Ic=predictInformation(candidates[i],x,cameras,f,sigma2,find_items);
+                ranking.push_back(make_pair(-det(I+Ic),i));
+            }
+            sort(ranking.begin(),ranking.end());
+
+            int best=-1;
+            deque<size_t> unreachable;
+            for (size_t i=0; (i<ranking.size()) && !control.interrupt; i++)
+            {
+                ExplorationPose &candidate=candidates[ranking[i].second];
+                if (!candidate.reachable)
+                    nChecked++;
+
+                if (checkReachable(iCartCtrl,candidate))
+                {
+                    best=(int)ranking[i].second;
+                    break;
+                }
+
+                unreachable.push_back(ranking[i].second);
+            }
+
+            if (best<0)
+                break;
+
+            ExplorationPose pose=candidates[best];
+            unreachable.push_back(best);
+            sort(unreachable.begin(),unreachable.end());
+            for (size_t i=unreachable.size(); i>0; i--)
+                candidates.erase(candidates.begin()+unreachable[i-1]);
+
+            Iexplored=Iexplored+predictInformation(pose,x,cameras,f,sigma2,find_items);
+            shake_joint=pose.shake_joint;
+            moveTool(control,arm,eye,pose.xd,pose.od,pose.offset,find_items,record);
+        }
+
+        printf("exploration: %d candidates checked for reachability\n",nChecked);
+    }
+
+    /************************************************************************/
+    bool findToolTip(ActionControl &control, const string &arm, const string &eye, Bottle &reply,
+                     const string &tool="")
+    {
+        ICartesianControl *iCartCtrl;
+        if (arm=="left")
+            iCartCtrl=iCartCtrlL;
+        else if (arm=="right")
+            iCartCtrl=iCartCtrlR;
+        else
+            return false;
+
+        ActionRecord record("findtip");
+        record.setId(control.id);
+        record.setArm(arm);
+
+        // the exploration sweeps the whole workspace in front
+        // of the eyes: both arms are held
+        record.begin("arbiter");
+        if (!arbiter.acquireAll(&control.interrupt))
+        {
+            record.end(false);
+            telemetry.publish(record);
+            return false;
+        }
+        record.end();
+
+        record.begin("context");
+        int context_arm,context_gaze;
+        iCartCtrl->storeContext(&context_arm);
+        iGaze->storeContext(&context_gaze);
+
+        Vector dof;
+        iCartCtrl->getDOF(dof);
+        dof=1.0; dof[0]=dof[1]=0.0;
+        iCartCtrl->setDOF(dof,dof);
+        record.end();
+
+        Bottle command;
+        command.addVocab(Vocab::encode("clear"));
+        finderPort.write(command,reply);
+
+        // solving
+        command.clear();
+        command.addVocab(Vocab::encode("select"));
+        command.addString(arm.c_str());
+        command.addString(eye.c_str());
+        finderPort.write(command,reply);
+
+        Matrix R(4,4);
+        R(0,0)=-1.0;
+        R(2,1)=-1.0;
+        R(1,2)=-1.0;
+        R(3,3)=+1.0;
+        Vector r(4,0.0); r[0]=-1.0;
+        Vector xd(3,0.0),od;
+        Vector offset(3,0.0); offset[2]=0.1;
+
+        // point 1
+        r[3]=0.0;
+        od=dcm2axis(axis2dcm(r)*R);
+        xd[0]=-0.35;
+        shake_joint=4;
+
+        // a known tool is verified from the first pose only
+        if (!tool.empty())
+        {
+            command.clear();
+            command.addVocab(Vocab::encode("recall"));
+            command.addString(tool.c_str());
+            finderPort.write(command,reply);
+
+            if (reply.get(0).asVocab()==Vocab::encode("ack"))
+            {
+                moveTool(control,arm,eye,xd,od,offset,10,record);
+
+                command.clear();
+                command.addVocab(Vocab::encode("verify"));
+                command.addString(tool.c_str());
+                finderPort.write(command,reply);
+
+                if (reply.get(0).asVocab()==Vocab::encode("ack"))
+                {
+                    telemetry.publish(record);
+
+                    iCartCtrl->restoreContext(context_arm);
+                    iCartCtrl->deleteContext(context_arm);
+
+                    iGaze->restoreContext(context_gaze);
+                    iGaze->deleteContext(context_gaze);
+                    arbiter.release(getArmIndex(iCartCtrl));
+                    arbiter.release(1-getArmIndex(iCartCtrl),false);
+
+                    return true;
+                }
+
+                printf("Tool %s not verified, exploring...\n",tool.c_str());
+            }
+        }
+
+        // the planner picks the poses out of a set of candidates,
+        // otherwise a fixed sequence is explored
+        if (find_planner)
+            planExploration(control,arm,eye,record);
+        else
+        {
+            moveTool(control,arm,eye,xd,od,offset,25,record);
+
+            // point 2
+            r[3]=CTRL_DEG2RAD*(arm=="left"?30.0:-30.0);
+            od=dcm2axis(axis2dcm(r)*R);
+            xd[1]=(arm=="left")?-0.15:0.15;
+            offset[1]=(arm=="left")?0.1:-0.1;
+            moveTool(control,arm,eye,xd,od,offset,25,record);
+
+            // point 3
+            r[3]=CTRL_DEG2RAD*(arm=="left"?20.0:-20.0);
+            od=dcm2axis(axis2dcm(r)*R);
+            xd[2]=0.15;
+            offset[1]=(arm=="left")?0.2:-0.2;
+            offset[2]=0.1;
+            moveTool(control,arm,eye,xd,od,offset,25,record);
+
+            // with stereo observations the depth ambiguity is already
+            // resolved at each pose, hence points 4 and 5 can be skipped
+            if (eye!="both")
+            {
+                // point 4
+                r[3]=CTRL_DEG2RAD*(arm=="left"?10.0:-10.0);
+                od=dcm2axis(axis2dcm(r)*R);
+                xd[0]=-0.3;
+                xd[1]=(arm=="left")?-0.05:0.05;
+                xd[2]=-0.05;
+                moveTool(control,arm,eye,xd,od,offset,25,record);
+
+                // point 5
+                r[3]=CTRL_DEG2RAD*(arm=="left"?45.0:-45.0);
+                od=dcm2axis(axis2dcm(r)*R);
+                xd[0]=-0.35;
+                xd[1]=(arm=="left")?-0.05:0.05;
+                xd[2]=0.1;
+                offset[1]=(arm=="left")?0.1:-0.1;
+                moveTool(control,arm,eye,xd,od,offset,25,record);
+            }
+
+            // point 6
+            xd[0]=-0.35;
+            xd[1]=(arm=="left")?-0.1:0.1;
+            xd[2]=0.0;
+            Vector r1(4,0.0); r1[2]=(arm=="left")?-1.0:1.0; r1[3]=CTRL_DEG2RAD*45.0;
+            Vector r2(4,0.0); r2[0]=(arm=="left")?1.0:-1.0; r2[3]=CTRL_DEG2RAD*45.0;
+            od=dcm2axis(axis2dcm(r2)*axis2dcm(r1)*R);
+            offset[0]=0;
+            offset[1]=(arm=="left")?-0.05:0.05;
+            offset[2]=0.1;
+            shake_joint=6;
+            moveTool(control,arm,eye,xd,od,offset,50,record);
+        }
+
+        // solving
+        record.begin("find");
+        command.clear();
+        command.addVocab(Vocab::encode("find"));
+        finderPort.write(command,reply);
+        record.end(reply.get(0).asVocab()==Vocab::encode("ack"));
+
+        // store the new estimate in the library
+        if (!tool.empty() && (reply.get(0).asVocab()==Vocab::encode("ack")))
+        {
+            Bottle saveReply;
+            command.clear();
+            command.addVocab(Vocab::encode("save"));
+            command.addString(tool.c_str());
+            finderPort.write(command,saveReply);
+        }
+
+        iCartCtrl->restoreContext(context_arm);
+        iCartCtrl->deleteContext(context_arm);
+
+        iGaze->restoreContext(context_gaze);
+        iGaze->deleteContext(context_gaze);
+        arbiter.release(getArmIndex(iCartCtrl));
+        arbiter.release(1-getArmIndex(iCartCtrl),false);
+        telemetry.publish(record);
+
+        return true;
+    }
+
+    /************************************************************************/
+    string getArmType(ICartesianControl *iCartCtrl, const string &arm)
+    {
+        // the kinematics employed by the controller
+        string type=arm;
+        Bottle info;
+        if (iCartCtrl->getInfo(info))
+        {
+            if (info.check("arm_type"))
+                type=info.find("arm_type").asString().c_str();
+        }
+
+        return type;
+    }
+
+    /************************************************************************/
+    void configureSolverPool(ArmSolverPool &pool, ICartesianControl *iCartCtrl,
+                             const string &arm, const int nThreads)
+    {
+        // mirror the kinematics employed by the controller
+        pool.configure(getArmType(iCartCtrl,arm),nThreads);
+        if (!pool.readLimits(iCartCtrl))
+            printf("unable to retrieve the limits of the %s arm: local solvers disabled\n",
+                   arm.c_str());
+
+        if (!pool.readRestPosture(iCartCtrl))
+            printf("unable to retrieve the rest posture of the %s arm\n",arm.c_str());
+
+        // the elbow task as given by changeElbowHeight
+        if (elbow_set)
+        {
+            Vector xd(3,0.0),w(3,0.0);
+            xd[2]=elbow_height;
+            w[2]=elbow_weight;
+            pool.setTask2(6,xd,w);
+        }
+    }
+
+public:
+    /************************************************************************/
+    bool configure(ResourceFinder &rf)
+    {
+        actionQueue=NULL;
+        handShaker=NULL;
+
+        string name=rf.check("name",Value("karmaMotor")).asString().c_str();
+        string robot=rf.check("robot",Value("icub")).asString().c_str();
+        elbow_set=rf.check("elbow_set");
+        mov_time=rf.check("movTime",Value(1.0)).asDouble();
+        string planner=rf.check("find_planner",Value("off")).asString().c_str();
+        find_planner=(planner=="on");
+        find_tol=rf.check("find_tol",Value(0.005)).asDouble();
+        find_max_poses=rf.check("find_max_poses",Value(8)).asInt();
+        find_items=rf.check("find_items",Value(20)).asInt();
+        local_ik=(rf.check("local_ik",Value("on")).asString()=="on");
+        int ik_threads=std::max(rf.check("ik_threads",Value(1)).asInt(),1);
+        IpoptLock::setThreadSafe(ik_threads>1);
+        ikCache.setCapacity(std::max(rf.check("ik_cache_size",Value(10000)).asInt(),0));
+        ik_cache_file=rf.check("ik_cache_file",Value("")).asString().c_str();
+        reach_thres=rf.check("reach_thres",Value(20.0)).asDouble();
+        arbiter.setMargin(rf.check("arm_margin",Value(0.1)).asDouble());
+        arbiter.setIdleTimeout(rf.check("arm_wait",Value(10.0)).asDouble());
+        if (rf.check("reach_map"))
+        {
+            string reach_map=rf.findFile("reach_map").c_str();
+            if (reachMap.open(reach_map))
+                printf("reachability map loaded from %s\n",reach_map.c_str());
+            else
+                printf("unable to load the reachability map\n");
+        }
+        if (elbow_set)
+        {
+            if (Bottle *pB=rf.find("elbow_set").asList())
+            {
+                elbow_height=pB->get(0).asDouble();
+                elbow_weight=pB->get(1).asDouble();
+            }
+            else
+            {
+                elbow_height=0.4;
+                elbow_weight=30.0;
+            }
+        }
+
+        Property optionG("(device gazecontrollerclient)");
+        optionG.put("remote","/iKinGazeCtrl");
+        optionG.put("local",("/"+name+"/gaze_ctrl").c_str());
+
+        Property optionL("(device cartesiancontrollerclient)");
+        optionL.put("remote",("/"+robot+"/cartesianController/left_arm").c_str());
+        optionL.put("local",("/"+name+"/cart_ctrl/left_arm").c_str());
+
+        Property optionR("(device cartesiancontrollerclient)");
+        optionR.put("remote",("/"+robot+"/cartesianController/right_arm").c_str());
+        optionR.put("local",("/"+name+"/cart_ctrl/right_arm").c_str());
+
+        Property optionHL("(device remote_controlboard)");
+        optionHL.put("remote",("/"+robot+"/left_arm").c_str());
+        optionHL.put("local",("/"+name+"/hand_ctrl/left_arm").c_str());
+
+        Property optionHR("(device remote_controlboard)");
+        optionHR.put("remote",("/"+robot+"/right_arm").c_str());
+        optionHR.put("local",("/"+name+"/hand_ctrl/right_arm").c_str());
+
+        // the simulated devices are plugged in through the same
+        // interfaces, thus nothing else changes downstream
+        if (rf.check("sim"))
+        {
+            double time_scale=rf.check("sim_time_scale",Value(1.0)).asDouble();
+            printf("running with the kinematic simulator (time scale=%g)\n",time_scale);
+
+            optionG.put("device","karmasimgaze");
+            optionL.put("device","karmasimcartesian");
+            optionR.put("device","karmasimcartesian");
+            optionHL.put("device","karmasimcontrolboard");
+            optionHR.put("device","karmasimcontrolboard");
+
+            optionL.put("arm","left");
+            optionR.put("arm","right");
+
+            optionG.put("time_scale",time_scale);
+            optionL.put("time_scale",time_scale);
+            optionR.put("time_scale",time_scale);
+        }
+
+        if (!driverG.open(optionG))
+            return false;
+
+        if (!driverL.open(optionL))
+        {
+            driverG.close();
+            return false;
+        }
+
+        if (!driverR.open(optionR))
+        {
+            driverG.close();
+            driverL.close();
+            return false;
+        }
+
+        if (!driverHL.open(optionHL))
+        {
+            driverG.close();
+            driverL.close();
+            driverR.close();
+            return false;
+        }
+
+        if (!driverHR.open(optionHR))
+        {
+            driverG.close();
+            driverL.close();
+            driverR.close();
+            driverHL.close();
+            return false;
+        }
+
+        driverG.view(iGaze);
+        driverL.view(iCartCtrlL);
+        driverR.view(iCartCtrlR);
+        arbiter.setArms(iCartCtrlL,iCartCtrlR);
+
+        handShaker=new HandShaker(rf.check("shake_period",Value(10)).asInt());
+        if (!handShaker->configure(driverHL,driverHR))
+        {
+            printf("unable to access the hand interfaces\n");
+            delete handShaker;
+            handShaker=NULL;
+
+            driverG.close();
+            driverL.close();
+            driverR.close();
+            driverHL.close();
+            driverHR.close();
+            return false;
+        }
+        handShaker->setProfile(rf.check("shake_amplitude",Value(6.0)).asDouble(),
+                               rf.check("shake_frequency",Value(3.0)).asDouble());
+        handShaker->start();
+
+        iencT=iencL=iencR=NULL;
+        if (local_ik)
+        {
+            configureSolverPool(ikPoolL,iCartCtrlL,"left",ik_threads);
+            configureSolverPool(ikPoolR,iCartCtrlR,"right",ik_threads);
+
+            // the state of the real robot is taken from the encoders
+            if (!rf.check("sim"))
+            {
+                Property optionT("(device remote_controlboard)");
+                optionT.put("remote",("/"+robot+"/torso").c_str());
+                optionT.put("local",("/"+name+"/torso").c_str());
+                if (driverT.open(optionT))
+                {
+                    driverT.view(iencT);
+                    driverHL.view(iencL);
+                    driverHR.view(iencR);
+                }
+                else
+                    printf("unable to access the torso encoders: the controllers will be queried\n");
+            }
+        }
+
+        // the cached poses hold as long as the solvers and their
+        // settings stay the same
+        string signature=getArmType(iCartCtrlL,"left")+(ikPoolL.isConfigured()?":local ":":remote ")+
+                         getArmType(iCartCtrlR,"right")+(ikPoolR.isConfigured()?":local":":remote");
+        if (elbow_set)
+        {
+            char elbow[64];
+            sprintf(elbow," elbow:%g:%g",elbow_height,elbow_weight);
+            signature+=elbow;
+        }
+        ikCache.setSignature(signature);
+        if (!ik_cache_file.empty())
+        {
+            if (ikCache.load(ik_cache_file))
+                printf("loaded %d cached poses from %s\n",(int)ikCache.size(),ik_cache_file.c_str());
+        }
+
+        visionPort.open(("/"+name+"/vision:i").c_str());
+        finderPort.open(("/"+name+"/finder:rpc").c_str());
+        checkPort.open(("/"+name+"/check:rpc").c_str());
+        finderStatusPort.open(("/"+name+"/finder:i").c_str());
+        rpcPort.open(("/"+name+"/rpc").c_str());
+        stopPort.open(("/"+name+"/stop:i").c_str());
+        eventPort.open(("/"+name+"/events:o").c_str());
+        telemetry.open(("/"+name+"/telemetry:o").c_str(),
+                       rf.check("telemetry_log",Value("")).asString().c_str());
+        attach(rpcPort);
+        stopPort.setReader(*this);
+
+
+        pushHand="selectable";
+        toolFrame=eye(4,4);
+
+        deque<string> lanes;
+        lanes.push_back("any");
+        lanes.push_back("left");
+        lanes.push_back("right");
+        actionQueue=new ActionQueue(*this,eventPort,lanes);
+        actionQueue->start();
+
+        return true;
+    }
+
+    /************************************************************************/
+    bool interruptModule()
+    {
+        // a stop request interrupts all the running actions
+        mutexState.wait();
+        for (size_t i=0; i<activeActions.size(); i++)
+            activeActions[i]->interrupt=true;
+        mutexState.post();
+
+        iGaze->stopControl();
+        iCartCtrlL->stopControl();
+        iCartCtrlR->stopControl();
+
+        if (handShaker!=NULL)
+            handShaker->stopShaking();
+
+        return true;
+    }
+
+    /************************************************************************/
+    bool close()
+    {
+        visionPort.close();
+        finderPort.close();
+        checkPort.close();
+        finderStatusPort.close();
+        rpcPort.close();
+        stopPort.close();   // close prior to shutting down motor-interfaces
+
+        // wait for the running action, if any
+        if (actionQueue!=NULL)
+        {
+            actionQueue->stop();
+            delete actionQueue;
+            actionQueue=NULL;
+        }
+        eventPort.close();
+        telemetry.close();
+
+        if (handShaker!=NULL)
+        {
+            handShaker->stop();
+            delete handShaker;
+            handShaker=NULL;
+        }
+
+        ikPoolL.close();
+        ikPoolR.close();
+
+        if (!ik_cache_file.empty())
+        {
+            if (!ikCache.save(ik_cache_file))
+                printf("unable to save the cached poses to %s\n",ik_cache_file.c_str());
+        }
+
+        driverG.close();
+        driverL.close();
+        driverR.close();
+        driverHL.close();
+        driverHR.close();
+        if (driverT.isValid())
+            driverT.close();
+        return true;
+    }
+
+    /************************************************************************/
+    double getPeriod()
+    {
+        return 1.0;
+    }
+
+    /************************************************************************/
+    bool updateModule()
+    {
+        return true;
+    }
+};
+
+
+/************************************************************************/
+int main(int argc, char *argv[])
+{
+    ResourceFinder rf;
+    rf.setVerbose(true);
+    rf.configure(argc,argv);
+
+    // the simulator does not require the name server
+    Network yarp;
+    if (rf.check("sim"))
+        Network::setLocalMode(true);
+    else if (!yarp.checkNetwork())
+    {
+        printf("YARP server not available!\n");
+        return -1;
+    }
+
+    YARP_REGISTER_DEVICES(icubmod)
+    registerSimDevices();
+
+    KarmaMotor karmaMotor;
+    return karmaMotor.runModule(rf);
+}
+
+
+
@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/**
+\defgroup karmaMotorReachMap Reachability Map Builder
+
+Build offline the reachability map of the table workspace employed
+by \ref karmaMotor.
+
+\section intro_sec Description
+The tool tip poses used by the push and draw actions (tip on the
+table plane approaching horizontally from the heading phi) are
+sampled over a grid of (x,y,phi) for both arms and for each given
+tool. The IK of the corresponding hand poses is solved with the
+arm kinematics alone, and the resulting errors are stored in a
+binary file which karmaMotor maps in memory to select the arm and
+prune candidate poses without querying the solver. No robot nor
+YARP devices are required.
+
+\section lib_sec Libraries
+- YARP libraries.
+- iKin library.
+- IPOPT library.
+
+\section parameters_sec Parameters
+--out \e file
+- The output file. By default it is <i>reachmap.bin</i>.
+
+--x <i>(min max n)</i>
+- Range and number of samples along x. By default (-0.5 -0.15 36).
+
+--y <i>(min max n)</i>
+- Range and number of samples along y. By default (-0.35 0.35 71).
+
+--z \e z
+- Height of the table plane. By default it is -0.1 m.
+
+--dz \e dz
+- Tolerance on the height within which the map is queried. By
+  default it is 0.05 m.
+
+--phi \e n
+- Number of headings. By default it is 16.
+
+--tools <i>((x y z [ax ay az theta]) ...)</i>
+- The tools wrt the hand reference frame, as given to karmaMotor
+  through the attach command; the bare hand is always the first
+  entry. At most 7 tools can be given.
+
+--arm_types <i>(left right)</i>
+- Kinematic types of the left and right arms.
+
+--threads \e n
+- Number of solvers working in parallel. By default it is 1;
+  greater values require the linear solver employed by IPOPT
+  to be thread-safe.
+
+\section tested_os_sec Tested OS
+Windows, Linux
+
+\author Ugo Pattacini
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include <deque>
+#include <vector>
+
+#include <yarp/os/all.h>
+#include <yarp/sig/all.h>
+#include <yarp/math/Math.h>
+
+#include <iCub/ctrl/math.h>
+
+#include "iCub/ikpool.h"
+#include "iCub/reachmap.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::ctrl;
+
+
+/****************************************************************/
+bool getRange(ResourceFinder &rf, const string &key, double &min, double &max, int &n)
+{
+    if (Bottle *pB=rf.find(key.c_str()).asList())
+    {
+        if (pB->size()>=3)
+        {
+            min=pB->get(0).asDouble();
+            max=pB->get(1).asDouble();
+            n=pB->get(2).asInt();
+            return ((max>min) && (n>=2));
+        }
+    }
+
+    return false;
+}
+
+
+/****************************************************************/
+Matrix getToolFrame(const Bottle &b, double *tool)
+{
+    // same convention of the attach command of karmaMotor
+    Vector point(4);
+    point[0]=b.get(0).asDouble();
+    point[1]=b.get(1).asDouble();
+    point[2]=b.get(2).asDouble();
+    point[3]=1.0;
+
+    Vector r(4,0.0);
+    if (b.size()>=7)
+    {
+        for (int i=0; i<4; i++)
+            r[i]=b.get(3+i).asDouble();
+    }
+    else
+    {
+        r[2]=-1.0;
+        r[3]=atan2(-point[1],point[0]);
+    }
+
+    Matrix frame=axis2dcm(r);
+    frame.setCol(3,point);
+
+    for (int i=0; i<3; i++)
+        tool[i]=point[i];
+    for (int i=0; i<4; i++)
+        tool[3+i]=r[i];
+
+    return frame;
+}
+
+
+/****************************************************************/
+int main(int argc, char *argv[])
+{
+    ResourceFinder rf;
+    rf.configure(argc,argv);
+
+    ReachMapHeader header;
+    memset(&header,0,sizeof(header));
+    strncpy(header.magic,REACHMAP_MAGIC,sizeof(header.magic));
+
+    header.xmin=-0.5;  header.xmax=-0.15; header.nx=36;
+    header.ymin=-0.35; header.ymax=0.35;  header.ny=71;
+    if (rf.check("x") && !getRange(rf,"x",header.xmin,header.xmax,header.nx))
+    {
+        printf("invalid range for x\n");
+        return 1;
+    }
+    if (rf.check("y") && !getRange(rf,"y",header.ymin,header.ymax,header.ny))
+    {
+        printf("invalid range for y\n");
+        return 1;
+    }
+
+    header.z=rf.check("z",Value(-0.1)).asDouble();
+    header.dz=rf.check("dz",Value(0.05)).asDouble();
+    header.nphi=std::max(rf.check("phi",Value(16)).asInt(),1);
+
+    // the bare hand comes first
+    deque<Matrix> frames;
+    Bottle bareHand("(0.0 0.0 0.0 0.0 0.0 1.0 0.0)");
+    frames.push_back(getToolFrame(bareHand,header.tools[0]));
+    if (Bottle *pB=rf.find("tools").asList())
+    {
+        for (int i=0; (i<pB->size()) && (frames.size()<REACHMAP_MAX_TOOLS); i++)
+        {
+            Bottle *pTool=pB->get(i).asList();
+            if ((pTool!=NULL) && (pTool->size()>=3))
+                frames.push_back(getToolFrame(*pTool,header.tools[frames.size()]));
+        }
+    }
+    header.nTools=(int)frames.size();
+
+    string types[2]={"left","right"};
+    if (Bottle *pB=rf.find("arm_types").asList())
+    {
+        if (pB->size()>=2)
+        {
+            types[0]=pB->get(0).asString().c_str();
+            types[1]=pB->get(1).asString().c_str();
+        }
+    }
+
+    int threads=std::max(rf.check("threads",Value(1)).asInt(),1);
+    IpoptLock::setThreadSafe(threads>1);
+    string out=rf.check("out",Value("reachmap.bin")).asString().c_str();
+
+    // torso roll disabled as in the actions; arm at rest
+    Vector dof(10,1.0); dof[1]=0.0;
+    Vector q(10,0.0);
+    q[3]=-30.0; q[4]=30.0; q[6]=45.0;
+
+    size_t nCells=(size_t)header.nTools*2*header.nphi*header.ny*header.nx;
+    vector<unsigned char> cells(nCells,REACHMAP_UNKNOWN);
+
+    printf("building the map: %d tool(s), (%d x %d x %d) cells per arm\n",
+           header.nTools,header.nx,header.ny,header.nphi);
+
+    double t0=Time::now();
+    for (int arm=0; arm<2; arm++)
+    {
+        ArmSolverPool pool;
+        pool.configure(types[arm],threads);
+        pool.useDefaultLimits();
+        pool.setState(dof,q);
+
+        for (int tool=0; tool<header.nTools; tool++)
+        {
+            Matrix invFrame=SE3inv(frames[tool]);
+            for (int iphi=0; iphi<header.nphi; iphi++)
+            {
+                double phi=iphi*2.0*M_PI/header.nphi;
+
+                // one batch per heading
+                deque<IKQuery> queries;
+                for (int iy=0; iy<header.ny; iy++)
+                {
+                    for (int ix=0; ix<header.nx; ix++)
+                    {
+                        double x=header.xmin+ix*(header.xmax-header.xmin)/(header.nx-1);
+                        double y=header.ymin+iy*(header.ymax-header.ymin)/(header.ny-1);
+                        Matrix H=ReachMap::getTipPose(x,y,header.z,phi)*invFrame;
+
+                        IKQuery query;
+                        query.xd=H.getCol(3).subVector(0,2);
+                        query.od=dcm2axis(H);
+                        queries.push_back(query);
+                    }
+                }
+
+                pool.solve(queries);
+
+                for (int iy=0; iy<header.ny; iy++)
+                {
+                    for (int ix=0; ix<header.nx; ix++)
+                    {
+                        const IKQuery &query=queries[iy*header.nx+ix];
+                        double err=(double)REACHMAP_MAX_ERROR;
+                        if (query.ok)
+                        {
+                            Matrix Rd=axis2dcm(query.od).submatrix(0,2,0,2);
+                            Matrix Rhat=axis2dcm(query.odhat).submatrix(0,2,0,2);
+                            double angle=fabs(dcm2axis(Rd.transposed()*Rhat)[3]);
+                            err=2.0*(1e3*norm(query.xd-query.xdhat)+CTRL_RAD2DEG*angle);
+                        }
+
+                        size_t i=ReachMap::getCellIndex(header,tool,arm,iphi,iy,ix);
+                        cells[i]=(unsigned char)std::min(floor(err+0.5),(double)REACHMAP_MAX_ERROR);
+                    }
+                }
+
+                printf("arm=%s; tool=%d; phi=%.1f [deg] done (%.1f [s])\n",
+                       types[arm].c_str(),tool,CTRL_RAD2DEG*phi,Time::now()-t0);
+            }
+        }
+    }
+
+    FILE *fout=fopen(out.c_str(),"wb");
+    if (fout==NULL)
+    {
+        printf("unable to open %s\n",out.c_str());
+        return 1;
+    }
+
+    bool ok=(fwrite(&header,sizeof(header),1,fout)==1) &&
+            (fwrite(&cells[0],1,nCells,fout)==nCells);
+    fclose(fout);
+
+    printf("%s %s\n",ok?"map saved to":"unable to write",out.c_str());
+    return (ok?0:1);
+}
+
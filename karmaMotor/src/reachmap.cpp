@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #define REACHMAP_USE_MMAP
+#endif
+
+#include <yarp/math/Math.h>
+
+#include <iCub/ctrl/math.h>
+
+#include "iCub/reachmap.h"
+
+using namespace std;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::ctrl;
+
+
+/**********************************************************/
+ReachMap::ReachMap() : cells(NULL), mem(NULL), memSize(0)
+{
+    memset(&header,0,sizeof(header));
+}
+/**********************************************************/
+bool ReachMap::open(const string &fileName)
+{
+    close();
+
+#ifdef REACHMAP_USE_MMAP
+    int fd=::open(fileName.c_str(),O_RDONLY);
+    if (fd<0)
+        return false;
+
+    struct stat st;
+    if ((fstat(fd,&st)!=0) || ((size_t)st.st_size<sizeof(ReachMapHeader)))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // pages are loaded on demand by the lookups
+    memSize=(size_t)st.st_size;
+    mem=mmap(NULL,memSize,PROT_READ,MAP_SHARED,fd,0);
+    ::close(fd);
+    if (mem==MAP_FAILED)
+    {
+        mem=NULL;
+        return false;
+    }
+#else
+    FILE *fin=fopen(fileName.c_str(),"rb");
+    if (fin==NULL)
+        return false;
+
+    fseek(fin,0,SEEK_END);
+    memSize=(size_t)ftell(fin);
+    fseek(fin,0,SEEK_SET);
+    mem=new char[memSize];
+    bool ok=(fread(mem,1,memSize,fin)==memSize);
+    fclose(fin);
+    if (!ok || (memSize<sizeof(ReachMapHeader)))
+    {
+        close();
+        return false;
+    }
+#endif
+
+    memcpy(&header,mem,sizeof(header));
+    size_t nCells=(size_t)header.nTools*2*header.nphi*header.ny*header.nx;
+    if ((strncmp(header.magic,REACHMAP_MAGIC,sizeof(header.magic))!=0) ||
+        (header.nTools<1) || (header.nTools>REACHMAP_MAX_TOOLS) ||
+        (header.nx<2) || (header.ny<2) || (header.nphi<1) ||
+        (memSize<sizeof(ReachMapHeader)+nCells))
+    {
+        close();
+        return false;
+    }
+
+    cells=(const unsigned char*)mem+sizeof(ReachMapHeader);
+
+    for (int i=0; i<header.nTools; i++)
+    {
+        Vector r(4);
+        for (int j=0; j<4; j++)
+            r[j]=header.tools[i][3+j];
+
+        Matrix frame=axis2dcm(r);
+        frame(0,3)=header.tools[i][0];
+        frame(1,3)=header.tools[i][1];
+        frame(2,3)=header.tools[i][2];
+        toolFrames.push_back(frame);
+    }
+
+    return true;
+}
+/**********************************************************/
+void ReachMap::close()
+{
+    if (mem!=NULL)
+    {
+    #ifdef REACHMAP_USE_MMAP
+        munmap(mem,memSize);
+    #else
+        delete[] (char*)mem;
+    #endif
+    }
+
+    mem=NULL;
+    memSize=0;
+    cells=NULL;
+    toolFrames.clear();
+}
+/**********************************************************/
+bool ReachMap::isOpen() const
+{
+    return (cells!=NULL);
+}
+/**********************************************************/
+int ReachMap::findTool(const Matrix &frame) const
+{
+    // tools are matched within 5 mm and about 3 deg
+    for (size_t i=0; i<toolFrames.size(); i++)
+    {
+        const Matrix &F=toolFrames[i];
+        double dp=norm(F.getCol(3).subVector(0,2)-frame.getCol(3).subVector(0,2));
+        Matrix R=F.submatrix(0,2,0,2).transposed()*frame.submatrix(0,2,0,2);
+        double angle=fabs(dcm2axis(R)[3]);
+        if ((dp<0.005) && (angle<0.05))
+            return (int)i;
+    }
+
+    return -1;
+}
+/**********************************************************/
+size_t ReachMap::getCellIndex(const ReachMapHeader &header, const int tool, const int arm,
+                              const int iphi, const int iy, const int ix)
+{
+    return ((((size_t)tool*2+arm)*header.nphi+iphi)*header.ny+iy)*header.nx+ix;
+}
+/**********************************************************/
+Matrix ReachMap::getTipPose(const double x, const double y, const double z,
+                            const double phi)
+{
+    double c=cos(phi);
+    double s=sin(phi);
+
+    Matrix H(4,4); H.zero();
+    H(0,0)=s;   H(1,0)=-c;
+    H(2,1)=-1.0;
+    H(0,2)=c;   H(1,2)=s;
+    H(0,3)=x;   H(1,3)=y;   H(2,3)=z;
+    H(3,3)=1.0;
+
+    return H;
+}
+/**********************************************************/
+bool ReachMap::getHeading(const Matrix &Htip, double &phi)
+{
+    // only poses with the y-axis pointing downward belong
+    // to the family covered by the map
+    if (Htip(2,1)>-0.95)
+        return false;
+
+    phi=atan2(Htip(1,2),Htip(0,2));
+    return true;
+}
+/**********************************************************/
+bool ReachMap::getIndex(const Vector &x, int &ix, int &iy) const
+{
+    if ((x.length()<3) || (fabs(x[2]-header.z)>header.dz))
+        return false;
+
+    ix=(int)floor((x[0]-header.xmin)/(header.xmax-header.xmin)*(header.nx-1)+0.5);
+    iy=(int)floor((x[1]-header.ymin)/(header.ymax-header.ymin)*(header.ny-1)+0.5);
+
+    return ((ix>=0) && (ix<header.nx) && (iy>=0) && (iy<header.ny));
+}
+/**********************************************************/
+int ReachMap::getPhiIndex(const double phi) const
+{
+    int iphi=(int)floor(phi/(2.0*M_PI/header.nphi)+0.5)%header.nphi;
+    return ((iphi<0)?iphi+header.nphi:iphi);
+}
+/**********************************************************/
+double ReachMap::getError(const int arm, const int tool, const Matrix &Htip) const
+{
+    if (!isOpen() || (arm<0) || (arm>1) || (tool<0) || (tool>=header.nTools))
+        return -1.0;
+
+    double phi;
+    int ix,iy;
+    if (!getHeading(Htip,phi) || !getIndex(Htip.getCol(3),ix,iy))
+        return -1.0;
+
+    unsigned char cell=cells[getCellIndex(header,tool,arm,getPhiIndex(phi),iy,ix)];
+    return ((cell==REACHMAP_UNKNOWN)?-1.0:0.5*cell);
+}
+/**********************************************************/
+double ReachMap::getDexterity(const int arm, const int tool, const Vector &x,
+                              const double thres) const
+{
+    // fraction of the headings that can be attained
+    if (!isOpen() || (arm<0) || (arm>1) || (tool<0) || (tool>=header.nTools))
+        return -1.0;
+
+    int ix,iy;
+    if (!getIndex(x,ix,iy))
+        return -1.0;
+
+    int reachable=0,known=0;
+    for (int iphi=0; iphi<header.nphi; iphi++)
+    {
+        unsigned char cell=cells[getCellIndex(header,tool,arm,iphi,iy,ix)];
+        if (cell!=REACHMAP_UNKNOWN)
+        {
+            known++;
+            if (0.5*cell<=thres)
+                reachable++;
+        }
+    }
+
+    return ((known>0)?(double)reachable/known:-1.0);
+}
+/**********************************************************/
+ReachMap::~ReachMap()
+{
+    close();
+}
+
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <math.h>
+
+#include <iCub/ctrl/math.h>
+
+#include "iCub/se3.h"
+
+using namespace yarp::sig;
+using namespace iCub::ctrl;
+
+
+/**********************************************************/
+SE3::SE3(const Matrix &H)
+{
+    for (int i=0; i<3; i++)
+    {
+        for (int j=0; j<3; j++)
+            R[i][j]=H(i,j);
+        p[i]=H(i,3);
+    }
+}
+/**********************************************************/
+SE3 SE3::rotation(const double ax, const double ay, const double az,
+                  const double theta)
+{
+    SE3 ret;
+    double n=sqrt(ax*ax+ay*ay+az*az);
+    if (n<1e-9)
+        return ret;
+
+    double x=ax/n;
+    double y=ay/n;
+    double z=az/n;
+    double c=cos(theta);
+    double s=sin(theta);
+    double v=1.0-c;
+
+    ret.R[0][0]=x*x*v+c;   ret.R[0][1]=x*y*v-z*s; ret.R[0][2]=x*z*v+y*s;
+    ret.R[1][0]=x*y*v+z*s; ret.R[1][1]=y*y*v+c;   ret.R[1][2]=y*z*v-x*s;
+    ret.R[2][0]=x*z*v-y*s; ret.R[2][1]=y*z*v+x*s; ret.R[2][2]=z*z*v+c;
+
+    return ret;
+}
+/**********************************************************/
+void SE3::getAxis(double *o) const
+{
+    o[0]=R[2][1]-R[1][2];
+    o[1]=R[0][2]-R[2][0];
+    o[2]=R[1][0]-R[0][1];
+
+    double r=sqrt(o[0]*o[0]+o[1]*o[1]+o[2]*o[2]);
+    double theta=atan2(0.5*r,0.5*(R[0][0]+R[1][1]+R[2][2]-1.0));
+    if (r<1e-9)
+    {
+        // symmetric rotation (0 or 180 deg): the axis is not unique,
+        // hence defer to the library to stay consistent with the poses
+        // computed elsewhere
+        Vector od=dcm2axis(toMatrix());
+        for (int i=0; i<4; i++)
+            o[i]=od[i];
+        return;
+    }
+
+    for (int i=0; i<3; i++)
+        o[i]/=r;
+    o[3]=theta;
+}
+/**********************************************************/
+void SE3::getPosition(Vector &x) const
+{
+    if (x.length()!=3)
+        x.resize(3);
+
+    for (int i=0; i<3; i++)
+        x[i]=p[i];
+}
+/**********************************************************/
+void SE3::getAxis(Vector &o) const
+{
+    if (o.length()!=4)
+        o.resize(4);
+
+    double r[4];
+    getAxis(r);
+    for (int i=0; i<4; i++)
+        o[i]=r[i];
+}
+/**********************************************************/
+Matrix SE3::toMatrix() const
+{
+    Matrix H(4,4);
+    for (int i=0; i<3; i++)
+    {
+        for (int j=0; j<3; j++)
+            H(i,j)=R[i][j];
+        H(i,3)=p[i];
+        H(3,i)=0.0;
+    }
+    H(3,3)=1.0;
+
+    return H;
+}
+
@@ -0,0 +1,1743 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <math.h>
+#include <algorithm>
+
+#include <yarp/math/Math.h>
+
+#include <iCub/ctrl/math.h>
+
+#include "iCub/ikpool.h"
+#include "iCub/simulator.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::ctrl;
+using namespace iCub::iKin;
+
+
+/**********************************************************/
+static double minJerkPhase(const double tau, double *dphase)
+{
+    // normalized minimum-jerk profile and its derivative
+    if (tau<=0.0)
+    {
+        if (dphase!=NULL)
+            *dphase=0.0;
+        return 0.0;
+    }
+    else if (tau>=1.0)
+    {
+        if (dphase!=NULL)
+            *dphase=0.0;
+        return 1.0;
+    }
+
+    double tau2=tau*tau;
+    if (dphase!=NULL)
+        *dphase=tau2*(30.0-60.0*tau+30.0*tau2);
+
+    return tau2*tau*(10.0-15.0*tau+6.0*tau2);
+}
+/**********************************************************/
+static bool waitUntil(const double tEnd, const double period, const double timeout)
+{
+    // sleep no longer than needed when time is scaled down
+    double t0=Time::now();
+    while (true)
+    {
+        double t=Time::now();
+        if (t>=tEnd)
+            return true;
+
+        if ((timeout>0.0) && (t-t0>=timeout))
+            return false;
+
+        Time::delay(std::min(period,tEnd-t));
+    }
+}
+/**********************************************************/
+static void toPose(const Matrix &H, Vector &x, Vector &o)
+{
+    x=H.getCol(3).subVector(0,2);
+    o=dcm2axis(H);
+}
+/**********************************************************/
+SimCartesianControl::SimCartesianControl() : arm(NULL), chain(NULL), slv(NULL)
+{
+    timeScale=1.0;
+    contextIdCnt=0;
+    tStart=0.0;
+    duration=0.0;
+}
+/**********************************************************/
+bool SimCartesianControl::open(Searchable &config)
+{
+    type=config.check("arm",Value("right")).asString().c_str();
+    if ((type!="left") && (type!="right"))
+        return false;
+
+    timeScale=std::max(config.check("time_scale",Value(1.0)).asDouble(),0.0);
+
+    arm=new iCubArm(type);
+    chain=arm->asChain();
+    slv=new iKinIpOptMin(*chain,IKINCTRL_POSE_FULL,1e-3,1e-6,100);
+
+    // torso disabled and arm in its home posture
+    ctx.dof.resize(chain->getN(),1.0);
+    ctx.dof[0]=ctx.dof[1]=ctx.dof[2]=0.0;
+    ctx.HN=eye(4,4);
+    ctx.restPos.resize(chain->getN(),0.0);
+    ctx.restWeights.resize(chain->getN(),0.0);
+    ctx.trajTime=2.0;
+    ctx.inTargetTol=0.005;
+    ctx.trackingMode=false;
+    ctx.referenceMode=false;
+    ctx.posePriority="position";
+
+    qStart.resize(chain->getN(),0.0);
+    qStart[3]=-30.0; qStart[4]=30.0; qStart[6]=45.0;
+    qStart=CTRL_DEG2RAD*qStart;
+    qTarget=qStart;
+    tStart=Time::now();
+    duration=0.0;
+
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::close()
+{
+    delete slv;
+    delete arm;
+    slv=NULL;
+    arm=NULL;
+    chain=NULL;
+    return true;
+}
+/**********************************************************/
+double SimCartesianControl::getPhase(const double t, double *dphase) const
+{
+    if (duration<=0.0)
+    {
+        if (dphase!=NULL)
+            *dphase=0.0;
+        return 1.0;
+    }
+
+    double phase=minJerkPhase((t-tStart)/duration,dphase);
+    if (dphase!=NULL)
+        *dphase/=duration;
+
+    return phase;
+}
+/**********************************************************/
+Vector SimCartesianControl::getJoints(const double t) const
+{
+    return qStart+getPhase(t)*(qTarget-qStart);
+}
+/**********************************************************/
+void SimCartesianControl::setDOFOnChain(const Vector &q)
+{
+    Vector qdof;
+    for (unsigned int i=0; i<chain->getN(); i++)
+    {
+        chain->releaseLink(i);
+        if (ctx.dof[i]>0.0)
+            qdof.push_back(q[i]);
+        else
+            chain->blockLink(i,q[i]);
+    }
+
+    chain->setAng(qdof);
+}
+/**********************************************************/
+Vector SimCartesianControl::fwdKin(const Vector &q)
+{
+    setDOFOnChain(q);
+    return chain->EndEffPose();
+}
+/**********************************************************/
+bool SimCartesianControl::solveIK(const Vector &q0, const Vector &xd, const Vector *od,
+                                  Vector &qd)
+{
+    if (xd.length()<3)
+        return false;
+
+    Vector _xd=xd.subVector(0,2);
+    if (od!=NULL)
+    {
+        if (od->length()<4)
+            return false;
+
+        for (int i=0; i<4; i++)
+            _xd.push_back((*od)[i]);
+        slv->set_ctrlPose(IKINCTRL_POSE_FULL);
+    }
+    else
+        slv->set_ctrlPose(IKINCTRL_POSE_XYZ);
+
+    setDOFOnChain(q0);
+    IpoptLock::lock();
+    Vector qdof=slv->solve(chain->getAng(),_xd);
+    IpoptLock::unlock();
+
+    qd=q0;
+    for (unsigned int i=0,j=0; (i<chain->getN()) && (j<qdof.length()); i++)
+        if (ctx.dof[i]>0.0)
+            qd[i]=qdof[j++];
+
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::moveTo(const Vector &xd, const Vector *od, const double t)
+{
+    mutex.wait();
+    double now=Time::now();
+    Vector q0=getJoints(now);
+    Vector qd;
+    bool ok=solveIK(q0,xd,od,qd);
+    if (ok)
+    {
+        qStart=q0;
+        qTarget=qd;
+        tStart=now;
+        duration=((t>0.0)?t:ctx.trajTime)*timeScale;
+    }
+    mutex.post();
+
+    return ok;
+}
+/**********************************************************/
+bool SimCartesianControl::setTrackingMode(const bool f)
+{
+    ctx.trackingMode=f;
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::getTrackingMode(bool *f)
+{
+    *f=ctx.trackingMode;
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::setReferenceMode(const bool f)
+{
+    ctx.referenceMode=f;
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::getReferenceMode(bool *f)
+{
+    *f=ctx.referenceMode;
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::setPosePriority(const ConstString &p)
+{
+    string priority=p.c_str();
+    if ((priority!="position") && (priority!="orientation"))
+        return false;
+
+    ctx.posePriority=priority;
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::getPosePriority(ConstString &p)
+{
+    p=ctx.posePriority.c_str();
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::getPose(Vector &x, Vector &o, Stamp *stamp)
+{
+    mutex.wait();
+    Vector pose=fwdKin(getJoints(Time::now()));
+    mutex.post();
+
+    x=pose.subVector(0,2);
+    o=pose.subVector(3,6);
+    if (stamp!=NULL)
+        stamp->update();
+
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::getPose(const int axis, Vector &x, Vector &o, Stamp *stamp)
+{
+    if ((axis<0) || (axis>=(int)chain->getN()))
+        return false;
+
+    mutex.wait();
+    setDOFOnChain(getJoints(Time::now()));
+    Matrix H=chain->getH(axis,true);
+    mutex.post();
+
+    toPose(H,x,o);
+    if (stamp!=NULL)
+        stamp->update();
+
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::goToPose(const Vector &xd, const Vector &od, const double t)
+{
+    return moveTo(xd,&od,t);
+}
+/**********************************************************/
+bool SimCartesianControl::goToPosition(const Vector &xd, const double t)
+{
+    return moveTo(xd,NULL,t);
+}
+/**********************************************************/
+bool SimCartesianControl::goToPoseSync(const Vector &xd, const Vector &od, const double t)
+{
+    return moveTo(xd,&od,t);
+}
+/**********************************************************/
+bool SimCartesianControl::goToPositionSync(const Vector &xd, const double t)
+{
+    return moveTo(xd,NULL,t);
+}
+/**********************************************************/
+bool SimCartesianControl::getDesired(Vector &xdhat, Vector &odhat, Vector &qdhat)
+{
+    mutex.wait();
+    Vector pose=fwdKin(qTarget);
+    qdhat=CTRL_RAD2DEG*qTarget;
+    mutex.post();
+
+    xdhat=pose.subVector(0,2);
+    odhat=pose.subVector(3,6);
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::askForPose(const Vector &xd, const Vector &od, Vector &xdhat,
+                                     Vector &odhat, Vector &qdhat)
+{
+    mutex.wait();
+    Vector q0=getJoints(Time::now());
+    mutex.post();
+
+    return askForPose(CTRL_RAD2DEG*q0,xd,od,xdhat,odhat,qdhat);
+}
+/**********************************************************/
+bool SimCartesianControl::askForPose(const Vector &q0, const Vector &xd, const Vector &od,
+                                     Vector &xdhat, Vector &odhat, Vector &qdhat)
+{
+    if (q0.length()<chain->getN())
+        return false;
+
+    mutex.wait();
+    Vector qd;
+    Vector q=getJoints(Time::now());
+    bool ok=solveIK(CTRL_DEG2RAD*q0.subVector(0,chain->getN()-1),xd,&od,qd);
+    Vector pose=fwdKin(qd);
+    setDOFOnChain(q);
+    mutex.post();
+
+    xdhat=pose.subVector(0,2);
+    odhat=pose.subVector(3,6);
+    qdhat=CTRL_RAD2DEG*qd;
+    return ok;
+}
+/**********************************************************/
+bool SimCartesianControl::askForPosition(const Vector &xd, Vector &xdhat, Vector &odhat,
+                                         Vector &qdhat)
+{
+    mutex.wait();
+    Vector q0=getJoints(Time::now());
+    mutex.post();
+
+    return askForPosition(CTRL_RAD2DEG*q0,xd,xdhat,odhat,qdhat);
+}
+/**********************************************************/
+bool SimCartesianControl::askForPosition(const Vector &q0, const Vector &xd, Vector &xdhat,
+                                         Vector &odhat, Vector &qdhat)
+{
+    if (q0.length()<chain->getN())
+        return false;
+
+    mutex.wait();
+    Vector qd;
+    Vector q=getJoints(Time::now());
+    bool ok=solveIK(CTRL_DEG2RAD*q0.subVector(0,chain->getN()-1),xd,NULL,qd);
+    Vector pose=fwdKin(qd);
+    setDOFOnChain(q);
+    mutex.post();
+
+    xdhat=pose.subVector(0,2);
+    odhat=pose.subVector(3,6);
+    qdhat=CTRL_RAD2DEG*qd;
+    return ok;
+}
+/**********************************************************/
+bool SimCartesianControl::getDOF(Vector &curDof)
+{
+    curDof=ctx.dof;
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::setDOF(const Vector &newDof, Vector &curDof)
+{
+    // 0 disables the joint, 1 enables it, anything else
+    // leaves it unchanged
+    mutex.wait();
+    size_t len=std::min(newDof.length(),ctx.dof.length());
+    for (size_t i=0; i<len; i++)
+    {
+        if ((newDof[i]==0.0) || (newDof[i]==1.0))
+            ctx.dof[i]=newDof[i];
+    }
+    curDof=ctx.dof;
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::getRestPos(Vector &curRestPos)
+{
+    curRestPos=ctx.restPos;
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::setRestPos(const Vector &newRestPos, Vector &curRestPos)
+{
+    size_t len=std::min(newRestPos.length(),ctx.restPos.length());
+    for (size_t i=0; i<len; i++)
+        ctx.restPos[i]=newRestPos[i];
+
+    curRestPos=ctx.restPos;
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::getRestWeights(Vector &curRestWeights)
+{
+    curRestWeights=ctx.restWeights;
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::setRestWeights(const Vector &newRestWeights, Vector &curRestWeights)
+{
+    size_t len=std::min(newRestWeights.length(),ctx.restWeights.length());
+    for (size_t i=0; i<len; i++)
+        ctx.restWeights[i]=newRestWeights[i];
+
+    curRestWeights=ctx.restWeights;
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::getLimits(const int axis, double *min, double *max)
+{
+    if ((axis<0) || (axis>=(int)chain->getN()))
+        return false;
+
+    *min=CTRL_RAD2DEG*(*chain)[axis].getMin();
+    *max=CTRL_RAD2DEG*(*chain)[axis].getMax();
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::setLimits(const int axis, const double min, const double max)
+{
+    if ((axis<0) || (axis>=(int)chain->getN()) || (min>max))
+        return false;
+
+    mutex.wait();
+    (*chain)[axis].setMin(CTRL_DEG2RAD*min);
+    (*chain)[axis].setMax(CTRL_DEG2RAD*max);
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::getTrajTime(double *t)
+{
+    *t=ctx.trajTime;
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::setTrajTime(const double t)
+{
+    ctx.trajTime=std::max(t,0.0);
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::getInTargetTol(double *tol)
+{
+    *tol=ctx.inTargetTol;
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::setInTargetTol(const double tol)
+{
+    ctx.inTargetTol=tol;
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::getJointsVelocities(Vector &qdot)
+{
+    mutex.wait();
+    double dphase;
+    getPhase(Time::now(),&dphase);
+    qdot=(CTRL_RAD2DEG*dphase)*(qTarget-qStart);
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::getTaskVelocities(Vector &xdot, Vector &odot)
+{
+    // finite differences along the current trajectory
+    const double dt=0.01;
+
+    mutex.wait();
+    double t=Time::now();
+    Vector pose0=fwdKin(getJoints(t));
+    Vector pose1=fwdKin(getJoints(t+dt));
+    mutex.post();
+
+    xdot=(1.0/dt)*(pose1.subVector(0,2)-pose0.subVector(0,2));
+
+    Matrix R0=axis2dcm(pose0.subVector(3,6));
+    Matrix R1=axis2dcm(pose1.subVector(3,6));
+    odot=dcm2axis(R1*R0.transposed());
+    odot[3]/=dt;
+
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::setTaskVelocities(const Vector &xdot, const Vector &odot)
+{
+    // velocity control in the task space is not simulated
+    return false;
+}
+/**********************************************************/
+bool SimCartesianControl::attachTipFrame(const Vector &x, const Vector &o)
+{
+    if ((x.length()<3) || (o.length()<4))
+        return false;
+
+    mutex.wait();
+    ctx.HN=axis2dcm(o);
+    ctx.HN(0,3)=x[0];
+    ctx.HN(1,3)=x[1];
+    ctx.HN(2,3)=x[2];
+    chain->setHN(ctx.HN);
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::getTipFrame(Vector &x, Vector &o)
+{
+    toPose(ctx.HN,x,o);
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::removeTipFrame()
+{
+    mutex.wait();
+    ctx.HN=eye(4,4);
+    chain->setHN(ctx.HN);
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::checkMotionDone(bool *f)
+{
+    mutex.wait();
+    *f=(Time::now()>=tStart+duration);
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::waitMotionDone(const double period, const double timeout)
+{
+    mutex.wait();
+    double tEnd=tStart+duration;
+    mutex.post();
+
+    return waitUntil(tEnd,period,timeout);
+}
+/**********************************************************/
+bool SimCartesianControl::stopControl()
+{
+    mutex.wait();
+    qStart=qTarget=getJoints(Time::now());
+    duration=0.0;
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::storeContext(int *id)
+{
+    mutex.wait();
+    *id=contextIdCnt++;
+    contexts[*id]=ctx;
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::restoreContext(const int id)
+{
+    mutex.wait();
+    map<int,Context>::iterator it=contexts.find(id);
+    bool ok=(it!=contexts.end());
+    if (ok)
+    {
+        ctx=it->second;
+        chain->setHN(ctx.HN);
+    }
+    mutex.post();
+
+    return ok;
+}
+/**********************************************************/
+bool SimCartesianControl::deleteContext(const int id)
+{
+    mutex.wait();
+    bool ok=(contexts.erase(id)>0);
+    mutex.post();
+
+    return ok;
+}
+/**********************************************************/
+bool SimCartesianControl::getInfo(Bottle &info)
+{
+    info.clear();
+
+    Bottle &type=info.addList();
+    type.addString("arm_type");
+    type.addString(this->type.c_str());
+
+    Bottle &sim=info.addList();
+    sim.addString("simulator");
+    sim.addString("karmaMotor");
+
+    return true;
+}
+/**********************************************************/
+bool SimCartesianControl::registerEvent(CartesianEvent &event)
+{
+    return false;
+}
+/**********************************************************/
+bool SimCartesianControl::unregisterEvent(CartesianEvent &event)
+{
+    return false;
+}
+/**********************************************************/
+bool SimCartesianControl::tweakSet(const Bottle &options)
+{
+    return false;
+}
+/**********************************************************/
+bool SimCartesianControl::tweakGet(Bottle &options)
+{
+    options.clear();
+    return true;
+}
+/**********************************************************/
+SimGazeControl::SimGazeControl()
+{
+    timeScale=1.0;
+    contextIdCnt=0;
+    tStart=0.0;
+    duration=0.0;
+}
+/**********************************************************/
+bool SimGazeControl::open(Searchable &config)
+{
+    timeScale=std::max(config.check("time_scale",Value(1.0)).asDouble(),0.0);
+
+    // eyes centers from the kinematics at the rest posture
+    iCubEye eyeL("left"),eyeR("right");
+    eyeCenter[0]=eyeL.asChain()->EndEffPosition();
+    eyeCenter[1]=eyeR.asChain()->EndEffPosition();
+
+    // typical intrinsics of the cameras at 320x240
+    for (int i=0; i<2; i++)
+    {
+        Prj[i].resize(3,4); Prj[i].zero();
+        Prj[i](0,0)=257.34; Prj[i](0,2)=160.0;
+        Prj[i](1,1)=257.34; Prj[i](1,2)=120.0;
+        Prj[i](2,2)=1.0;
+    }
+
+    ctx.neckTrajTime=0.75;
+    ctx.eyesTrajTime=0.25;
+    ctx.vorGain=1.0;
+    ctx.ocrGain=0.0;
+    ctx.neckTol=0.0;
+    ctx.trackingMode=false;
+    ctx.stabilizationMode=false;
+    ctx.saccadesStatus=true;
+    ctx.saccadesInhibitionPeriod=1.0;
+    ctx.saccadesActivationAngle=10.0;
+    ctx.neckPitch[0]=-40.0; ctx.neckPitch[1]=30.0;
+    ctx.neckRoll[0]=-20.0;  ctx.neckRoll[1]=20.0;
+    ctx.neckYaw[0]=-45.0;   ctx.neckYaw[1]=45.0;
+    ctx.blockedVergence=-1.0;
+
+    // straight ahead
+    fpStart=getHeadCenter();
+    fpStart[0]-=1.0;
+    fpTarget=fpStart;
+    tStart=Time::now();
+    duration=0.0;
+
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::close()
+{
+    return true;
+}
+/**********************************************************/
+Vector SimGazeControl::getFixation(const double t) const
+{
+    double phase=(duration>0.0)?minJerkPhase((t-tStart)/duration,NULL):1.0;
+    return fpStart+phase*(fpTarget-fpStart);
+}
+/**********************************************************/
+Matrix SimGazeControl::getEyeFrame(const int camSel, const double t) const
+{
+    // camera frame: z along the optical axis, x rightward, y downward
+    const Vector &e=eyeCenter[camSel==0?0:1];
+    Vector z=getFixation(t)-e;
+    z=z/norm(z);
+
+    Vector up(3,0.0); up[2]=1.0;
+    Vector x=cross(z,up);
+    if (norm(x)<1e-6)
+    {
+        x=0.0;
+        x[1]=1.0;
+    }
+    x=x/norm(x);
+    Vector y=cross(z,x);
+
+    Matrix H=eye(4,4);
+    H.setSubcol(x,0,0);
+    H.setSubcol(y,0,1);
+    H.setSubcol(z,0,2);
+    H.setSubcol(e,0,3);
+    return H;
+}
+/**********************************************************/
+Vector SimGazeControl::getHeadCenter() const
+{
+    return 0.5*(eyeCenter[0]+eyeCenter[1]);
+}
+/**********************************************************/
+bool SimGazeControl::lookAt(const Vector &fp)
+{
+    if (fp.length()<3)
+        return false;
+
+    // keep the fixation point away from the eyes
+    Vector c=getHeadCenter();
+    if (norm(fp.subVector(0,2)-c)<0.05)
+        return false;
+
+    double now=Time::now();
+    fpStart=getFixation(now);
+    fpTarget=fp.subVector(0,2);
+    tStart=now;
+    duration=ctx.neckTrajTime*timeScale;
+
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getRay(const int camSel, const Vector &px, Vector &c, Vector &d)
+{
+    if (px.length()<2)
+        return false;
+
+    int cam=(camSel==0)?0:1;
+    Matrix H=getEyeFrame(cam,Time::now());
+
+    Vector dc(3);
+    dc[0]=(px[0]-Prj[cam](0,2))/Prj[cam](0,0);
+    dc[1]=(px[1]-Prj[cam](1,2))/Prj[cam](1,1);
+    dc[2]=1.0;
+
+    c=eyeCenter[cam];
+    d=H.submatrix(0,2,0,2)*dc;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::setTrackingMode(const bool f)
+{
+    ctx.trackingMode=f;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getTrackingMode(bool *f)
+{
+    *f=ctx.trackingMode;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::setStabilizationMode(const bool f)
+{
+    ctx.stabilizationMode=f;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getStabilizationMode(bool *f)
+{
+    *f=ctx.stabilizationMode;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getFixationPoint(Vector &fp, Stamp *stamp)
+{
+    mutex.wait();
+    fp=getFixation(Time::now());
+    mutex.post();
+
+    if (stamp!=NULL)
+        stamp->update();
+
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getAngles(Vector &ang, Stamp *stamp)
+{
+    Vector fp;
+    getFixationPoint(fp,stamp);
+    return getAnglesFrom3DPoint(fp,ang);
+}
+/**********************************************************/
+bool SimGazeControl::lookAtFixationPoint(const Vector &fp)
+{
+    mutex.wait();
+    bool ok=lookAt(fp);
+    mutex.post();
+
+    return ok;
+}
+/**********************************************************/
+bool SimGazeControl::lookAtAbsAngles(const Vector &ang)
+{
+    Vector fp;
+    return (get3DPointFromAngles(0,ang,fp) && lookAtFixationPoint(fp));
+}
+/**********************************************************/
+bool SimGazeControl::lookAtRelAngles(const Vector &ang)
+{
+    Vector fp;
+    return (get3DPointFromAngles(1,ang,fp) && lookAtFixationPoint(fp));
+}
+/**********************************************************/
+bool SimGazeControl::lookAtMonoPixel(const int camSel, const Vector &px, const double z)
+{
+    Vector fp;
+    return (get3DPoint(camSel,px,z,fp) && lookAtFixationPoint(fp));
+}
+/**********************************************************/
+bool SimGazeControl::lookAtMonoPixelWithVergence(const int camSel, const Vector &px,
+                                                 const double ver)
+{
+    // depth of the fixation point for the given vergence
+    if (ver<=0.0)
+        return false;
+
+    double b=norm(eyeCenter[0]-eyeCenter[1]);
+    double z=0.5*b/tan(0.5*CTRL_DEG2RAD*ver);
+    return lookAtMonoPixel(camSel,px,z);
+}
+/**********************************************************/
+bool SimGazeControl::lookAtStereoPixels(const Vector &pxl, const Vector &pxr)
+{
+    Vector fp;
+    return (triangulate3DPoint(pxl,pxr,fp) && lookAtFixationPoint(fp));
+}
+/**********************************************************/
+bool SimGazeControl::lookAtFixationPointSync(const Vector &fp)
+{
+    return lookAtFixationPoint(fp);
+}
+/**********************************************************/
+bool SimGazeControl::lookAtAbsAnglesSync(const Vector &ang)
+{
+    return lookAtAbsAngles(ang);
+}
+/**********************************************************/
+bool SimGazeControl::lookAtRelAnglesSync(const Vector &ang)
+{
+    return lookAtRelAngles(ang);
+}
+/**********************************************************/
+bool SimGazeControl::lookAtMonoPixelSync(const int camSel, const Vector &px, const double z)
+{
+    return lookAtMonoPixel(camSel,px,z);
+}
+/**********************************************************/
+bool SimGazeControl::lookAtMonoPixelWithVergenceSync(const int camSel, const Vector &px,
+                                                     const double ver)
+{
+    return lookAtMonoPixelWithVergence(camSel,px,ver);
+}
+/**********************************************************/
+bool SimGazeControl::lookAtStereoPixelsSync(const Vector &pxl, const Vector &pxr)
+{
+    return lookAtStereoPixels(pxl,pxr);
+}
+/**********************************************************/
+bool SimGazeControl::getNeckTrajTime(double *t)
+{
+    *t=ctx.neckTrajTime;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getEyesTrajTime(double *t)
+{
+    *t=ctx.eyesTrajTime;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getVORGain(double *gain)
+{
+    *gain=ctx.vorGain;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getOCRGain(double *gain)
+{
+    *gain=ctx.ocrGain;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getSaccadesStatus(bool *f)
+{
+    *f=ctx.saccadesStatus;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getSaccadesInhibitionPeriod(double *period)
+{
+    *period=ctx.saccadesInhibitionPeriod;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getSaccadesActivationAngle(double *angle)
+{
+    *angle=ctx.saccadesActivationAngle;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getPose(const int type, Vector &x, Vector &o, Stamp *stamp)
+{
+    if ((type<0) || (type>2))
+        return false;
+
+    mutex.wait();
+    Matrix H=getEyeFrame(type==1?1:0,Time::now());
+    if (type==2)
+        H.setSubcol(getHeadCenter(),0,3);
+    mutex.post();
+
+    toPose(H,x,o);
+    if (stamp!=NULL)
+        stamp->update();
+
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getLeftEyePose(Vector &x, Vector &o, Stamp *stamp)
+{
+    return getPose(0,x,o,stamp);
+}
+/**********************************************************/
+bool SimGazeControl::getRightEyePose(Vector &x, Vector &o, Stamp *stamp)
+{
+    return getPose(1,x,o,stamp);
+}
+/**********************************************************/
+bool SimGazeControl::getHeadPose(Vector &x, Vector &o, Stamp *stamp)
+{
+    return getPose(2,x,o,stamp);
+}
+/**********************************************************/
+bool SimGazeControl::get2DPixel(const int camSel, const Vector &x, Vector &px)
+{
+    if (x.length()<3)
+        return false;
+
+    int cam=(camSel==0)?0:1;
+
+    mutex.wait();
+    Matrix H=getEyeFrame(cam,Time::now());
+    mutex.post();
+
+    Vector _x=x.subVector(0,2);
+    _x.push_back(1.0);
+    Vector p=Prj[cam]*SE3inv(H)*_x;
+    if (p[2]<=0.0)
+        return false;
+
+    px.resize(2);
+    px[0]=p[0]/p[2];
+    px[1]=p[1]/p[2];
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::get3DPoint(const int camSel, const Vector &px, const double depth,
+                                Vector &x)
+{
+    mutex.wait();
+    Vector c,d;
+    bool ok=getRay(camSel,px,c,d);
+    mutex.post();
+
+    // d has unit component along the optical axis
+    if (ok)
+        x=c+depth*d;
+
+    return ok;
+}
+/**********************************************************/
+bool SimGazeControl::get3DPointOnPlane(const int camSel, const Vector &px, const Vector &plane,
+                                       Vector &x)
+{
+    if (plane.length()<4)
+        return false;
+
+    mutex.wait();
+    Vector c,d;
+    bool ok=getRay(camSel,px,c,d);
+    mutex.post();
+
+    if (!ok)
+        return false;
+
+    Vector n=plane.subVector(0,2);
+    double den=dot(n,d);
+    if (fabs(den)<1e-9)
+        return false;
+
+    double t=-(dot(n,c)+plane[3])/den;
+    if (t<=0.0)
+        return false;
+
+    x=c+t*d;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::get3DPointFromAngles(const int mode, const Vector &ang, Vector &x)
+{
+    if (ang.length()<3)
+        return false;
+
+    // azimuth positive rightward, elevation positive upward
+    Vector _ang=ang.subVector(0,2);
+    if (mode==1)
+    {
+        Vector cur;
+        getAngles(cur);
+        _ang=_ang+cur;
+    }
+
+    double b=norm(eyeCenter[0]-eyeCenter[1]);
+    double dist=(_ang[2]>0.0)?0.5*b/tan(0.5*CTRL_DEG2RAD*_ang[2]):10.0;
+    double azi=CTRL_DEG2RAD*_ang[0];
+    double ele=CTRL_DEG2RAD*_ang[1];
+
+    Vector d(3);
+    d[0]=-cos(ele)*cos(azi);
+    d[1]=cos(ele)*sin(azi);
+    d[2]=sin(ele);
+
+    x=getHeadCenter()+dist*d;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getAnglesFrom3DPoint(const Vector &x, Vector &ang)
+{
+    if (x.length()<3)
+        return false;
+
+    Vector d=x.subVector(0,2)-getHeadCenter();
+    Vector dl=x.subVector(0,2)-eyeCenter[0];
+    Vector dr=x.subVector(0,2)-eyeCenter[1];
+
+    ang.resize(3);
+    ang[0]=CTRL_RAD2DEG*atan2(d[1],-d[0]);
+    ang[1]=CTRL_RAD2DEG*atan2(d[2],sqrt(d[0]*d[0]+d[1]*d[1]));
+    ang[2]=CTRL_RAD2DEG*acos(std::max(-1.0,std::min(1.0,dot(dl,dr)/(norm(dl)*norm(dr)))));
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::triangulate3DPoint(const Vector &pxl, const Vector &pxr, Vector &x)
+{
+    mutex.wait();
+    Vector cl,dl,cr,dr;
+    bool ok=getRay(0,pxl,cl,dl) && getRay(1,pxr,cr,dr);
+    mutex.post();
+
+    if (!ok)
+        return false;
+
+    // midpoint of the shortest segment between the two rays
+    Vector w=cl-cr;
+    double a=dot(dl,dl),b=dot(dl,dr),c=dot(dr,dr);
+    double d=dot(dl,w),e=dot(dr,w);
+    double den=a*c-b*b;
+    if (fabs(den)<1e-9)
+        return false;
+
+    double sl=(b*e-c*d)/den;
+    double sr=(a*e-b*d)/den;
+    x=0.5*((cl+sl*dl)+(cr+sr*dr));
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getJointsDesired(Vector &qdes)
+{
+    // the head joints are not simulated
+    qdes.resize(6,0.0);
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getJointsVelocities(Vector &qdot)
+{
+    qdot.resize(6,0.0);
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getStereoOptions(Bottle &options)
+{
+    options=stereoOptions;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::setNeckTrajTime(const double t)
+{
+    ctx.neckTrajTime=std::max(t,0.0);
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::setEyesTrajTime(const double t)
+{
+    ctx.eyesTrajTime=std::max(t,0.0);
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::setVORGain(const double gain)
+{
+    ctx.vorGain=gain;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::setOCRGain(const double gain)
+{
+    ctx.ocrGain=gain;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::setSaccadesStatus(const bool f)
+{
+    ctx.saccadesStatus=f;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::setSaccadesInhibitionPeriod(const double period)
+{
+    ctx.saccadesInhibitionPeriod=period;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::setSaccadesActivationAngle(const double angle)
+{
+    ctx.saccadesActivationAngle=angle;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::setStereoOptions(const Bottle &options)
+{
+    stereoOptions=options;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::bindNeckPitch(const double min, const double max)
+{
+    ctx.neckPitch[0]=min; ctx.neckPitch[1]=max;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::blockNeckPitch(const double val)
+{
+    return bindNeckPitch(val,val);
+}
+/**********************************************************/
+bool SimGazeControl::blockNeckPitch()
+{
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::bindNeckRoll(const double min, const double max)
+{
+    ctx.neckRoll[0]=min; ctx.neckRoll[1]=max;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::blockNeckRoll(const double val)
+{
+    return bindNeckRoll(val,val);
+}
+/**********************************************************/
+bool SimGazeControl::blockNeckRoll()
+{
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::bindNeckYaw(const double min, const double max)
+{
+    ctx.neckYaw[0]=min; ctx.neckYaw[1]=max;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::blockNeckYaw(const double val)
+{
+    return bindNeckYaw(val,val);
+}
+/**********************************************************/
+bool SimGazeControl::blockNeckYaw()
+{
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::blockEyes(const double ver)
+{
+    ctx.blockedVergence=ver;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::blockEyes()
+{
+    Vector ang;
+    getAngles(ang);
+    return blockEyes(ang[2]);
+}
+/**********************************************************/
+bool SimGazeControl::getNeckPitchRange(double *min, double *max)
+{
+    *min=ctx.neckPitch[0]; *max=ctx.neckPitch[1];
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getNeckRollRange(double *min, double *max)
+{
+    *min=ctx.neckRoll[0]; *max=ctx.neckRoll[1];
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getNeckYawRange(double *min, double *max)
+{
+    *min=ctx.neckYaw[0]; *max=ctx.neckYaw[1];
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getBlockedVergence(double *ver)
+{
+    *ver=ctx.blockedVergence;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::clearNeckPitch()
+{
+    return bindNeckPitch(-40.0,30.0);
+}
+/**********************************************************/
+bool SimGazeControl::clearNeckRoll()
+{
+    return bindNeckRoll(-20.0,20.0);
+}
+/**********************************************************/
+bool SimGazeControl::clearNeckYaw()
+{
+    return bindNeckYaw(-45.0,45.0);
+}
+/**********************************************************/
+bool SimGazeControl::clearEyes()
+{
+    ctx.blockedVergence=-1.0;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::getNeckAngleUserTolerance(double *angle)
+{
+    *angle=ctx.neckTol;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::setNeckAngleUserTolerance(const double angle)
+{
+    ctx.neckTol=angle;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::checkMotionDone(bool *f)
+{
+    mutex.wait();
+    *f=(Time::now()>=tStart+duration);
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::waitMotionDone(const double period, const double timeout)
+{
+    mutex.wait();
+    double tEnd=tStart+duration;
+    mutex.post();
+
+    return waitUntil(tEnd,period,timeout);
+}
+/**********************************************************/
+bool SimGazeControl::checkSaccadeDone(bool *f)
+{
+    *f=true;
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::waitSaccadeDone(const double period, const double timeout)
+{
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::stopControl()
+{
+    mutex.wait();
+    fpStart=fpTarget=getFixation(Time::now());
+    duration=0.0;
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::storeContext(int *id)
+{
+    mutex.wait();
+    *id=contextIdCnt++;
+    contexts[*id]=ctx;
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::restoreContext(const int id)
+{
+    mutex.wait();
+    map<int,Context>::iterator it=contexts.find(id);
+    bool ok=(it!=contexts.end());
+    if (ok)
+        ctx=it->second;
+    mutex.post();
+
+    return ok;
+}
+/**********************************************************/
+bool SimGazeControl::deleteContext(const int id)
+{
+    mutex.wait();
+    bool ok=(contexts.erase(id)>0);
+    mutex.post();
+
+    return ok;
+}
+/**********************************************************/
+bool SimGazeControl::getInfo(Bottle &info)
+{
+    info.clear();
+
+    const char *tag[2]={"camera_intrinsics_left","camera_intrinsics_right"};
+    for (int i=0; i<2; i++)
+    {
+        Bottle &intrinsics=info.addList();
+        intrinsics.addString(tag[i]);
+        Bottle &values=intrinsics.addList();
+        for (int r=0; r<Prj[i].rows(); r++)
+            for (int c=0; c<Prj[i].cols(); c++)
+                values.addDouble(Prj[i](r,c));
+    }
+
+    Bottle &sim=info.addList();
+    sim.addString("simulator");
+    sim.addString("karmaMotor");
+
+    return true;
+}
+/**********************************************************/
+bool SimGazeControl::registerEvent(GazeEvent &event)
+{
+    return false;
+}
+/**********************************************************/
+bool SimGazeControl::unregisterEvent(GazeEvent &event)
+{
+    return false;
+}
+/**********************************************************/
+bool SimGazeControl::tweakSet(const Bottle &options)
+{
+    return false;
+}
+/**********************************************************/
+bool SimGazeControl::tweakGet(Bottle &options)
+{
+    options.clear();
+    return true;
+}
+/**********************************************************/
+SimControlBoard::SimControlBoard() : nAxes(0), tLast(0.0)
+{
+}
+/**********************************************************/
+bool SimControlBoard::open(Searchable &config)
+{
+    nAxes=config.check("axes",Value(16)).asInt();
+    if (nAxes<=0)
+        return false;
+
+    q.resize(nAxes,0.0);
+    qdot.resize(nAxes,0.0);
+    acc.resize(nAxes,1e9);
+    modes.resize(nAxes,VOCAB_CM_POSITION);
+    tLast=Time::now();
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::close()
+{
+    return true;
+}
+/**********************************************************/
+void SimControlBoard::integrate()
+{
+    // joints in velocity mode track the reference ideally
+    double t=Time::now();
+    double dt=t-tLast;
+    for (int j=0; j<nAxes; j++)
+        if ((int)modes[j]==VOCAB_CM_VELOCITY)
+            q[j]+=qdot[j]*dt;
+
+    tLast=t;
+}
+/**********************************************************/
+bool SimControlBoard::isValidAxis(const int j) const
+{
+    return ((j>=0) && (j<nAxes));
+}
+/**********************************************************/
+bool SimControlBoard::getAxes(int *ax)
+{
+    *ax=nAxes;
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::resetEncoder(int j)
+{
+    return setEncoder(j,0.0);
+}
+/**********************************************************/
+bool SimControlBoard::resetEncoders()
+{
+    mutex.wait();
+    integrate();
+    q=0.0;
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::setEncoder(int j, double val)
+{
+    if (!isValidAxis(j))
+        return false;
+
+    mutex.wait();
+    integrate();
+    q[j]=val;
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::setEncoders(const double *vals)
+{
+    mutex.wait();
+    integrate();
+    for (int j=0; j<nAxes; j++)
+        q[j]=vals[j];
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::getEncoder(int j, double *v)
+{
+    if (!isValidAxis(j))
+        return false;
+
+    mutex.wait();
+    integrate();
+    *v=q[j];
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::getEncoders(double *encs)
+{
+    mutex.wait();
+    integrate();
+    for (int j=0; j<nAxes; j++)
+        encs[j]=q[j];
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::getEncoderSpeeds(double *spds)
+{
+    mutex.wait();
+    for (int j=0; j<nAxes; j++)
+        spds[j]=((int)modes[j]==VOCAB_CM_VELOCITY)?qdot[j]:0.0;
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::getEncoderSpeed(int j, double *sp)
+{
+    if (!isValidAxis(j))
+        return false;
+
+    mutex.wait();
+    *sp=((int)modes[j]==VOCAB_CM_VELOCITY)?qdot[j]:0.0;
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::getEncoderAccelerations(double *accs)
+{
+    for (int j=0; j<nAxes; j++)
+        accs[j]=0.0;
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::getEncoderAcceleration(int j, double *spds)
+{
+    if (!isValidAxis(j))
+        return false;
+
+    *spds=0.0;
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::setVelocityMode()
+{
+    mutex.wait();
+    integrate();
+    modes=VOCAB_CM_VELOCITY;
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::velocityMove(int j, double sp)
+{
+    if (!isValidAxis(j))
+        return false;
+
+    mutex.wait();
+    integrate();
+    qdot[j]=sp;
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::velocityMove(const double *sp)
+{
+    mutex.wait();
+    integrate();
+    for (int j=0; j<nAxes; j++)
+        qdot[j]=sp[j];
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::setRefAcceleration(int j, double acc)
+{
+    if (!isValidAxis(j))
+        return false;
+
+    this->acc[j]=acc;
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::setRefAccelerations(const double *accs)
+{
+    for (int j=0; j<nAxes; j++)
+        acc[j]=accs[j];
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::getRefAcceleration(int j, double *acc)
+{
+    if (!isValidAxis(j))
+        return false;
+
+    *acc=this->acc[j];
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::getRefAccelerations(double *accs)
+{
+    for (int j=0; j<nAxes; j++)
+        accs[j]=acc[j];
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::stop(int j)
+{
+    return velocityMove(j,0.0);
+}
+/**********************************************************/
+bool SimControlBoard::stop()
+{
+    mutex.wait();
+    integrate();
+    qdot=0.0;
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::setPositionMode(int j)
+{
+    return setControlMode(j,VOCAB_CM_POSITION);
+}
+/**********************************************************/
+bool SimControlBoard::setVelocityMode(int j)
+{
+    return setControlMode(j,VOCAB_CM_VELOCITY);
+}
+/**********************************************************/
+bool SimControlBoard::setTorqueMode(int j)
+{
+    return setControlMode(j,VOCAB_CM_TORQUE);
+}
+/**********************************************************/
+bool SimControlBoard::setImpedancePositionMode(int j)
+{
+    return setControlMode(j,VOCAB_CM_IMPEDANCE_POS);
+}
+/**********************************************************/
+bool SimControlBoard::setImpedanceVelocityMode(int j)
+{
+    return setControlMode(j,VOCAB_CM_IMPEDANCE_VEL);
+}
+/**********************************************************/
+bool SimControlBoard::setOpenLoopMode(int j)
+{
+    return setControlMode(j,VOCAB_CM_OPENLOOP);
+}
+/**********************************************************/
+bool SimControlBoard::getControlMode(int j, int *mode)
+{
+    if (!isValidAxis(j))
+        return false;
+
+    *mode=(int)modes[j];
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::getControlModes(int *modes)
+{
+    for (int j=0; j<nAxes; j++)
+        modes[j]=(int)this->modes[j];
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::getControlModes(const int n_joint, const int *joints, int *modes)
+{
+    for (int i=0; i<n_joint; i++)
+        if (!getControlMode(joints[i],&modes[i]))
+            return false;
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::setControlMode(const int j, const int mode)
+{
+    if (!isValidAxis(j))
+        return false;
+
+    mutex.wait();
+    integrate();
+    modes[j]=mode;
+    if (mode!=VOCAB_CM_VELOCITY)
+        qdot[j]=0.0;
+    mutex.post();
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::setControlModes(const int n_joint, const int *joints, int *modes)
+{
+    for (int i=0; i<n_joint; i++)
+        if (!setControlMode(joints[i],modes[i]))
+            return false;
+
+    return true;
+}
+/**********************************************************/
+bool SimControlBoard::setControlModes(int *modes)
+{
+    for (int j=0; j<nAxes; j++)
+        if (!setControlMode(j,modes[j]))
+            return false;
+
+    return true;
+}
+/**********************************************************/
+void registerSimDevices()
+{
+    Drivers::factory().add(new DriverCreatorOf<SimCartesianControl>("karmasimcartesian","","SimCartesianControl"));
+    Drivers::factory().add(new DriverCreatorOf<SimGazeControl>("karmasimgaze","","SimGazeControl"));
+    Drivers::factory().add(new DriverCreatorOf<SimControlBoard>("karmasimcontrolboard","","SimControlBoard"));
+}
+
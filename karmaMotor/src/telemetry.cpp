@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <string.h>
+#include <math.h>
+
+#include <yarp/os/Time.h>
+#include <yarp/math/Math.h>
+
+#include "iCub/se3.h"
+#include "iCub/telemetry.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::dev;
+using namespace yarp::math;
+
+
+/**********************************************************/
+ActionRecord::ActionRecord(const string &action) : id(-1), action(action), arm("none"),
+                                                   errPos(-1.0), errRot(-1.0)
+{
+    tStart=tPhase=Time::now();
+}
+/**********************************************************/
+void ActionRecord::begin(const string &phase)
+{
+    this->phase=phase;
+    tPhase=Time::now();
+}
+/**********************************************************/
+void ActionRecord::end(const bool done)
+{
+    add(phase,Time::now()-tPhase,done);
+}
+/**********************************************************/
+void ActionRecord::add(const string &phase, const double duration, const bool done)
+{
+    Phase p;
+    p.name=phase;
+    p.duration=duration;
+    p.done=done;
+    phases.push_back(p);
+}
+/**********************************************************/
+void ActionRecord::measurePoseError(ICartesianControl *iarm, const Vector &xd,
+                                    const Vector &od)
+{
+    Vector x,o;
+    if (!iarm->getPose(x,o) || (xd.length()<3) || (od.length()<4))
+        return;
+
+    errPos=norm(xd-x);
+
+    SE3 Rd=SE3::rotation(od[0],od[1],od[2],od[3]);
+    SE3 R=SE3::rotation(o[0],o[1],o[2],o[3]);
+    double r[4];
+    (Rd.inverse()*R).getAxis(r);
+    errRot=fabs(r[3]);
+}
+/**********************************************************/
+Telemetry::Telemetry() : log(NULL)
+{
+}
+/**********************************************************/
+bool Telemetry::open(const string &portName, const string &logFile)
+{
+    if (!port.open(portName.c_str()))
+        return false;
+
+    if (!logFile.empty())
+    {
+        log=fopen(logFile.c_str(),"wb");
+        if (log==NULL)
+        {
+            printf("unable to open the telemetry log %s\n",logFile.c_str());
+            return false;
+        }
+
+        char magic[8];
+        strncpy(magic,TELEMETRY_MAGIC,sizeof(magic));
+        fwrite(magic,sizeof(magic),1,log);
+    }
+
+    return true;
+}
+/**********************************************************/
+void Telemetry::close()
+{
+    mutex.wait();
+    if (log!=NULL)
+    {
+        fclose(log);
+        log=NULL;
+    }
+    mutex.post();
+
+    port.interrupt();
+    port.close();
+}
+/**********************************************************/
+void Telemetry::publish(const ActionRecord &record)
+{
+    double total=Time::now()-record.tStart;
+
+    mutex.wait();
+
+    // the record is formatted only if someone is listening
+    if (port.getOutputCount()>0)
+    {
+        Bottle &b=port.prepare();
+        b.clear();
+        b.addInt(record.id);
+        b.addString(record.action.c_str());
+        b.addString(record.arm.c_str());
+        b.addDouble(total);
+
+        Bottle &phases=b.addList();
+        for (size_t i=0; i<record.phases.size(); i++)
+        {
+            Bottle &phase=phases.addList();
+            phase.addString(record.phases[i].name.c_str());
+            phase.addDouble(record.phases[i].duration);
+            phase.addInt(record.phases[i].done?1:0);
+        }
+
+        Bottle &error=b.addList();
+        error.addDouble(record.errPos);
+        error.addDouble(record.errRot);
+
+        port.write();
+    }
+
+    // buffered by the stream: the disk is hit only once in a while
+    if (log!=NULL)
+    {
+        TelemetryHeader header;
+        memset(&header,0,sizeof(header));
+        header.id=record.id;
+        header.nPhases=(int)record.phases.size();
+        header.tStart=record.tStart;
+        header.total=total;
+        header.errPos=record.errPos;
+        header.errRot=record.errRot;
+        strncpy(header.action,record.action.c_str(),sizeof(header.action)-1);
+        strncpy(header.arm,record.arm.c_str(),sizeof(header.arm)-1);
+        fwrite(&header,sizeof(header),1,log);
+
+        for (size_t i=0; i<record.phases.size(); i++)
+        {
+            TelemetryPhase phase;
+            memset(&phase,0,sizeof(phase));
+            strncpy(phase.name,record.phases[i].name.c_str(),sizeof(phase.name)-1);
+            phase.duration=record.phases[i].duration;
+            phase.done=record.phases[i].done?1:0;
+            fwrite(&phase,sizeof(phase),1,log);
+        }
+    }
+    mutex.post();
+}
+/**********************************************************/
+Telemetry::~Telemetry()
+{
+    if (log!=NULL)
+        fclose(log);
+}
+
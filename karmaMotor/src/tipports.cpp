@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <math.h>
+
+#include <yarp/os/Time.h>
+#include <yarp/os/Vocab.h>
+
+#include "iCub/tipports.h"
+
+// window over which the detections are averaged [s], minimum
+// number of detections and tolerance on the mean vertical pixel
+#define TIPTRACKER_WINDOW       3.0
+#define TIPTRACKER_MIN_ITEMS    20
+#define TIPTRACKER_TARGET_V     120.0
+#define TIPTRACKER_TOL_V        30.0
+
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::dev;
+
+
+/**********************************************************/
+TipTrackerPort::TipTrackerPort() : iGaze(NULL), settled(0), pxCum(2,0.0),
+                                   tracking(false), camSel(0), cnt(0), t0(0.0)
+{
+    useCallback();
+}
+/**********************************************************/
+void TipTrackerPort::onRead(Bottle &target)
+{
+    if (target.size()<2)
+        return;
+
+    mutex.wait();
+    if (tracking)
+    {
+        Vector px(2);
+        px[0]=target.get(0).asDouble();
+        px[1]=target.get(1).asDouble()+50.0;
+        iGaze->lookAtMonoPixel(camSel,px);
+
+        pxCum+=px;
+        cnt++;
+
+        double t=Time::now();
+        if (t-t0>=TIPTRACKER_WINDOW)
+        {
+            if ((cnt>TIPTRACKER_MIN_ITEMS) &&
+                (fabs(pxCum[1]/cnt-TIPTRACKER_TARGET_V)<TIPTRACKER_TOL_V))
+                settled.post();
+
+            pxCum=0.0;
+            cnt=0;
+            t0=t;
+        }
+    }
+    mutex.post();
+}
+/**********************************************************/
+void TipTrackerPort::track(IGazeControl *iGaze, const int camSel)
+{
+    mutex.wait();
+    while (settled.check());
+    this->iGaze=iGaze;
+    this->camSel=camSel;
+    pxCum=0.0;
+    cnt=0;
+    t0=Time::now();
+    tracking=true;
+    mutex.post();
+}
+/**********************************************************/
+void TipTrackerPort::stopTracking()
+{
+    mutex.wait();
+    tracking=false;
+    mutex.post();
+}
+/**********************************************************/
+bool TipTrackerPort::waitSettled(const double timeout)
+{
+    return settled.waitWithTimeout(timeout);
+}
+/**********************************************************/
+FinderStatusPort::FinderStatusPort() : reached(0), num(0), target(-1)
+{
+    useCallback();
+}
+/**********************************************************/
+void FinderStatusPort::onRead(Bottle &status)
+{
+    if ((status.size()<2) || (status.get(0).asVocab()!=Vocab::encode("num")))
+        return;
+
+    mutex.wait();
+    num=status.get(1).asInt();
+    if ((target>=0) && (num>=target))
+    {
+        target=-1;
+        reached.post();
+    }
+    mutex.post();
+}
+/**********************************************************/
+void FinderStatusPort::setTarget(const int target)
+{
+    mutex.wait();
+    while (reached.check());
+    this->target=target;
+
+    // the target might have been reached already
+    if (num>=target)
+    {
+        this->target=-1;
+        reached.post();
+    }
+    mutex.post();
+}
+/**********************************************************/
+bool FinderStatusPort::waitTarget(const double timeout)
+{
+    return reached.waitWithTimeout(timeout);
+}
+
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __LIBRARY_H__
+#define __LIBRARY_H__
+
+#include <string>
+#include <deque>
+
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+#include "iCub/log.h"
+
+/**********************************************************/
+struct ToolEntry
+{
+    std::string       name;
+    yarp::sig::Vector tip;      // tool tip wrt hand reference frame
+    yarp::sig::Matrix cov;      // 3x3 covariance of the tip (may be empty)
+    yarp::sig::Vector frame;    // tool frame wrt hand reference frame as
+                                // x y z ax ay az theta (may be empty)
+    double            error;    // mean reprojection error in pixels
+    int               numItems; // number of items used for the estimate
+};
+/**********************************************************/
+class ToolLibrary
+{
+protected:
+    std::string path;
+
+    std::string getEntryFile(const std::string &name) const;
+    std::string getItemsFile(const std::string &name) const;
+
+public:
+    ToolLibrary();
+    bool setPath(const std::string &path);
+    static bool isValidName(const std::string &name);
+    bool save(const ToolEntry &entry, const std::deque<ItemRecord> &items);
+    bool recall(const std::string &name, ToolEntry &entry) const;
+};
+
+#endif
+
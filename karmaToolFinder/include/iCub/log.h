@@ -0,0 +1,77 @@
+/* 
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __LOG_H__
+#define __LOG_H__
+
+#include <stdio.h>
+#include <string>
+#include <deque>
+
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+#define ITEMLOG_MAGIC       "KTFLOG"
+#define ITEMLOG_VERSION     2
+#define ITEMLOG_MAX_FEAT    3
+
+/**********************************************************/
+struct ItemRecord
+{
+    double t;           // time stamp of the detection
+    double cam;         // 0 for left camera, 1 for right camera, -1 if unknown
+    double nFeat;       // number of tracked features
+    double p[2*ITEMLOG_MAX_FEAT];   // pixels of the features, the tip first
+    double H[12];       // 3x4 projection matrix Prj*inv(He)*Ha
+    double Prj[12];     // 3x4 camera intrinsics
+    double Ha[16];      // 4x4 hand frame
+    double He[16];      // 4x4 eye frame
+};
+/**********************************************************/
+struct ItemLogHeader
+{
+    char         magic[8];
+    unsigned int version;
+    unsigned int recordSize;
+};
+/**********************************************************/
+class ItemLogWriter
+{
+protected:
+    FILE *fout;
+
+public:
+    ItemLogWriter();
+    bool open(const std::string &fileName);
+    bool write(const ItemRecord &record);
+    void close();
+    ~ItemLogWriter();
+};
+/**********************************************************/
+void fillItemRecord(ItemRecord &record, const double t, const int cam,
+                    const yarp::sig::Vector &p, const yarp::sig::Matrix &H,
+                    const yarp::sig::Matrix &Prj, const yarp::sig::Matrix &Ha,
+                    const yarp::sig::Matrix &He);
+void fillItemRecord(ItemRecord &record, const double t,
+                    const yarp::sig::Vector &p, const yarp::sig::Matrix &H);
+void getItemRecord(const ItemRecord &record, yarp::sig::Vector &p,
+                   yarp::sig::Matrix &H);
+void itemRecordToVector(const ItemRecord &record, yarp::sig::Vector &v);
+bool loadItemLog(const std::string &fileName, std::deque<ItemRecord> &records);
+
+#endif
+
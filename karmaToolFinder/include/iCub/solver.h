@@ -0,0 +1,270 @@
+/* 
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __SOLVER_H__
+#define __SOLVER_H__
+
+#include <string>
+#include <deque>
+
+#include <yarp/os/Thread.h>
+#include <yarp/os/Semaphore.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+#include <IpTNLP.hpp>
+#include <IpIpoptApplication.hpp>
+
+
+// The linear solver employed by IPOPT by default (MUMPS) is not
+// thread-safe: all the solves are serialized across the workers,
+// unless a thread-safe linear solver is configured.
+/****************************************************************/
+class IpoptLock
+{
+public:
+    static void setThreadSafe(const bool threadSafe);
+    static void lock();
+    static void unlock();
+};
+
+
+/****************************************************************/
+class FindToolTipNLP : public Ipopt::TNLP
+{
+protected:
+    const std::deque<yarp::sig::Vector> &p;
+    const std::deque<yarp::sig::Matrix> &H;
+
+    yarp::sig::Vector min;
+    yarp::sig::Vector max;
+    yarp::sig::Vector x0;
+    yarp::sig::Vector x;
+
+public:
+    FindToolTipNLP(const std::deque<yarp::sig::Vector> &_p,
+                   const std::deque<yarp::sig::Matrix> &_H,
+                   const yarp::sig::Vector &_min, const yarp::sig::Vector &_max);
+
+    void set_bounds(const yarp::sig::Vector &min, const yarp::sig::Vector &max);
+    void set_x0(const yarp::sig::Vector &x0);
+    yarp::sig::Vector get_result() const;
+
+    bool get_nlp_info(Ipopt::Index &n, Ipopt::Index &m, Ipopt::Index &nnz_jac_g,
+                      Ipopt::Index &nnz_h_lag, IndexStyleEnum &index_style);
+    bool get_bounds_info(Ipopt::Index n, Ipopt::Number *x_l, Ipopt::Number *x_u,
+                         Ipopt::Index m, Ipopt::Number *g_l, Ipopt::Number *g_u);
+    bool get_starting_point(Ipopt::Index n, bool init_x, Ipopt::Number *x,
+                            bool init_z, Ipopt::Number *z_L, Ipopt::Number *z_U,
+                            Ipopt::Index m, bool init_lambda, Ipopt::Number *lambda);
+    bool eval_f(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                Ipopt::Number &obj_value);
+    bool eval_grad_f(Ipopt::Index n, const Ipopt::Number* x, bool new_x,
+                     Ipopt::Number *grad_f);
+    bool eval_g(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                Ipopt::Index m, Ipopt::Number *g);
+    bool eval_jac_g(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                    Ipopt::Index m, Ipopt::Index nele_jac, Ipopt::Index *iRow,
+                    Ipopt::Index *jCol, Ipopt::Number *values);
+    bool eval_h(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                Ipopt::Number obj_factor, Ipopt::Index m, const Ipopt::Number *lambda,
+                bool new_lambda, Ipopt::Index nele_hess, Ipopt::Index *iRow,
+                Ipopt::Index *jCol, Ipopt::Number *values);
+    void finalize_solution(Ipopt::SolverReturn status, Ipopt::Index n,
+                           const Ipopt::Number *x, const Ipopt::Number *z_L,
+                           const Ipopt::Number *z_U, Ipopt::Index m,
+                           const Ipopt::Number *g, const Ipopt::Number *lambda,
+                           Ipopt::Number obj_value, const Ipopt::IpoptData *ip_data,
+                           Ipopt::IpoptCalculatedQuantities *ip_cq);
+};
+
+
+class FindToolTip;
+
+/****************************************************************/
+class FindToolTipWorker : public yarp::os::Thread
+{
+protected:
+    FindToolTip         *solver;
+    int                  id;
+    yarp::os::Semaphore  go;
+    yarp::os::Semaphore  done;
+
+    void run();
+    void onStop();
+
+public:
+    FindToolTipWorker(FindToolTip *solver, const int id);
+    void trigger();
+    void waitDone();
+};
+
+
+/****************************************************************/
+class FindToolTip
+{
+protected:
+    struct Context
+    {
+        Ipopt::SmartPtr<Ipopt::IpoptApplication> app;
+        Ipopt::SmartPtr<FindToolTipNLP>          nlp;
+    };
+
+    yarp::sig::Vector min;
+    yarp::sig::Vector max;
+    yarp::sig::Vector x0;
+    yarp::sig::Vector xprev;
+    bool              warm_start;
+    bool              multi_start;
+    double            tol;
+    int               max_iter;
+    std::string       linear_solver;
+
+    std::deque<yarp::sig::Vector> p;
+    std::deque<yarp::sig::Matrix> H;
+
+    // the solver contexts are kept alive across calls to solve():
+    // the nlps refer directly to the items store; the context i is
+    // used by the worker i, the first one by the calling thread
+    std::deque<Context>            contexts;
+    std::deque<FindToolTipWorker*> workers;
+
+    // multi-start jobs shared among the workers
+    yarp::os::Semaphore            mutexJobs;
+    std::deque<yarp::sig::Vector>  starts;
+    std::deque<yarp::sig::Vector>  results;
+    std::deque<bool>               statuses;
+    std::deque<int>                iterations;
+    size_t                         nextJob;
+    int                            lastIterations;
+
+    friend class FindToolTipWorker;
+
+    Context createContext();
+    void    stopWorkers();
+    void    processStarts(const int id);
+    bool    getLinearEstimate(yarp::sig::Vector &x) const;
+    bool    isInFront(const yarp::sig::Vector &x) const;
+    bool    isInBounds(const yarp::sig::Vector &x) const;
+
+public:
+    FindToolTip();
+
+    void   setBounds(const yarp::sig::Vector &min, const yarp::sig::Vector &max);
+    void   setWarmStart(const bool sw);
+    void   setSolverOptions(const double tol, const int max_iter);
+    void   setLinearSolver(const std::string &linear_solver);
+    void   setMultiStart(const bool sw, const int nThreads=1);
+    bool   addItem(const yarp::sig::Vector &pi, const yarp::sig::Matrix &Hi);
+    void   clearItems();
+    size_t getNumItems() const;
+    bool   setInitialGuess(const yarp::sig::Vector &x0);
+    double evalError(const yarp::sig::Vector &x) const;
+    bool   evalCovariance(const yarp::sig::Vector &x, yarp::sig::Matrix &cov,
+                          double &cond) const;
+    bool   solve(yarp::sig::Vector &x, double &error, const bool fast=false);
+    int    getNumIterations() const;
+    virtual ~FindToolTip();
+};
+
+
+/****************************************************************/
+class FindToolFrameNLP : public Ipopt::TNLP
+{
+protected:
+    const std::deque<yarp::sig::Vector> &p;
+    const std::deque<yarp::sig::Matrix> &H;
+    int numFeatures;
+
+    yarp::sig::Vector min;
+    yarp::sig::Vector max;
+    yarp::sig::Vector x0;
+    yarp::sig::Vector x;
+
+public:
+    FindToolFrameNLP(const std::deque<yarp::sig::Vector> &_p,
+                     const std::deque<yarp::sig::Matrix> &_H,
+                     const int _numFeatures, const yarp::sig::Vector &_min,
+                     const yarp::sig::Vector &_max);
+
+    void set_x0(const yarp::sig::Vector &x0);
+    yarp::sig::Vector get_result() const;
+
+    bool get_nlp_info(Ipopt::Index &n, Ipopt::Index &m, Ipopt::Index &nnz_jac_g,
+                      Ipopt::Index &nnz_h_lag, IndexStyleEnum &index_style);
+    bool get_bounds_info(Ipopt::Index n, Ipopt::Number *x_l, Ipopt::Number *x_u,
+                         Ipopt::Index m, Ipopt::Number *g_l, Ipopt::Number *g_u);
+    bool get_starting_point(Ipopt::Index n, bool init_x, Ipopt::Number *x,
+                            bool init_z, Ipopt::Number *z_L, Ipopt::Number *z_U,
+                            Ipopt::Index m, bool init_lambda, Ipopt::Number *lambda);
+    bool eval_f(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                Ipopt::Number &obj_value);
+    bool eval_grad_f(Ipopt::Index n, const Ipopt::Number* x, bool new_x,
+                     Ipopt::Number *grad_f);
+    bool eval_g(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                Ipopt::Index m, Ipopt::Number *g);
+    bool eval_jac_g(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                    Ipopt::Index m, Ipopt::Index nele_jac, Ipopt::Index *iRow,
+                    Ipopt::Index *jCol, Ipopt::Number *values);
+    bool eval_h(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                Ipopt::Number obj_factor, Ipopt::Index m, const Ipopt::Number *lambda,
+                bool new_lambda, Ipopt::Index nele_hess, Ipopt::Index *iRow,
+                Ipopt::Index *jCol, Ipopt::Number *values);
+    void finalize_solution(Ipopt::SolverReturn status, Ipopt::Index n,
+                           const Ipopt::Number *x, const Ipopt::Number *z_L,
+                           const Ipopt::Number *z_U, Ipopt::Index m,
+                           const Ipopt::Number *g, const Ipopt::Number *lambda,
+                           Ipopt::Number obj_value, const Ipopt::IpoptData *ip_data,
+                           Ipopt::IpoptCalculatedQuantities *ip_cq);
+};
+
+
+/****************************************************************/
+class FindToolFrame
+{
+protected:
+    // the unknowns are the tool frame wrt the hand, given as the
+    // tip position and the yaw-pitch-roll angles of the axes,
+    // followed by the tool geometry: the distance of the axis
+    // feature behind the tip along the x-axis and the position of
+    // the side marker in the xz-plane
+    Ipopt::SmartPtr<Ipopt::IpoptApplication> app;
+    Ipopt::SmartPtr<FindToolFrameNLP>        nlp;
+
+    int               numFeatures;
+    yarp::sig::Vector min;
+    yarp::sig::Vector max;
+    yarp::sig::Vector xprev;
+
+    std::deque<yarp::sig::Vector> p;
+    std::deque<yarp::sig::Matrix> H;
+
+    bool getLinearEstimate(yarp::sig::Vector &x) const;
+
+public:
+    FindToolFrame(const int numFeatures);
+
+    bool   addItem(const yarp::sig::Vector &pi, const yarp::sig::Matrix &Hi);
+    void   clearItems();
+    size_t getNumItems() const;
+    double evalError(const yarp::sig::Vector &x) const;
+    bool   solve(yarp::sig::Vector &x, double &error);
+    static yarp::sig::Matrix getFrame(const yarp::sig::Vector &x);
+};
+
+#endif
+
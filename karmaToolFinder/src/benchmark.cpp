@@ -0,0 +1,348 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/**
+\defgroup karmaToolFinderBenchmark Benchmark of the Tool Solver
+
+Assess speed and accuracy of the tool solver employed by \ref
+karmaToolFinder on synthetic data.
+
+\section intro_sec Description
+Hand poses are randomly generated within the workspace observed
+by a pinhole camera; the known tool tip is projected onto the
+image plane and corrupted with gaussian noise and outliers. The
+resulting items are fed into the solver used online, reporting
+for each combination of number of items and noise level the
+success rate along with the average solving time, the number of
+iterations and the error on the tool tip of the successful
+trials. Each trial is run by a fresh solver, so that no solution
+is carried over from one trial to the next. No robot nor YARP
+devices are required.
+
+\section lib_sec Libraries
+- YARP libraries.
+- IPOPT library.
+
+\section parameters_sec Parameters
+--tip <i>(x y z)</i>
+- The true tool tip wrt the hand reference frame. By default it
+  is (0.2 -0.1 0.0) m.
+
+--items <i>(n0 n1 ...)</i>
+- The numbers of items to be tested. By default (25 50 100 200).
+
+--noise <i>(s0 s1 ...)</i>
+- The standard deviations of the pixel noise to be tested. By
+  default (0.0 1.0 2.0 5.0) pixels.
+
+--outliers \e ratio
+- Fraction of items whose pixel is replaced by a random point
+  within the image. By default it is 0.
+
+--trials \e n
+- Number of random trials for each combination. By default it
+  is 20.
+
+--tol \e tol
+- Tolerance of the optimizer.
+
+--max_iter \e n
+- Maximum number of iterations of the optimizer.
+
+--multi_start \e switch
+- If "on", the multi-start optimization is employed. By default
+  it is "on", as in \ref karmaToolFinder.
+
+--threads \e n
+- Number of threads sharing the starts in multi-start mode.
+
+--linear_solver \e name
+- The linear solver employed by IPOPT; the solves are serialized
+  unless it is given and differs from MUMPS, as in \ref
+  karmaToolFinder.
+
+--seed \e seed
+- Seed of the random generator. By default it is 0.
+
+\section tested_os_sec Tested OS
+Windows, Linux
+
+\author Ugo Pattacini
+*/
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include <deque>
+
+#include <yarp/os/all.h>
+#include <yarp/sig/all.h>
+#include <yarp/math/Math.h>
+#include <yarp/math/Rand.h>
+
+#include <iCub/ctrl/math.h>
+
+#include "iCub/solver.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::ctrl;
+
+
+/****************************************************************/
+class Scene
+{
+protected:
+    Matrix Prj;
+    Matrix He;
+    Vector center;
+    Vector tip;
+    double width,height;
+    double outliers;
+
+    /****************************************************************/
+    static Matrix lookAt(const Vector &e, const Vector &c)
+    {
+        // camera frame: z forward, x rightward, y downward
+        Vector up(3,0.0); up[2]=1.0;
+        Vector z=c-e; z=z/norm(z);
+        Vector x=cross(z,up); x=x/norm(x);
+        Vector y=cross(z,x);
+
+        Matrix H=eye(4,4);
+        H.setSubcol(x,0,0);
+        H.setSubcol(y,0,1);
+        H.setSubcol(z,0,2);
+        H.setSubcol(e,0,3);
+        return H;
+    }
+
+    /****************************************************************/
+    Matrix getRandomHand() const
+    {
+        // palm facing down as in the exploration of karmaMotor,
+        // randomly rotated and displaced around the center
+        Matrix R0(4,4); R0.zero();
+        R0(0,0)=-1.0;
+        R0(2,1)=-1.0;
+        R0(1,2)=-1.0;
+        R0(3,3)=+1.0;
+
+        Vector r=Rand::vector(Vector(3,-1.0),Vector(3,1.0));
+        r=r/norm(r);
+        r.push_back(Rand::scalar(-M_PI/4.0,M_PI/4.0));
+
+        Matrix Ha=axis2dcm(r)*R0;
+        Vector d(3);
+        d[0]=Rand::scalar(-0.08,0.08);
+        d[1]=Rand::scalar(-0.10,0.10);
+        d[2]=Rand::scalar(-0.08,0.08);
+        Ha.setSubcol(center+d,0,3);
+        return Ha;
+    }
+
+public:
+    /****************************************************************/
+    Scene(const Vector &tip, const double outliers) :
+          tip(tip), outliers(outliers)
+    {
+        // typical intrinsics of the iCub cameras at 320x240
+        width=320.0; height=240.0;
+        Prj.resize(3,4); Prj.zero();
+        Prj(0,0)=257.34; Prj(0,2)=160.0;
+        Prj(1,1)=257.34; Prj(1,2)=120.0;
+        Prj(2,2)=1.0;
+
+        Vector e(3);
+        e[0]=-0.06; e[1]=0.0; e[2]=0.34;
+        center.resize(3);
+        center[0]=-0.35; center[1]=0.1; center[2]=0.05;
+        He=lookAt(e,center);
+    }
+
+    /****************************************************************/
+    bool getItem(const double noise, Vector &p, Matrix &H) const
+    {
+        Vector x=tip; x.push_back(1.0);
+
+        // retain only poses with the tip visible
+        for (int attempt=0; attempt<100; attempt++)
+        {
+            H=Prj*SE3inv(He)*getRandomHand();
+
+            Vector px=H*x;
+            if (px[2]<=0.0)
+                continue;
+
+            p.resize(2);
+            p[0]=px[0]/px[2];
+            p[1]=px[1]/px[2];
+            if ((p[0]<0.0) || (p[0]>=width) || (p[1]<0.0) || (p[1]>=height))
+                continue;
+
+            if (Rand::scalar()<outliers)
+            {
+                p[0]=Rand::scalar(0.0,width);
+                p[1]=Rand::scalar(0.0,height);
+            }
+            else if (noise>0.0)
+            {
+                p[0]+=Randn::scalar(0.0,noise);
+                p[1]+=Randn::scalar(0.0,noise);
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+};
+
+
+/****************************************************************/
+bool getList(ResourceFinder &rf, const string &key, deque<double> &l)
+{
+    if (Bottle *pB=rf.find(key.c_str()).asList())
+    {
+        l.clear();
+        for (int i=0; i<pB->size(); i++)
+            l.push_back(pB->get(i).asDouble());
+
+        return true;
+    }
+
+    return false;
+}
+
+
+/****************************************************************/
+void configureSolver(ResourceFinder &rf, FindToolTip &solver)
+{
+    if (rf.check("tol") || rf.check("max_iter"))
+        solver.setSolverOptions(rf.check("tol",Value(1e-8)).asDouble(),
+                                rf.check("max_iter",Value(300)).asInt());
+    if (rf.check("linear_solver"))
+        solver.setLinearSolver(rf.find("linear_solver").asString().c_str());
+
+    string multi_start=rf.check("multi_start",Value("on")).asString().c_str();
+    int threads=std::max(rf.check("threads",Value(1)).asInt(),1);
+    solver.setMultiStart(multi_start=="on",threads);
+}
+
+
+/****************************************************************/
+int main(int argc, char *argv[])
+{
+    ResourceFinder rf;
+    rf.configure(argc,argv);
+
+    Vector tip(3);
+    tip[0]=0.2; tip[1]=-0.1; tip[2]=0.0;
+    if (Bottle *pB=rf.find("tip").asList())
+    {
+        if (pB->size()>=3)
+        {
+            for (int i=0; i<3; i++)
+                tip[i]=pB->get(i).asDouble();
+        }
+    }
+
+    deque<double> items,noise;
+    if (!getList(rf,"items",items))
+    {
+        items.push_back(25); items.push_back(50);
+        items.push_back(100); items.push_back(200);
+    }
+    if (!getList(rf,"noise",noise))
+    {
+        noise.push_back(0.0); noise.push_back(1.0);
+        noise.push_back(2.0); noise.push_back(5.0);
+    }
+
+    double outliers=rf.check("outliers",Value(0.0)).asDouble();
+    int trials=std::max(rf.check("trials",Value(20)).asInt(),1);
+    string multi_start=rf.check("multi_start",Value("on")).asString().c_str();
+    string linear_solver=rf.check("linear_solver",Value("mumps")).asString().c_str();
+    IpoptLock::setThreadSafe(linear_solver!="mumps");
+    Rand::init(rf.check("seed",Value(0)).asInt());
+
+    Scene scene(tip,outliers);
+
+    printf("tip=(%s) [m]; outliers=%g; trials=%d; multi-start=%s\n",
+           tip.toString(3,3).c_str(),outliers,trials,multi_start.c_str());
+    printf("%8s %8s %10s %8s %8s %10s %10s %10s\n","items","noise","time[ms]",
+           "iter","success","err[mm]","max[mm]","reproj[px]");
+
+    for (size_t i=0; i<items.size(); i++)
+    {
+        for (size_t j=0; j<noise.size(); j++)
+        {
+            double dt=0.0,iter=0.0,err=0.0,errMax=0.0,reproj=0.0;
+            int success=0;
+
+            for (int k=0; k<trials; k++)
+            {
+                // the trials are independent: a fresh solver each
+                // time, not to warm up from the previous solution
+                FindToolTip solver;
+                configureSolver(rf,solver);
+
+                for (int n=0; n<(int)items[i]; n++)
+                {
+                    Vector p; Matrix H;
+                    if (scene.getItem(noise[j],p,H))
+                        solver.addItem(p,H);
+                }
+
+                Vector x;
+                double error=0.0;
+                double t0=Time::now();
+                bool ok=solver.solve(x,error);
+                double t1=Time::now();
+
+                // failures are only counted, being excluded
+                // from the statistics
+                if (!ok || (x.length()<3))
+                    continue;
+
+                success++;
+                dt+=t1-t0;
+                iter+=solver.getNumIterations();
+                reproj+=error;
+
+                double e=norm(x.subVector(0,2)-tip);
+                err+=e;
+                errMax=std::max(errMax,e);
+            }
+
+            if (success>0)
+                printf("%8d %8.2f %10.3f %8.1f %7.0f%% %10.3f %10.3f %10.3f\n",
+                       (int)items[i],noise[j],1e3*dt/success,iter/success,
+                       100.0*success/trials,1e3*err/success,1e3*errMax,
+                       reproj/success);
+            else
+                printf("%8d %8.2f %10s %8s %7.0f%% %10s %10s %10s\n",
+                       (int)items[i],noise[j],"-","-",0.0,"-","-","-");
+        }
+    }
+
+    return 0;
+}
+
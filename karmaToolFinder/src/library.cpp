@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <stdio.h>
+
+#include <yarp/os/all.h>
+
+#include "iCub/library.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+
+
+/**********************************************************/
+ToolLibrary::ToolLibrary() : path(".")
+{
+}
+/**********************************************************/
+bool ToolLibrary::setPath(const string &path)
+{
+    this->path=path.empty()?string("."):path;
+
+    // the library is a flat directory: create it if missing
+    if (yarp::os::stat(this->path.c_str())!=0)
+        yarp::os::mkdir(this->path.c_str());
+
+    return (yarp::os::stat(this->path.c_str())==0);
+}
+/**********************************************************/
+bool ToolLibrary::isValidName(const string &name)
+{
+    // the name is used as file stem, hence no path components
+    if (name.empty() || (name[0]=='.'))
+        return false;
+
+    return (name.find_first_of("/\\:")==string::npos);
+}
+/**********************************************************/
+string ToolLibrary::getEntryFile(const string &name) const
+{
+    return path+"/"+name+".ini";
+}
+/**********************************************************/
+string ToolLibrary::getItemsFile(const string &name) const
+{
+    return path+"/"+name+".log";
+}
+/**********************************************************/
+bool ToolLibrary::save(const ToolEntry &entry, const deque<ItemRecord> &items)
+{
+    if (!isValidName(entry.name) || (entry.tip.length()<3))
+        return false;
+
+    // items first, so that an entry always refers to a complete set
+    ItemLogWriter writer;
+    if (!writer.open(getItemsFile(entry.name)))
+        return false;
+
+    for (size_t i=0; i<items.size(); i++)
+    {
+        if (!writer.write(items[i]))
+            return false;
+    }
+    writer.close();
+
+    FILE *fout=fopen(getEntryFile(entry.name).c_str(),"w");
+    if (fout==NULL)
+        return false;
+
+    fprintf(fout,"name     %s\n",entry.name.c_str());
+    fprintf(fout,"tip      (%.10g %.10g %.10g)\n",entry.tip[0],entry.tip[1],entry.tip[2]);
+    fprintf(fout,"error    %.10g\n",entry.error);
+    if ((entry.cov.rows()==3) && (entry.cov.cols()==3))
+    {
+        fprintf(fout,"cov      (");
+        for (int r=0; r<3; r++)
+            for (int c=0; c<3; c++)
+                fprintf(fout,"%.10g%s",entry.cov(r,c),((r==2)&&(c==2))?")\n":" ");
+    }
+    if (entry.frame.length()>=7)
+    {
+        fprintf(fout,"frame    (");
+        for (int i=0; i<7; i++)
+            fprintf(fout,"%.10g%s",entry.frame[i],(i==6)?")\n":" ");
+    }
+    fprintf(fout,"items    %d\n",entry.numItems);
+    fprintf(fout,"time     %.3f\n",Time::now());
+
+    fclose(fout);
+    return true;
+}
+/**********************************************************/
+bool ToolLibrary::recall(const string &name, ToolEntry &entry) const
+{
+    if (!isValidName(name))
+        return false;
+
+    Property prop;
+    if (!prop.fromConfigFile(getEntryFile(name).c_str()))
+        return false;
+
+    Bottle *pTip=prop.find("tip").asList();
+    if ((pTip==NULL) || (pTip->size()<3))
+        return false;
+
+    entry.name=name;
+    entry.tip.resize(3);
+    for (int i=0; i<3; i++)
+        entry.tip[i]=pTip->get(i).asDouble();
+
+    entry.cov.resize(0,0);
+    if (Bottle *pCov=prop.find("cov").asList())
+    {
+        if (pCov->size()>=9)
+        {
+            entry.cov.resize(3,3);
+            for (int r=0; r<3; r++)
+                for (int c=0; c<3; c++)
+                    entry.cov(r,c)=pCov->get(3*r+c).asDouble();
+        }
+    }
+
+    entry.frame.resize(0);
+    if (Bottle *pFrame=prop.find("frame").asList())
+    {
+        if (pFrame->size()>=7)
+        {
+            entry.frame.resize(7);
+            for (int i=0; i<7; i++)
+                entry.frame[i]=pFrame->get(i).asDouble();
+        }
+    }
+
+    entry.error=prop.check("error",Value(-1.0)).asDouble();
+    entry.numItems=prop.check("items",Value(0)).asInt();
+
+    return true;
+}
+
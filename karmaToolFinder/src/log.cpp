@@ -0,0 +1,173 @@
+/* 
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <string.h>
+#include <algorithm>
+
+#include "iCub/log.h"
+
+using namespace std;
+using namespace yarp::sig;
+
+
+/**********************************************************/
+ItemLogWriter::ItemLogWriter() : fout(NULL)
+{
+}
+/**********************************************************/
+bool ItemLogWriter::open(const string &fileName)
+{
+    close();
+    if ((fout=fopen(fileName.c_str(),"wb"))==NULL)
+        return false;
+
+    ItemLogHeader header;
+    memset(&header,0,sizeof(header));
+    strncpy(header.magic,ITEMLOG_MAGIC,sizeof(header.magic)-1);
+    header.version=ITEMLOG_VERSION;
+    header.recordSize=sizeof(ItemRecord);
+
+    if (fwrite(&header,sizeof(header),1,fout)!=1)
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+/**********************************************************/
+bool ItemLogWriter::write(const ItemRecord &record)
+{
+    if (fout!=NULL)
+        return (fwrite(&record,sizeof(record),1,fout)==1);
+    else
+        return false;
+}
+/**********************************************************/
+void ItemLogWriter::close()
+{
+    if (fout!=NULL)
+    {
+        fclose(fout);
+        fout=NULL;
+    }
+}
+/**********************************************************/
+ItemLogWriter::~ItemLogWriter()
+{
+    close();
+}
+/**********************************************************/
+static void copyFeatures(const Vector &p, ItemRecord &record)
+{
+    int n=std::min((int)p.length()/2,ITEMLOG_MAX_FEAT);
+    record.nFeat=n;
+    for (int i=0; i<2*ITEMLOG_MAX_FEAT; i++)
+        record.p[i]=(i<2*n)?p[i]:0.0;
+}
+/**********************************************************/
+static void copyMatrix(const Matrix &M, double *dst, const int rows, const int cols)
+{
+    for (int r=0; r<rows; r++)
+        for (int c=0; c<cols; c++)
+            dst[r*cols+c]=M(r,c);
+}
+/**********************************************************/
+void fillItemRecord(ItemRecord &record, const double t, const int cam,
+                    const Vector &p, const Matrix &H, const Matrix &Prj,
+                    const Matrix &Ha, const Matrix &He)
+{
+    record.t=t;
+    record.cam=cam;
+    copyFeatures(p,record);
+    copyMatrix(H,record.H,3,4);
+    copyMatrix(Prj,record.Prj,3,4);
+    copyMatrix(Ha,record.Ha,4,4);
+    copyMatrix(He,record.He,4,4);
+}
+/**********************************************************/
+void fillItemRecord(ItemRecord &record, const double t, const Vector &p,
+                    const Matrix &H)
+{
+    // items coming without the frames they were computed from
+    memset(&record,0,sizeof(record));
+    record.t=t;
+    record.cam=-1.0;
+    copyFeatures(p,record);
+    copyMatrix(H,record.H,3,4);
+}
+/**********************************************************/
+void getItemRecord(const ItemRecord &record, Vector &p, Matrix &H)
+{
+    int n=std::max(1,std::min((int)record.nFeat,ITEMLOG_MAX_FEAT));
+    p.resize(2*n);
+    for (int i=0; i<2*n; i++)
+        p[i]=record.p[i];
+
+    H.resize(3,4);
+    for (int r=0; r<3; r++)
+        for (int c=0; c<4; c++)
+            H(r,c)=record.H[r*4+c];
+}
+/**********************************************************/
+void itemRecordToVector(const ItemRecord &record, Vector &v)
+{
+    // same layout as the former log: p, H, Prj, Ha, He and then t,
+    // followed by the pixels of the other features, if any
+    int n=std::max(1,std::min((int)record.nFeat,ITEMLOG_MAX_FEAT));
+    v.resize(2+12+12+16+16+1+2*(n-1));
+
+    size_t i=0;
+    v[i++]=record.p[0];
+    v[i++]=record.p[1];
+    for (int j=0; j<12; j++)
+        v[i++]=record.H[j];
+    for (int j=0; j<12; j++)
+        v[i++]=record.Prj[j];
+    for (int j=0; j<16; j++)
+        v[i++]=record.Ha[j];
+    for (int j=0; j<16; j++)
+        v[i++]=record.He[j];
+    v[i++]=record.t;
+    for (int j=2; j<2*n; j++)
+        v[i++]=record.p[j];
+}
+/**********************************************************/
+bool loadItemLog(const string &fileName, deque<ItemRecord> &records)
+{
+    FILE *fin=fopen(fileName.c_str(),"rb");
+    if (fin==NULL)
+        return false;
+
+    ItemLogHeader header;
+    if ((fread(&header,sizeof(header),1,fin)!=1) ||
+        (strncmp(header.magic,ITEMLOG_MAGIC,strlen(ITEMLOG_MAGIC))!=0) ||
+        (header.version!=ITEMLOG_VERSION) ||
+        (header.recordSize!=sizeof(ItemRecord)))
+    {
+        fclose(fin);
+        return false;
+    }
+
+    ItemRecord record;
+    while (fread(&record,sizeof(record),1,fin)==1)
+        records.push_back(record);
+
+    fclose(fin);
+    return true;
+}
+
@@ -0,0 +1,1402 @@
+/* 
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/** 
+\defgroup karmaToolFinder Tool Solver Part of the KARMA Experiment
+ 
+This module finds the tool dimension employing nonlinear 
+optimization. 
+
+\section intro_sec Description 
+Through an active exploration of the tool held in the robot hand 
+a set of relevant data is collected, including hand position in 
+3D space, eye's frame and pixels of the tool tip as acquired by 
+vision algorithms. A nonlinear optimization is then exploited to 
+find out the best estimate of the tool dimensions with respect 
+to the hand reference frame. 
+ 
+\section lib_sec Libraries 
+- YARP libraries. 
+- icubmod library. 
+- IPOPT library. 
+- OpenCV library.  
+
+\section parameters_sec Parameters 
+--robot \e robot
+- Select the robot to connect to.
+
+--name \e name
+- Select the stem-name of the module used to open up ports. 
+  By default \e name is <i>karmaToolFinder</i>. 
+ 
+--arm \e type
+- Select the default arm ("left" or "right") used for the data 
+  acquisition.
+ 
+--eye \e type
+- Select the default eye ("left", "right" or "both") used for
+  the data acquisition. With "both" the stereo mode is enabled.
+  Only the intrinsic parameters of the selected cameras are
+  required.
+ 
+--warm_start \e switch
+- If "on", each optimization is started from the previous
+  solution instead of the center of the bounding box. By default
+  it is "off".
+ 
+--multi_start \e switch
+- If "on", the optimization is also started from the linear
+  estimate, the corners of the bounding box and the previous
+  solution; the best result by reprojection error is retained,
+  discarding solutions lying behind the camera. By default it is
+  "on".
+ 
+--solver_threads \e n
+- Number of threads the starts are distributed over in
+  multi-start mode, each one with its own optimizer. By default
+  it is 1.
+ 
+--linear_solver \e name
+- The linear solver employed by IPOPT (e.g. "ma27"). MUMPS, which
+  is the default, is not thread-safe, hence the solves of the
+  solver threads are serialized unless a different linear
+  solver is given, which has to be thread-safe.
+ 
+--history_period \e period
+- Period in milliseconds of the thread sampling the arm and eyes
+  poses, so that each detection gets paired with the poses
+  interpolated at the time stamp of its envelope. A value of 0
+  disables the history and the current poses are used instead.
+  By default it is 5 ms.
+ 
+--history_len \e len
+- Number of pose samples stored in the history. By default it
+  is 512.
+ 
+--log_file \e file
+- Store each acquired item as a fixed-size binary record in the
+  given file; the log can be replayed offline through the
+  \ref karmaToolFinderReplay tool.
+ 
+--sync_tol \e tol
+- Maximum time difference in seconds between a left and a right
+  detection to be considered synchronized in stereo mode. By
+  default it is 0.02 s.
+ 
+--num_features \e n
+- Number of tool features tracked in each detection (up to 3):
+  the tip first, then a point along the tool axis and a side
+  marker. With two features the tip and the tool axis are
+  estimated, whereas the side marker is required to resolve the
+  roll about the axis and thus the full tool frame. By default
+  it is 1.
+ 
+--tool_library \e dir
+- Directory where the solved tools are stored, one
+  <i>tool.ini</i> file with the tip, its uncertainty and the
+  tool frame, if estimated, along with one <i>tool.log</i> binary
+  file with the items used for the estimate. By default it is <i>toolLibrary</i> within the
+  home context path.
+ 
+--verify_thres \e thres
+- Maximum mean reprojection error in pixels for a stored tool
+  to pass the verification. By default it is 5 pixels.
+ 
+\section portsa_sec Ports Accessed
+Assume that iCubInterface (with ICartesianControl interface
+implemented) is running. 
+ 
+\section portsc_sec Ports Created 
+- \e /karmaToolFinder/rpc receives the information to manage the 
+  data acquisition and optimization phase:
+  -# <b>Enable</b>: <i>[enable]</i>. \n
+  Start the data acquisition phase.
+  -# <b>Disable</b>: <i>[disable]</i>. \n
+  Terminate the data acquisition phase.
+  -# <b>Num</b>: <i>[num]</i>. \n
+  Retrieve the current number of input-output pairs used for the
+  optimization. The reply is <i>[ack] num</i>.
+  -# <b>Add</b>: <i>[add] data [n]</i>. \n
+  Add a block of items at once: <i>data</i> is either a blob of
+  doubles in the native byte order or a list of doubles, packed
+  as consecutive records <i>u v h00 h01 ... h23</i> with the
+  pixel of the tool tip followed by the 3x4 projection matrix
+  Prj*inv(He)*Ha stored row-major. If the records carry <i>n</i>
+  features, the pixels of the other features follow the tip as
+  <i>u v u1 v1 ... h00 ... h23</i>. The reply is <i>[ack] n</i>
+  with the number of items added.
+  -# <b>Clear</b>: <i>[clear]</i>. \n
+  Clear the current content of input-output pairs database.
+  -# <b>Select</b>: <i>[select] arm eye</i>. \n
+  Select the robot sources in terms of arm and eye used during
+  the data acquisition. If <i>eye</i> is "both", the stereo mode
+  is enabled. The reply is <i>[nack]</i> if the intrinsic
+  parameters of the requested eye are not available, in which
+  case the eye is not changed.
+  -# <b>Find</b>: <i>[find] [fast]</i>. \n
+  Execute the optimization over the current database of
+  input-output pairs. The reply is <i>[ack] x y z (error e)
+  (cov c00 ... c22) (cond k) (frame x y z ax ay az theta)</i>
+  including the tool dimensions given wrt hand reference frame,
+  the mean reprojection error in pixels, the 3x3 covariance of
+  the estimate (row-major) taken from the Gauss-Newton normal
+  matrix at the optimum and its condition number. With multiple
+  features, the tool transform wrt the hand is also estimated by
+  fitting the reprojections of all the features at once: the
+  x-axis points from the axis feature toward the tip and the
+  z-axis toward the side marker. With three features the reply
+  includes <i>(frame x y z ax ay az theta)</i> with the position
+  and the axis-angle orientation of the frame, whereas with two
+  features it includes <i>(axis x y z ux uy uz)</i> with the tip
+  and the direction of the x-axis, since the roll is not
+  observable. The mean reprojection error of the features is
+  given as <i>(frame_error e)</i>.
+  With \e fast, the optimization is started only once regardless
+  of --multi_start and the tool frame is not computed, which suits
+  the intermediate estimates taken during an exploration.
+  -# <b>Show</b>: <i>[show] x y z</i>. \n
+  Enable the visualization of a tool with the dimensions
+  specified by the user. The reply is <i>[ack]</i> or
+  <i>[nack]</i>.
+  -# <b>Tip</b>: <i>[tip]</i>. \n
+  Retrieve the tool tip as projected in the image plane. The
+  reply is <i>[ack] u v</i> or <i>[nack]</i>.
+  -# <b>Log</b>: <i>[log] file</i>. \n
+  Start storing the acquired items as binary records in the
+  given file. Without <i>file</i> the current log is closed. The
+  reply is <i>[ack]</i> or <i>[nack]</i>.
+  -# <b>Save</b>: <i>[save] tool</i>. \n
+  Store the current solution, including the tool frame found with
+  three features, along with the items acquired so far in the
+  tool library under the name <i>tool</i>. The reply is
+  <i>[ack]</i> or <i>[nack]</i>.
+  -# <b>Recall</b>: <i>[recall] tool</i>. \n
+  Retrieve the tool from the library without any acquisition;
+  the recalled tip and frame become the current solution. The
+  reply is <i>[ack] x y z (error e) (cov c00 ... c22) (frame x y
+  z ax ay az theta) (items n)</i>, where the frame is given only
+  if stored, or <i>[nack]</i> if the tool is unknown.
+  -# <b>Verify</b>: <i>[verify] tool [thres]</i>. \n
+  Check the stored tip against the items currently acquired
+  (e.g. a handful of samples from one pose): the tool is
+  verified if the mean reprojection error is lower than
+  <i>thres</i> pixels. The reply is <i>[ack] x y z (error
+  e)</i>, or <i>[nack] (error e)</i> if the check fails.
+
+- \e /karmaToolFinder/in receives the position of the tool tip
+   in the image plane as <i>u v</i>, followed by the other
+   tracked features, if any, as <i>u1 v1 u2 v2</i>.
+ 
+ - \e /karmaToolFinder/in/left and \e /karmaToolFinder/in/right
+   receive the position of the tool tip in the left and right
+   image planes in stereo mode. Synchronized detections are
+   coupled with the same arm pose and added as two items.
+ 
+ - \e /karmaToolFinder/img:i receives images from the camera.
+ 
+ - \e /karmaToolFinder/img:o streams out images with
+   superimposed information on the tool.
+ 
+ - \e /karmaToolFinder/status:o streams out <i>[num] n</i>
+   with the current number of input-output pairs whenever it
+   changes, sparing the clients the polling of the <i>num</i>
+   command.
+
+ - \e /karmaToolFinder/log:o streams out a complete set of data
+   used during the acquisition: p, H, Prj, Ha, He and the time
+   stamp of the detection, followed by the pixels of the other
+   tracked features, if any.
+
+\section tested_os_sec Tested OS
+Windows, Linux
+
+\author Ugo Pattacini
+*/ 
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <deque>
+
+#include <yarp/os/all.h>
+#include <yarp/sig/all.h>
+#include <yarp/dev/all.h>
+#include <yarp/math/Math.h>
+
+#include <iCub/ctrl/math.h>
+
+#include <cv.h>
+
+#include "iCub/solver.h"
+#include "iCub/log.h"
+#include "iCub/library.h"
+
+YARP_DECLARE_DEVICES(icubmod)
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::ctrl;
+
+
+
+/****************************************************************/
+struct PoseSample
+{
+    double t;
+    int    armTag;
+    double xa[3],oa[4];
+    double xe[2][3],oe[2][4];
+};
+
+
+
+/****************************************************************/
+class PoseHistory : public RateThread
+{
+protected:
+    ICartesianControl *iarm;
+    int                armTag;
+    IGazeControl      *igaze;
+
+    // the lock is held only to copy the samples in and out,
+    // the controllers being queried outside of it
+    Semaphore          mutex;
+    PoseSample        *samples;
+    size_t             len;
+    unsigned long      head;
+
+    /****************************************************************/
+    static void toFrame(const double *x, const double *o, Matrix &H)
+    {
+        Vector ax(4);
+        ax[0]=o[0]; ax[1]=o[1]; ax[2]=o[2]; ax[3]=o[3];
+        H=axis2dcm(ax);
+        H(0,3)=x[0]; H(1,3)=x[1]; H(2,3)=x[2];
+    }
+
+    /****************************************************************/
+    static void interpFrame(const Matrix &H0, const Matrix &H1,
+                            const double alpha, Matrix &H)
+    {
+        // linear interpolation for the translational part,
+        // rotation along the geodesic for the angular part
+        Matrix R0=H0.submatrix(0,2,0,2);
+        Matrix R1=H1.submatrix(0,2,0,2);
+        Vector ax=dcm2axis(R0.transposed()*R1);
+        ax[3]*=alpha;
+
+        H=eye(4,4);
+        H.setSubmatrix(R0*axis2dcm(ax).submatrix(0,2,0,2),0,0);
+        for (int i=0; i<3; i++)
+            H(i,3)=(1.0-alpha)*H0(i,3)+alpha*H1(i,3);
+    }
+
+    /****************************************************************/
+    static void copyPose(const Vector &x, const Vector &o, double *_x, double *_o)
+    {
+        for (size_t i=0; i<3; i++)
+            _x[i]=x[i];
+        for (size_t i=0; i<4; i++)
+            _o[i]=o[i];
+    }
+
+    /****************************************************************/
+    void run()
+    {
+        mutex.wait();
+        ICartesianControl *arm=iarm;
+        int tag=armTag;
+        mutex.post();
+
+        if (arm==NULL)
+            return;
+
+        Vector xa,oa,xl,ol,xr,orr;
+        Stamp stamp;
+        arm->getPose(xa,oa,&stamp);
+        igaze->getLeftEyePose(xl,ol);
+        igaze->getRightEyePose(xr,orr);
+
+        PoseSample sample;
+        sample.t=stamp.isValid()?stamp.getTime():Time::now();
+        sample.armTag=tag;
+        copyPose(xa,oa,sample.xa,sample.oa);
+        copyPose(xl,ol,sample.xe[0],sample.oe[0]);
+        copyPose(xr,orr,sample.xe[1],sample.oe[1]);
+
+        mutex.wait();
+        samples[head%len]=sample;
+        head++;
+        mutex.post();
+    }
+
+public:
+    /****************************************************************/
+    PoseHistory(IGazeControl *igaze, const int period, const size_t len) :
+                RateThread(period), iarm(NULL), armTag(0), igaze(igaze),
+                len(len), head(0)
+    {
+        samples=new PoseSample[len];
+    }
+
+    /****************************************************************/
+    void setArm(ICartesianControl *iarm)
+    {
+        mutex.wait();
+        this->iarm=iarm;
+        armTag++;
+        mutex.post();
+    }
+
+    /****************************************************************/
+    bool getFrames(const double t, Matrix &Ha, Matrix &HeL, Matrix &HeR)
+    {
+        // scan backward for the pair of samples enclosing t
+        PoseSample s0,s1;
+        bool found0=false,found1=false;
+
+        mutex.wait();
+        unsigned long oldest=(head>len)?head-len:0;
+        for (unsigned long k=head; k>oldest; k--)
+        {
+            const PoseSample &s=samples[(k-1)%len];
+            if (s.armTag!=armTag)
+                continue;
+
+            if (s.t<=t)
+            {
+                s0=s;
+                found0=true;
+                break;
+            }
+
+            s1=s;
+            found1=true;
+        }
+        mutex.post();
+
+        if (!found0 && !found1)
+            return false;
+
+        // outside the history the closest sample is used
+        if (!found0)
+            s0=s1;
+        else if (!found1)
+            s1=s0;
+
+        double dt=s1.t-s0.t;
+        double alpha=(dt>0.0)?(t-s0.t)/dt:0.0;
+
+        Matrix H0,H1;
+        toFrame(s0.xa,s0.oa,H0); toFrame(s1.xa,s1.oa,H1);
+        interpFrame(H0,H1,alpha,Ha);
+
+        toFrame(s0.xe[0],s0.oe[0],H0); toFrame(s1.xe[0],s1.oe[0],H1);
+        interpFrame(H0,H1,alpha,HeL);
+
+        toFrame(s0.xe[1],s0.oe[1],H0); toFrame(s1.xe[1],s1.oe[1],H1);
+        interpFrame(H0,H1,alpha,HeR);
+
+        return true;
+    }
+
+    /****************************************************************/
+    virtual ~PoseHistory()
+    {
+        delete[] samples;
+    }
+};
+
+
+
+class FinderModule;
+
+/************************************************************************/
+class DataPort: public BufferedPort<Bottle>
+{
+protected:
+    FinderModule *module;
+    string        source;
+
+    void onRead(Bottle &data);
+
+public:
+    /************************************************************************/
+    DataPort() : module(NULL)
+    {
+        useCallback();
+    }
+
+    /************************************************************************/
+    void setSource(FinderModule *module, const string &source)
+    {
+        this->module=module;
+        this->source=source;
+    }
+};
+
+
+
+/************************************************************************/
+class FinderModule: public RFModule
+{
+protected:
+    PolyDriver         drvArmL;
+    PolyDriver         drvArmR;
+    PolyDriver         drvGaze;
+    ICartesianControl *iarm;
+    IGazeControl      *igaze;
+    RpcServer          rpcPort;
+    Matrix             PrjL,PrjR;
+    Semaphore          mutex;
+    FindToolTip        solver;
+    FindToolFrame     *frameSolver;
+    int                numFeatures;
+    Vector             solution;
+    Vector             frame;
+    Bottle             tip;
+    string             arm;
+    string             eye;
+    bool               enabled;
+
+    PoseHistory       *history;
+
+    Semaphore          mutexStereo;
+    Vector             pxStereo[2];
+    double             tStereo[2];
+    bool               freshStereo[2];
+    double             syncTol;
+
+    BufferedPort<ImageOf<PixelBgr> > imgInPort;
+    Port                             imgOutPort;
+    DataPort                         dataInPort;
+    DataPort                         dataInPortL;
+    DataPort                         dataInPortR;
+    BufferedPort<Vector>             logPort;
+    BufferedPort<Bottle>             statusPort;
+    Semaphore                        mutexStatus;
+    ItemLogWriter                    logWriter;
+    deque<ItemRecord>                items;
+    ToolLibrary                      library;
+    double                           verifyThres;
+
+    friend class DataPort;
+
+    /************************************************************************/
+    void getFrames(const double t, Matrix &Ha, Matrix &HeL, Matrix &HeR)
+    {
+        // pair the detection with the poses at the time of the image;
+        // fall back to the current poses if no history is available
+        if ((history!=NULL) && history->getFrames(t,Ha,HeL,HeR))
+            return;
+
+        Vector xa,oa;
+        iarm->getPose(xa,oa);
+
+        Ha=axis2dcm(oa);
+        xa.push_back(1.0);
+        Ha.setCol(3,xa);
+
+        Vector xe,oe;
+        igaze->getLeftEyePose(xe,oe);
+        HeL=axis2dcm(oe);
+        xe.push_back(1.0);
+        HeL.setCol(3,xe);
+
+        igaze->getRightEyePose(xe,oe);
+        HeR=axis2dcm(oe);
+        xe.push_back(1.0);
+        HeR.setCol(3,xe);
+    }
+
+    /************************************************************************/
+    void addObservation(const int camSel, const Vector &p, const Matrix &Ha,
+                        const Matrix &He, const double t)
+    {
+        const Matrix &Prj=(camSel==0)?PrjL:PrjR;
+        Matrix H=Prj*SE3inv(He)*Ha;
+
+        // records are retained for storing the tool in the library
+        ItemRecord record;
+        fillItemRecord(record,t,camSel,p,H,Prj,Ha,He);
+        items.push_back(record);
+        logWriter.write(record);
+
+        if (logPort.getOutputCount()>0)
+        {
+            itemRecordToVector(record,logPort.prepare());
+            logPort.write();
+        }
+
+        solver.addItem(p,H);
+        if (frameSolver!=NULL)
+            frameSolver->addItem(p,H);
+    }
+
+    /************************************************************************/
+    int addItems(const double *data, const size_t len, const int nFeat)
+    {
+        // bulk ingest: the whole block is added under one lock
+        const size_t recordLen=2*nFeat+12;
+        double t=Time::now();
+        Vector p(2*nFeat);
+        Matrix H(3,4);
+        int cnt=0;
+
+        mutex.wait();
+        for (size_t i=0; i+recordLen<=len; i+=recordLen)
+        {
+            const double *d=data+i;
+            for (size_t j=0; j<p.length(); j++)
+                p[j]=d[j];
+            for (int r=0; r<3; r++)
+                for (int c=0; c<4; c++)
+                    H(r,c)=d[p.length()+4*r+c];
+
+            ItemRecord record;
+            fillItemRecord(record,t,p,H);
+            items.push_back(record);
+            logWriter.write(record);
+
+            if (solver.addItem(p,H))
+                cnt++;
+            if (frameSolver!=NULL)
+                frameSolver->addItem(p,H);
+        }
+        mutex.post();
+
+        return cnt;
+    }
+
+    /************************************************************************/
+    void publishStatus()
+    {
+        // the clients are notified of the items as they come,
+        // without polling the rpc port
+        if (statusPort.getOutputCount()>0)
+        {
+            mutex.wait();
+            int n=(int)solver.getNumItems();
+            mutex.post();
+
+            mutexStatus.wait();
+            Bottle &status=statusPort.prepare();
+            status.clear();
+            status.addVocab(Vocab::encode("num"));
+            status.addInt(n);
+            statusPort.writeStrict();
+            mutexStatus.post();
+        }
+    }
+
+    /************************************************************************/
+    void onData(const string &source, const Bottle &data, const double t)
+    {
+        if ((data.size()<2) || !enabled)
+            return;
+
+        // tip first, then the other features
+        int n=std::min(data.size()/2,numFeatures);
+        Vector p(2*n);
+        for (size_t i=0; i<p.length(); i++)
+            p[i]=data.get(i).asDouble();
+
+        // monocular input: data refer to the selected eye
+        // (the left one when in stereo mode)
+        if (source=="mono")
+        {
+            Matrix Ha,HeL,HeR;
+            getFrames(t,Ha,HeL,HeR);
+
+            mutex.wait();
+            if (eye=="right")
+                addObservation(1,p,Ha,HeR,t);
+            else
+                addObservation(0,p,Ha,HeL,t);
+            mutex.post();
+
+            publishStatus();
+            return;
+        }
+
+        if (eye!="both")
+            return;
+
+        // stereo input: wait for the detection from the other
+        // camera and add the two items as a pair
+        int camSel=(source=="left")?0:1;
+        int other=1-camSel;
+
+        mutexStereo.wait();
+        pxStereo[camSel]=p;
+        tStereo[camSel]=t;
+        freshStereo[camSel]=true;
+
+        bool sync=freshStereo[other] && (fabs(t-tStereo[other])<syncTol);
+        Vector pL=pxStereo[0];
+        Vector pR=pxStereo[1];
+        double tL=tStereo[0];
+        double tR=tStereo[1];
+        if (sync)
+            freshStereo[0]=freshStereo[1]=false;
+        mutexStereo.post();
+
+        if (sync)
+        {
+            Matrix Ha,HeL,HeR;
+            getFrames(tL,Ha,HeL,HeR);
+
+            mutex.wait();
+            addObservation(0,pL,Ha,HeL,tL);
+            addObservation(1,pR,Ha,HeR,tR);
+            mutex.post();
+
+            publishStatus();
+        }
+    }
+
+    /************************************************************************/
+    CvPoint project(const Matrix &Hprj, const Vector &x)
+    {
+        Vector px=Hprj*x;
+        return cvPoint((int)(px[0]/px[2]),(int)(px[1]/px[2]));
+    }
+
+    /************************************************************************/
+    bool getIntrinsics(const Bottle &info, const string &eye, Matrix &Prj)
+    {
+        if (Bottle *pB=info.find(("camera_intrinsics_"+eye).c_str()).asList())
+        {
+            int cnt=0;
+            Prj.resize(3,4);
+            for (int r=0; r<Prj.rows(); r++)
+                for (int c=0; c<Prj.cols(); c++)
+                    Prj(r,c)=pB->get(cnt++).asDouble();
+
+            return true;
+        }
+        else
+            return false;
+    }
+
+    /************************************************************************/
+    bool hasIntrinsics(const string &eye) const
+    {
+        bool left=(PrjL.rows()>0);
+        bool right=(PrjR.rows()>0);
+        if (eye=="both")
+            return (left && right);
+        else
+            return ((eye=="right")?right:left);
+    }
+
+public:
+    /************************************************************************/
+    bool configure(ResourceFinder &rf)
+    {
+        string robot=rf.check("robot",Value("icub")).asString().c_str();
+        string name=rf.check("name",Value("karmaToolFinder")).asString().c_str();
+        arm=rf.check("arm",Value("right")).asString().c_str();
+        eye=rf.check("eye",Value("left")).asString().c_str();
+        string warm_start=rf.check("warm_start",Value("off")).asString().c_str();
+        string multi_start=rf.check("multi_start",Value("on")).asString().c_str();
+        int solverThreads=std::max(rf.check("solver_threads",Value(1)).asInt(),1);
+        string linear_solver=rf.check("linear_solver",Value("mumps")).asString().c_str();
+        IpoptLock::setThreadSafe(linear_solver!="mumps");
+        history=NULL;
+        frameSolver=NULL;
+
+        if ((arm!="left") && (arm!="right"))
+        {
+            printf("Invalid arm requested!\n");
+            return false;
+        }
+
+        if ((eye!="left") && (eye!="right") && (eye!="both"))
+        {
+            printf("Invalid eye requested!\n");
+            return false;
+        }
+
+        Property optionArmL("(device cartesiancontrollerclient)");
+        optionArmL.put("remote",("/"+robot+"/cartesianController/left_arm").c_str());
+        optionArmL.put("local",("/"+name+"/left_arm").c_str());
+        if (!drvArmL.open(optionArmL))
+        {
+            printf("Cartesian left_arm controller not available!\n");
+            terminate();
+            return false;
+        }
+
+        Property optionArmR("(device cartesiancontrollerclient)");
+        optionArmR.put("remote",("/"+robot+"/cartesianController/right_arm").c_str());
+        optionArmR.put("local",("/"+name+"/right_arm").c_str());
+        if (!drvArmR.open(optionArmR))
+        {
+            printf("Cartesian right_arm controller not available!\n");
+            terminate();
+            return false;
+        }
+
+        if (arm=="left")
+            drvArmL.view(iarm);
+        else
+            drvArmR.view(iarm);
+
+        Property optionGaze("(device gazecontrollerclient)");
+        optionGaze.put("remote","/iKinGazeCtrl");
+        optionGaze.put("local",("/"+name+"/gaze").c_str());
+        if (drvGaze.open(optionGaze))
+            drvGaze.view(igaze);
+        else
+        {
+            printf("Gaze controller not available!\n");
+            terminate();
+            return false;
+        }
+
+        // in mono mode only the intrinsics of the selected eye
+        // are required
+        Bottle info;
+        igaze->getInfo(info);
+        getIntrinsics(info,"left",PrjL);
+        getIntrinsics(info,"right",PrjR);
+        if (!hasIntrinsics(eye))
+        {
+            printf("Camera intrinsic parameters not available!\n");
+            terminate();
+            return false;
+        }
+
+        int historyPeriod=rf.check("history_period",Value(5)).asInt();
+        int historyLen=rf.check("history_len",Value(512)).asInt();
+        if (historyPeriod>0)
+        {
+            history=new PoseHistory(igaze,historyPeriod,std::max(historyLen,2));
+            history->setArm(iarm);
+            history->start();
+        }
+
+        syncTol=rf.check("sync_tol",Value(0.02)).asDouble();
+        freshStereo[0]=freshStereo[1]=false;
+        tStereo[0]=tStereo[1]=0.0;
+
+        enabled=false;
+        dataInPort.setSource(this,"mono");
+        dataInPortL.setSource(this,"left");
+        dataInPortR.setSource(this,"right");
+
+        imgInPort.open(("/"+name+"/img:i").c_str());
+        imgOutPort.open(("/"+name+"/img:o").c_str());
+        dataInPort.open(("/"+name+"/in").c_str());
+        dataInPortL.open(("/"+name+"/in/left").c_str());
+        dataInPortR.open(("/"+name+"/in/right").c_str());
+        logPort.open(("/"+name+"/log:o").c_str());
+        statusPort.open(("/"+name+"/status:o").c_str());
+        rpcPort.open(("/"+name+"/rpc").c_str());
+        attach(rpcPort);
+
+        if (rf.check("log_file"))
+        {
+            string logFile=rf.find("log_file").asString().c_str();
+            if (!logWriter.open(logFile))
+                printf("Unable to open log file %s!\n",logFile.c_str());
+        }
+
+        string libraryPath=rf.getHomeContextPath().c_str();
+        libraryPath=libraryPath.empty()?string("toolLibrary"):libraryPath+"/toolLibrary";
+        libraryPath=rf.check("tool_library",Value(libraryPath.c_str())).asString().c_str();
+        if (!library.setPath(libraryPath))
+            printf("Unable to access tool library %s!\n",libraryPath.c_str());
+        verifyThres=rf.check("verify_thres",Value(5.0)).asDouble();
+
+        numFeatures=rf.check("num_features",Value(1)).asInt();
+        numFeatures=std::max(1,std::min(numFeatures,3));
+
+        Vector min(3),max(3);
+        min[0]=-1.0; max[0]=1.0;
+        min[1]=-1.0; max[1]=1.0;
+        min[2]=-1.0; max[2]=1.0;
+        solver.setBounds(min,max);
+        solver.setWarmStart(warm_start=="on");
+        if (rf.check("linear_solver"))
+            solver.setLinearSolver(linear_solver);
+        solver.setMultiStart(multi_start=="on",solverThreads);
+        solution.resize(3,0.0);
+        frame.resize(0);
+
+        // the tool frame is estimated jointly from all the features
+        if (numFeatures>1)
+            frameSolver=new FindToolFrame(numFeatures);
+
+        return true;
+    }
+
+    /************************************************************************/
+    bool respond(const Bottle &command, Bottle &reply)
+    {
+        int ack=Vocab::encode("ack");
+        int nack=Vocab::encode("nack");
+
+        if (command.size()>0)
+        {
+            switch (command.get(0).asVocab())
+            {
+                //-----------------
+                case VOCAB4('c','l','e','a'):
+                {
+                    mutex.wait();
+                    solver.clearItems();
+                    if (frameSolver!=NULL)
+                        frameSolver->clearItems();
+                    items.clear();
+                    solution=0.0;
+                    frame.resize(0);
+                    mutex.post();
+
+                    publishStatus();
+                    reply.addVocab(ack);
+                    return true;
+                }
+                
+                //-----------------
+                case VOCAB3('a','d','d'):
+                {
+                    int cnt=0;
+                    if (command.size()>=2)
+                    {
+                        Vector data;
+                        const Value &payload=command.get(1);
+                        if (payload.isBlob())
+                        {
+                            // copy to get the doubles aligned
+                            data.resize(payload.asBlobLength()/sizeof(double));
+                            if (data.length()>0)
+                                memcpy(data.data(),payload.asBlob(),data.length()*sizeof(double));
+                        }
+                        else if (Bottle *pB=payload.asList())
+                        {
+                            data.resize(pB->size());
+                            for (size_t i=0; i<data.length(); i++)
+                                data[i]=pB->get(i).asDouble();
+                        }
+
+                        // the records carry the tip only, unless
+                        // the number of features is given
+                        int nFeat=(command.size()>=3)?command.get(2).asInt():1;
+                        nFeat=std::max(1,std::min(nFeat,ITEMLOG_MAX_FEAT));
+
+                        if (data.length()>0)
+                        {
+                            cnt=addItems(data.data(),data.length(),nFeat);
+                            publishStatus();
+                        }
+                    }
+
+                    reply.addVocab(ack);
+                    reply.addInt(cnt);
+                    return true;
+                }
+
+                //-----------------
+                case VOCAB4('s','e','l','e'):
+                {
+                    if (command.size()>=3)
+                    {
+                        string arm=command.get(1).asString().c_str();
+                        string eye=command.get(2).asString().c_str();
+
+                        if ((arm=="left") || (arm=="right"))
+                            this->arm=arm;
+
+                        bool ok=true;
+                        if ((eye=="left") || (eye=="right") || (eye=="both"))
+                        {
+                            if (hasIntrinsics(eye))
+                                this->eye=eye;
+                            else
+                                ok=false;
+                        }
+
+                        if (this->arm=="left")
+                            drvArmL.view(iarm);
+                        else
+                            drvArmR.view(iarm);
+
+                        if (history!=NULL)
+                            history->setArm(iarm);
+
+                        reply.addVocab(ok?ack:nack);
+                    }
+                    else
+                        reply.addVocab(nack);
+
+                    return true;
+                }
+
+                //-----------------
+                case VOCAB3('n','u','m'):
+                {
+                    reply.addVocab(ack);
+
+                    mutex.wait();
+                    reply.addInt((int)solver.getNumItems());
+                    mutex.post();
+
+                    return true;
+                }
+
+                //-----------------
+                case VOCAB4('f','i','n','d'):
+                {
+                    double error;
+
+                    Matrix cov;
+                    double cond;
+
+                    Vector xf;
+                    double frameError;
+                    bool okFrame=false;
+
+                    // the fast mode employs a single start and
+                    // skips the other features
+                    bool fast=(command.get(1).asString()=="fast");
+
+                    mutex.wait();
+                    bool ok=solver.solve(solution,error,fast);
+                    bool okCov=ok && solver.evalCovariance(solution,cov,cond);
+                    if (ok && !fast && (frameSolver!=NULL))
+                        okFrame=frameSolver->solve(xf,frameError);
+
+                    // the full frame is retained for the library
+                    if (okFrame && (numFeatures>2))
+                    {
+                        Matrix H=FindToolFrame::getFrame(xf);
+                        frame=cat(H.getCol(3).subVector(0,2),dcm2axis(H));
+                    }
+                    mutex.post();
+
+                    if (ok)
+                    {
+                        reply.addVocab(ack);
+                        for (size_t i=0; i<solution.length(); i++)
+                            reply.addDouble(solution[i]);
+
+                        Bottle &errorPart=reply.addList();
+                        errorPart.addString("error");
+                        errorPart.addDouble(error);
+
+                        if (okCov)
+                        {
+                            Bottle &covPart=reply.addList();
+                            covPart.addString("cov");
+                            for (int r=0; r<cov.rows(); r++)
+                                for (int c=0; c<cov.cols(); c++)
+                                    covPart.addDouble(cov(r,c));
+
+                            Bottle &condPart=reply.addList();
+                            condPart.addString("cond");
+                            condPart.addDouble(cond);
+                        }
+
+                        // the roll is observable only through the
+                        // side marker: without it, just the axis
+                        if (okFrame)
+                        {
+                            Matrix frame=FindToolFrame::getFrame(xf);
+                            Bottle &framePart=reply.addList();
+                            if (numFeatures>2)
+                            {
+                                Vector o=dcm2axis(frame);
+                                framePart.addString("frame");
+                                for (int i=0; i<3; i++)
+                                    framePart.addDouble(frame(i,3));
+                                for (size_t i=0; i<o.length(); i++)
+                                    framePart.addDouble(o[i]);
+                            }
+                            else
+                            {
+                                framePart.addString("axis");
+                                for (int i=0; i<3; i++)
+                                    framePart.addDouble(frame(i,3));
+                                for (int i=0; i<3; i++)
+                                    framePart.addDouble(frame(i,0));
+                            }
+
+                            Bottle &frameErrorPart=reply.addList();
+                            frameErrorPart.addString("frame_error");
+                            frameErrorPart.addDouble(frameError);
+                        }
+                    }
+                    else
+                        reply.addVocab(nack);
+
+                    return true;
+                }
+
+                //-----------------
+                case VOCAB4('s','h','o','w'):
+                {
+                    if (command.size()>=4)
+                    {
+                        solution[0]=command.get(1).asDouble();
+                        solution[1]=command.get(2).asDouble();
+                        solution[2]=command.get(3).asDouble();
+
+                        reply.addVocab(ack);
+                    }
+                    else
+                        reply.addVocab(nack);
+
+                    return true;
+                }
+
+                //-----------------
+                case VOCAB3('t','i','p'):
+                {
+                    if (tip.size()>=2)
+                    {
+                        reply.addVocab(ack);
+                        reply.append(tip);
+                    }
+                    else
+                        reply.addVocab(nack);
+
+                    return true;
+                }
+
+                //-----------------
+                case VOCAB3('l','o','g'):
+                {
+                    bool ok=true;
+
+                    mutex.wait();
+                    if (command.size()>=2)
+                        ok=logWriter.open(command.get(1).asString().c_str());
+                    else
+                        logWriter.close();
+                    mutex.post();
+
+                    reply.addVocab(ok?ack:nack);
+                    return true;
+                }
+
+                //-----------------
+                case VOCAB4('s','a','v','e'):
+                {
+                    if (command.size()>=2)
+                    {
+                        ToolEntry entry;
+                        entry.name=command.get(1).asString().c_str();
+
+                        mutex.wait();
+                        bool ok=(items.size()>0);
+                        if (ok)
+                        {
+                            double cond;
+                            entry.tip=solution;
+                            entry.frame=frame;
+                            entry.error=solver.evalError(solution);
+                            entry.numItems=(int)items.size();
+                            if (!solver.evalCovariance(solution,entry.cov,cond))
+                                entry.cov.resize(0,0);
+
+                            ok=library.save(entry,items);
+                        }
+                        mutex.post();
+
+                        reply.addVocab(ok?ack:nack);
+                    }
+                    else
+                        reply.addVocab(nack);
+
+                    return true;
+                }
+
+                //-----------------
+                case VOCAB4('r','e','c','a'):
+                {
+                    ToolEntry entry;
+                    if ((command.size()>=2) &&
+                        library.recall(command.get(1).asString().c_str(),entry))
+                    {
+                        mutex.wait();
+                        solution=entry.tip;
+                        frame=entry.frame;
+                        mutex.post();
+
+                        reply.addVocab(ack);
+                        for (size_t i=0; i<entry.tip.length(); i++)
+                            reply.addDouble(entry.tip[i]);
+
+                        Bottle &errorPart=reply.addList();
+                        errorPart.addString("error");
+                        errorPart.addDouble(entry.error);
+
+                        if (entry.cov.rows()==3)
+                        {
+                            Bottle &covPart=reply.addList();
+                            covPart.addString("cov");
+                            for (int r=0; r<entry.cov.rows(); r++)
+                                for (int c=0; c<entry.cov.cols(); c++)
+                                    covPart.addDouble(entry.cov(r,c));
+                        }
+
+                        if (entry.frame.length()>=7)
+                        {
+                            Bottle &framePart=reply.addList();
+                            framePart.addString("frame");
+                            for (size_t i=0; i<entry.frame.length(); i++)
+                                framePart.addDouble(entry.frame[i]);
+                        }
+
+                        Bottle &itemsPart=reply.addList();
+                        itemsPart.addString("items");
+                        itemsPart.addInt(entry.numItems);
+                    }
+                    else
+                        reply.addVocab(nack);
+
+                    return true;
+                }
+
+                //-----------------
+                case VOCAB4('v','e','r','i'):
+                {
+                    ToolEntry entry;
+                    if ((command.size()>=2) &&
+                        library.recall(command.get(1).asString().c_str(),entry))
+                    {
+                        double thres=(command.size()>=3)?
+                                     command.get(2).asDouble():verifyThres;
+
+                        mutex.wait();
+                        bool ok=(solver.getNumItems()>0);
+                        double error=ok?solver.evalError(entry.tip):-1.0;
+                        ok=ok && (error<thres);
+                        if (ok)
+                            solution=entry.tip;
+                        mutex.post();
+
+                        reply.addVocab(ok?ack:nack);
+                        if (ok)
+                        {
+                            for (size_t i=0; i<entry.tip.length(); i++)
+                                reply.addDouble(entry.tip[i]);
+                        }
+
+                        Bottle &errorPart=reply.addList();
+                        errorPart.addString("error");
+                        errorPart.addDouble(error);
+                    }
+                    else
+                        reply.addVocab(nack);
+
+                    return true;
+                }
+
+                //-----------------
+                case VOCAB4('e','n','a','b'):
+                {
+                    enabled=true;
+                    reply.addVocab(ack);
+                    return true;
+                }
+
+                //-----------------
+                case VOCAB4('d','i','s','a'):
+                {
+                    enabled=false;
+                    reply.addVocab(ack);
+                    return true;
+                }
+
+                //-----------------
+                default:
+                    return RFModule::respond(command,reply);
+            }
+        }
+
+        reply.addVocab(nack);
+        return true;
+    }
+
+    /************************************************************************/
+    double getPeriod()
+    {
+        return 0.03;
+    }
+
+    /************************************************************************/
+    bool updateModule()
+    {
+        if (imgOutPort.getOutputCount()>0)
+        {
+            if (ImageOf<PixelBgr> *pImgBgrIn=imgInPort.read(false))
+            {
+                Vector xa,oa;
+                iarm->getPose(xa,oa);
+
+                Matrix Ha=axis2dcm(oa);
+                xa.push_back(1.0);
+                Ha.setCol(3,xa);
+
+                // project locally through the cached intrinsics
+                // with just one query for the eye pose
+                int camSel=(eye=="right")?1:0;
+                Matrix He;
+                Vector xe,oe;
+                if (camSel==0)
+                    igaze->getLeftEyePose(xe,oe);
+                else
+                    igaze->getRightEyePose(xe,oe);
+
+                He=axis2dcm(oe);
+                xe.push_back(1.0);
+                He.setCol(3,xe);
+
+                Matrix Hprj=((camSel==0)?PrjL:PrjR)*SE3inv(He)*Ha;
+
+                Vector v(4,0.0); v[3]=1.0;
+                CvPoint point_c=project(Hprj,v);
+
+                v=0.0; v[0]=0.05; v[3]=1.0;
+                CvPoint point_x=project(Hprj,v);
+
+                v=0.0; v[1]=0.05; v[3]=1.0;
+                CvPoint point_y=project(Hprj,v);
+
+                v=0.0; v[2]=0.05; v[3]=1.0;
+                CvPoint point_z=project(Hprj,v);
+
+                v=solution; v.push_back(1.0);
+                CvPoint point_t=project(Hprj,v);
+
+                // draw in place: the received image is owned by the
+                // input port until its next read, whereas the plain
+                // port sends it synchronously, hence no copy is needed
+                ImageOf<PixelBgr> &imgOut=*pImgBgrIn;
+
+                cvCircle(imgOut.getIplImage(),point_c,4,cvScalar(0,255,0),4);
+                cvCircle(imgOut.getIplImage(),point_t,4,cvScalar(255,0,0),4);
+
+                cvLine(imgOut.getIplImage(),point_c,point_x,cvScalar(0,0,255),2);
+                cvLine(imgOut.getIplImage(),point_c,point_y,cvScalar(0,255,0),2);
+                cvLine(imgOut.getIplImage(),point_c,point_z,cvScalar(255,0,0),2);
+                cvLine(imgOut.getIplImage(),point_c,point_t,cvScalar(255,255,255),2);
+
+                tip.clear();
+                tip.addInt(point_t.x);
+                tip.addInt(point_t.y);
+
+                imgOutPort.write(imgOut);
+            }
+        }
+
+        return true;
+    }
+
+    /************************************************************************/
+    void terminate()
+    {
+
+        imgInPort.close();
+        imgOutPort.close();
+        dataInPort.close();     // close prior to shutting down motor-interfaces
+        dataInPortL.close();
+        dataInPortR.close();
+        logPort.close();
+        statusPort.close();
+        rpcPort.close();
+
+        if (history!=NULL)
+        {
+            history->stop();
+            delete history;
+            history=NULL;
+        }
+
+        logWriter.close();
+
+        if (frameSolver!=NULL)
+        {
+            delete frameSolver;
+            frameSolver=NULL;
+        }
+
+        if (drvArmL.isValid())
+            drvArmL.close();
+
+        if (drvArmR.isValid())
+            drvArmR.close();
+
+        if (drvGaze.isValid())
+            drvGaze.close();
+    }
+
+    /************************************************************************/
+    bool close()
+    {
+        terminate();
+        return true;
+    }
+};
+
+
+
+/************************************************************************/
+void DataPort::onRead(Bottle &data)
+{
+    if (module!=NULL)
+    {
+        // use the time the image was acquired, if available
+        Stamp stamp;
+        getEnvelope(stamp);
+        double t=stamp.isValid()?stamp.getTime():Time::now();
+
+        module->onData(source,data,t);
+    }
+}
+
+
+
+/****************************************************************/
+int main(int argc, char *argv[])
+{
+    Network yarp;
+    if (!yarp.checkNetwork())
+    {
+        printf("YARP server not available!\n");
+        return -1;
+    }
+
+    YARP_REGISTER_DEVICES(icubmod)
+
+    ResourceFinder rf;
+    rf.setVerbose(true);
+    rf.setDefaultContext("karma");
+    rf.configure(argc,argv);
+
+    FinderModule mod;
+    return mod.runModule(rf);
+}
+
+
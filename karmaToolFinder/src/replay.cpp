@@ -0,0 +1,265 @@
+/* 
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/** 
+\defgroup karmaToolFinderReplay Offline Replay of the Tool Solver
+ 
+Replay logs of items stored by \ref karmaToolFinder and run the
+tool solver offline.
+
+\section intro_sec Description 
+The binary log produced by \ref karmaToolFinder through the 
+<i>--log_file</i> option or the <i>[log]</i> command is loaded 
+and the items are fed into the same solver used online. This 
+way the optimization can be tuned and benchmarked without the 
+robot. 
+ 
+\section lib_sec Libraries 
+- YARP libraries. 
+- IPOPT library. 
+
+\section parameters_sec Parameters 
+--file \e file
+- The binary log to be replayed.
+ 
+--cam \e type
+- Select the items acquired by the "left" camera, the "right"
+  camera or "both". By default all the items are used.
+ 
+--min <i>(x y z)</i>
+- Lower bounds of the tool dimensions.
+ 
+--max <i>(x y z)</i>
+- Upper bounds of the tool dimensions.
+ 
+--x0 <i>(x y z)</i>
+- The initial guess.
+ 
+--subsample \e n
+- Use one item out of \e n.
+ 
+--max_items \e n
+- Use at most \e n items.
+ 
+--tol \e tol
+- Tolerance of the optimizer.
+ 
+--max_iter \e n
+- Maximum number of iterations of the optimizer.
+ 
+--repeat \e n
+- Solve \e n times to measure the solving time.
+ 
+--warm_start \e switch
+- If "on", each repetition is started from the previous
+  solution.
+ 
+--multi_start \e switch
+- If "on", the optimization is started also from the linear
+  estimate, the corners of the bounding box and the previous
+  solution, retaining the best result. By default it is "on", as
+  in \ref karmaToolFinder.
+ 
+--threads \e n
+- Number of threads sharing the starts in multi-start mode.
+ 
+--linear_solver \e name
+- The linear solver employed by IPOPT; the solves are serialized
+  unless it is given and differs from MUMPS, as in \ref
+  karmaToolFinder.
+ 
+--send \e port
+- Load the selected items into a running \ref karmaToolFinder
+  whose rpc port is given, by means of one <i>[add]</i> command
+  carrying the tracked features common to all the items.
+
+\section tested_os_sec Tested OS
+Windows, Linux
+
+\author Ugo Pattacini
+*/ 
+
+#include <stdio.h>
+#include <algorithm>
+#include <string>
+#include <deque>
+
+#include <yarp/os/all.h>
+#include <yarp/sig/all.h>
+
+#include "iCub/solver.h"
+#include "iCub/log.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+
+
+/****************************************************************/
+bool getTriplet(ResourceFinder &rf, const string &key, Vector &v)
+{
+    if (Bottle *pB=rf.find(key.c_str()).asList())
+    {
+        if (pB->size()>=3)
+        {
+            v.resize(3);
+            for (int i=0; i<3; i++)
+                v[i]=pB->get(i).asDouble();
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/****************************************************************/
+int main(int argc, char *argv[])
+{
+    ResourceFinder rf;
+    rf.configure(argc,argv);
+
+    if (!rf.check("file"))
+    {
+        printf("Usage: karmaToolFinderReplay --file <log> [options]\n");
+        return 1;
+    }
+
+    string file=rf.find("file").asString().c_str();
+    string cam=rf.check("cam",Value("both")).asString().c_str();
+    int subsample=std::max(rf.check("subsample",Value(1)).asInt(),1);
+    int maxItems=rf.check("max_items",Value(-1)).asInt();
+    int repeat=std::max(rf.check("repeat",Value(1)).asInt(),1);
+    string warm_start=rf.check("warm_start",Value("off")).asString().c_str();
+    string multi_start=rf.check("multi_start",Value("on")).asString().c_str();
+    int threads=std::max(rf.check("threads",Value(1)).asInt(),1);
+    string linear_solver=rf.check("linear_solver",Value("mumps")).asString().c_str();
+    IpoptLock::setThreadSafe(linear_solver!="mumps");
+
+    deque<ItemRecord> records;
+    if (!loadItemLog(file,records))
+    {
+        printf("Unable to load %s!\n",file.c_str());
+        return 1;
+    }
+
+    FindToolTip solver;
+
+    Vector min(3,-1.0),max(3,1.0);
+    getTriplet(rf,"min",min);
+    getTriplet(rf,"max",max);
+    solver.setBounds(min,max);
+
+    Vector x0;
+    if (getTriplet(rf,"x0",x0))
+        solver.setInitialGuess(x0);
+
+    if (rf.check("tol") || rf.check("max_iter"))
+        solver.setSolverOptions(rf.check("tol",Value(1e-8)).asDouble(),
+                                rf.check("max_iter",Value(300)).asInt());
+
+    if (rf.check("linear_solver"))
+        solver.setLinearSolver(linear_solver);
+    solver.setWarmStart(warm_start=="on");
+    solver.setMultiStart(multi_start=="on",threads);
+
+    deque<Vector> selP;
+    deque<Matrix> selH;
+    int nFeat=ITEMLOG_MAX_FEAT;
+    for (size_t i=0; i<records.size(); i+=subsample)
+    {
+        if ((maxItems>=0) && ((int)solver.getNumItems()>=maxItems))
+            break;
+
+        const ItemRecord &record=records[i];
+        if (((cam=="left") && (record.cam!=0.0)) ||
+            ((cam=="right") && (record.cam!=1.0)))
+            continue;
+
+        Vector p; Matrix H;
+        getItemRecord(record,p,H);
+        solver.addItem(p,H);
+
+        selP.push_back(p);
+        selH.push_back(H);
+        nFeat=std::min(nFeat,(int)p.length()/2);
+    }
+
+    // the items are sent with the features common to all of them
+    Vector packed;
+    for (size_t i=0; i<selP.size(); i++)
+    {
+        for (int j=0; j<2*nFeat; j++)
+            packed.push_back(selP[i][j]);
+        for (int r=0; r<3; r++)
+            for (int c=0; c<4; c++)
+                packed.push_back(selH[i](r,c));
+    }
+
+    printf("loaded %d records; using %d items\n",
+           (int)records.size(),(int)solver.getNumItems());
+
+    if (rf.check("send"))
+    {
+        Network yarp;
+        if (!yarp.checkNetwork())
+        {
+            printf("YARP server not available!\n");
+            return 1;
+        }
+
+        string remote=rf.find("send").asString().c_str();
+        RpcClient port;
+        port.open("/karmaToolFinderReplay/rpc");
+        if (!Network::connect(port.getName().c_str(),remote.c_str()))
+        {
+            printf("Unable to connect to %s!\n",remote.c_str());
+            port.close();
+            return 1;
+        }
+
+        // the whole set goes in one blob of doubles
+        Bottle cmd,reply;
+        cmd.addVocab(Vocab::encode("add"));
+        cmd.add(Value(packed.data(),(int)(packed.length()*sizeof(double))));
+        cmd.addInt(nFeat);
+        port.write(cmd,reply);
+        printf("sent %d items to %s: %s\n",(int)selP.size(),
+               remote.c_str(),reply.toString().c_str());
+
+        port.close();
+    }
+
+    Vector x;
+    double error=0.0;
+    bool ok=false;
+    double dt=0.0;
+    for (int i=0; i<repeat; i++)
+    {
+        double t0=Time::now();
+        ok=solver.solve(x,error);
+        dt+=Time::now()-t0;
+    }
+
+    printf("solution=(%s); error=%g [px]; %s\n",x.toString(5,5).c_str(),error,
+           ok?"succeeded":"failed");
+    printf("solving time=%g [ms] (average over %d runs)\n",1e3*dt/repeat,repeat);
+
+    return (ok?0:1);
+}
+
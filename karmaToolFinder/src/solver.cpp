@@ -0,0 +1,1189 @@
+/* 
+ * Copyright (C) 2012 Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Ugo Pattacini
+ * email:  ugo.pattacini@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <cmath>
+#include <algorithm>
+
+#include <yarp/os/Semaphore.h>
+#include <yarp/math/Math.h>
+#include <yarp/math/SVD.h>
+
+#include "iCub/solver.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+
+
+static Semaphore ipoptMutex;
+static bool      ipoptThreadSafe=false;
+
+/****************************************************************/
+void IpoptLock::setThreadSafe(const bool threadSafe)
+{
+    ipoptThreadSafe=threadSafe;
+}
+
+/****************************************************************/
+void IpoptLock::lock()
+{
+    if (!ipoptThreadSafe)
+        ipoptMutex.wait();
+}
+
+/****************************************************************/
+void IpoptLock::unlock()
+{
+    if (!ipoptThreadSafe)
+        ipoptMutex.post();
+}
+
+/****************************************************************/
+static bool triangulate(const deque<Vector> &p, const deque<Matrix> &H,
+                        const int j, Vector &x)
+{
+    // each item yields two equations linear in the feature j:
+    // (u*H.row(2)-H.row(0))*[x;1]=0 and (v*H.row(2)-H.row(1))*[x;1]=0;
+    // solve in the least-squares sense through the normal equations
+    if (p.size()<2)
+        return false;
+
+    Matrix A(3,3); A.zero();
+    Vector b(3,0.0);
+    for (size_t i=0; i<p.size(); i++)
+    {
+        for (int r=0; r<2; r++)
+        {
+            double pr=p[i][2*j+r];
+
+            Vector a(3);
+            for (int k=0; k<3; k++)
+                a[k]=pr*H[i](2,k)-H[i](r,k);
+            double c=pr*H[i](2,3)-H[i](r,3);
+
+            A=A+outerProduct(a,a);
+            b=b-c*a;
+        }
+    }
+
+    x=pinv(A)*b;
+    return true;
+}
+
+/****************************************************************/
+FindToolTipNLP::FindToolTipNLP(const deque<Vector> &_p,
+                               const deque<Matrix> &_H,
+                               const Vector &_min, const Vector &_max) :
+                               p(_p), H(_H)
+{
+    min=_min;
+    max=_max;
+    x0=0.5*(min+max);
+}
+
+/****************************************************************/
+void FindToolTipNLP::set_bounds(const Vector &min, const Vector &max)
+{
+    this->min=min;
+    this->max=max;
+}
+
+/****************************************************************/
+void FindToolTipNLP::set_x0(const Vector &x0)
+{
+    size_t len=std::min(this->x0.length(),x0.length());
+    for (size_t i=0; i<len; i++)
+        this->x0[i]=x0[i];
+}
+
+/****************************************************************/
+Vector FindToolTipNLP::get_result() const
+{
+    return x;
+}
+
+/****************************************************************/
+bool FindToolTipNLP::get_nlp_info(Ipopt::Index &n, Ipopt::Index &m, Ipopt::Index &nnz_jac_g,
+                                  Ipopt::Index &nnz_h_lag, IndexStyleEnum &index_style)
+{
+    n=3;
+    m=nnz_jac_g=nnz_h_lag=0;
+    index_style=TNLP::C_STYLE;
+
+    return true;
+}
+
+/****************************************************************/
+bool FindToolTipNLP::get_bounds_info(Ipopt::Index n, Ipopt::Number *x_l, Ipopt::Number *x_u,
+                                     Ipopt::Index m, Ipopt::Number *g_l, Ipopt::Number *g_u)
+{
+    for (Ipopt::Index i=0; i<n; i++)
+    {
+        x_l[i]=min[i];
+        x_u[i]=max[i];
+    }
+
+    return true;
+}
+
+/****************************************************************/
+bool FindToolTipNLP::get_starting_point(Ipopt::Index n, bool init_x, Ipopt::Number *x,
+                                        bool init_z, Ipopt::Number *z_L, Ipopt::Number *z_U,
+                                        Ipopt::Index m, bool init_lambda, Ipopt::Number *lambda)
+{
+    for (Ipopt::Index i=0; i<n; i++)
+        x[i]=x0[i];
+
+    return true;
+}
+
+/****************************************************************/
+bool FindToolTipNLP::eval_f(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                            Ipopt::Number &obj_value)
+{
+    obj_value=0.0;
+    if (p.size()>0)
+    {
+        Vector _x(4);
+        _x[0]=x[0];
+        _x[1]=x[1];
+        _x[2]=x[2];
+        _x[3]=1.0;
+
+        for (size_t i=0; i<p.size(); i++)
+        {
+            Vector pi=H[i]*_x;
+            pi=pi/pi[2];
+            pi.pop_back();
+
+            obj_value+=norm2(p[i]-pi);
+        }
+
+        obj_value/=p.size();
+    }
+
+    return true;
+}
+
+/****************************************************************/
+bool FindToolTipNLP::eval_grad_f(Ipopt::Index n, const Ipopt::Number* x, bool new_x,
+                                 Ipopt::Number *grad_f)
+{
+    Vector _x(4);
+    _x[0]=x[0];
+    _x[1]=x[1];
+    _x[2]=x[2];
+    _x[3]=1.0;
+
+    grad_f[0]=grad_f[1]=grad_f[2]=0.0;
+    if (p.size()>0)
+    {
+        for (size_t i=0; i<p.size(); i++)
+        {
+            Vector pi=H[i]*_x;
+            pi=pi/pi[2];
+            pi.pop_back();
+
+            Vector d=p[i]-pi;
+
+            double u_num=dot(H[i].getRow(0),_x);
+            double v_num=dot(H[i].getRow(1),_x);
+
+            double lambda=dot(H[i].getRow(2),_x);
+            double lambda2=lambda*lambda;
+
+            Vector dp_dx1(2);
+            dp_dx1[0]=(H[i](0,0)*lambda-H[i](2,0)*u_num)/lambda2;
+            dp_dx1[1]=(H[i](1,0)*lambda-H[i](2,0)*v_num)/lambda2;
+
+            Vector dp_dx2(2);
+            dp_dx2[0]=(H[i](0,1)*lambda-H[i](2,1)*u_num)/lambda2;
+            dp_dx2[1]=(H[i](1,1)*lambda-H[i](2,1)*v_num)/lambda2;
+
+            Vector dp_dx3(2);
+            dp_dx3[0]=(H[i](0,2)*lambda-H[i](2,2)*u_num)/lambda2;
+            dp_dx3[1]=(H[i](1,2)*lambda-H[i](2,2)*v_num)/lambda2;
+            
+            grad_f[0]-=2.0*dot(d,dp_dx1);
+            grad_f[1]-=2.0*dot(d,dp_dx2);
+            grad_f[2]-=2.0*dot(d,dp_dx3);
+        }
+
+        for (Ipopt::Index i=0; i<n; i++)
+            grad_f[i]/=p.size();
+    }        
+
+    return true;
+}
+
+/****************************************************************/
+bool FindToolTipNLP::eval_g(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                            Ipopt::Index m, Ipopt::Number *g)
+{
+    return true;
+}
+
+/****************************************************************/
+bool FindToolTipNLP::eval_jac_g(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                                Ipopt::Index m, Ipopt::Index nele_jac, Ipopt::Index *iRow,
+                                Ipopt::Index *jCol, Ipopt::Number *values)
+{
+    return true;
+}
+
+/****************************************************************/
+bool FindToolTipNLP::eval_h(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                            Ipopt::Number obj_factor, Ipopt::Index m, const Ipopt::Number *lambda,
+                            bool new_lambda, Ipopt::Index nele_hess, Ipopt::Index *iRow,
+                            Ipopt::Index *jCol, Ipopt::Number *values)
+{
+    return true;
+}
+
+/****************************************************************/
+void FindToolTipNLP::finalize_solution(Ipopt::SolverReturn status, Ipopt::Index n,
+                                       const Ipopt::Number *x, const Ipopt::Number *z_L,
+                                       const Ipopt::Number *z_U, Ipopt::Index m,
+                                       const Ipopt::Number *g, const Ipopt::Number *lambda,
+                                       Ipopt::Number obj_value, const Ipopt::IpoptData *ip_data,
+                                       Ipopt::IpoptCalculatedQuantities *ip_cq)
+{
+    this->x.resize(n);
+    for (Ipopt::Index i=0; i<n; i++)
+        this->x[i]=x[i];
+}
+
+/****************************************************************/
+double FindToolTip::evalError(const Vector &x) const
+{
+    double error=0.0;
+    if (p.size()>0)
+    {
+        Vector _x=x;
+        if (_x.length()<4)
+            _x.push_back(1.0);
+
+        for (size_t i=0; i<p.size(); i++)
+        {
+            Vector pi=H[i]*_x;
+            pi=pi/pi[2];
+            pi.pop_back();
+
+            error+=norm(p[i]-pi);
+        }
+
+        error/=p.size();
+    }
+
+    return error;
+}
+
+/****************************************************************/
+bool FindToolTip::evalCovariance(const Vector &x, Matrix &cov, double &cond) const
+{
+    // Gauss-Newton approximation: cov=sigma^2*inv(J'*J),
+    // with J the jacobian of the reprojection residuals
+    size_t N=p.size();
+    if ((N<2) || (x.length()<3))
+        return false;
+
+    Vector _x(4);
+    _x[0]=x[0];
+    _x[1]=x[1];
+    _x[2]=x[2];
+    _x[3]=1.0;
+
+    Matrix A(3,3); A.zero();
+    double res2=0.0;
+    for (size_t i=0; i<N; i++)
+    {
+        const Matrix &Hi=H[i];
+        double u_num=dot(Hi.getRow(0),_x);
+        double v_num=dot(Hi.getRow(1),_x);
+        double lambda=dot(Hi.getRow(2),_x);
+        double lambda2=lambda*lambda;
+
+        double du=p[i][0]-u_num/lambda;
+        double dv=p[i][1]-v_num/lambda;
+        res2+=du*du+dv*dv;
+
+        Vector Ju(3),Jv(3);
+        for (int k=0; k<3; k++)
+        {
+            Ju[k]=(Hi(0,k)*lambda-Hi(2,k)*u_num)/lambda2;
+            Jv[k]=(Hi(1,k)*lambda-Hi(2,k)*v_num)/lambda2;
+        }
+
+        A=A+outerProduct(Ju,Ju)+outerProduct(Jv,Jv);
+    }
+
+    Matrix U(3,3),V(3,3);
+    Vector S(3);
+    SVD(A,U,S,V);
+    if (S[2]<=0.0)
+        return false;
+
+    cond=S[0]/S[2];
+
+    double sigma2=res2/(2.0*N-3.0);
+    Matrix Sinv(3,3); Sinv.zero();
+    for (int k=0; k<3; k++)
+        Sinv(k,k)=sigma2/S[k];
+
+    cov=V*Sinv*U.transposed();
+    return true;
+}
+
+/****************************************************************/
+FindToolTipWorker::FindToolTipWorker(FindToolTip *solver, const int id) :
+                                     solver(solver), id(id), go(0), done(0)
+{
+}
+
+/****************************************************************/
+void FindToolTipWorker::run()
+{
+    while (true)
+    {
+        go.wait();
+        if (isStopping())
+            break;
+
+        solver->processStarts(id);
+        done.post();
+    }
+}
+
+/****************************************************************/
+void FindToolTipWorker::onStop()
+{
+    go.post();
+}
+
+/****************************************************************/
+void FindToolTipWorker::trigger()
+{
+    go.post();
+}
+
+/****************************************************************/
+void FindToolTipWorker::waitDone()
+{
+    done.wait();
+}
+
+/****************************************************************/
+FindToolTip::FindToolTip()
+{
+    min.resize(3); max.resize(3);
+    min[0]=-1.0;   max[0]=1.0;
+    min[1]=-1.0;   max[1]=1.0;
+    min[2]=-1.0;   max[2]=1.0;
+
+    x0=0.5*(min+max);
+    warm_start=false;
+    multi_start=false;
+    tol=1e-8;
+    max_iter=300;
+    nextJob=0;
+    lastIterations=0;
+
+    contexts.push_back(createContext());
+}
+
+/****************************************************************/
+FindToolTip::Context FindToolTip::createContext()
+{
+    Context context;
+    context.app=new Ipopt::IpoptApplication;
+    context.app->Options()->SetNumericValue("tol",tol);
+    context.app->Options()->SetNumericValue("acceptable_tol",tol);
+    context.app->Options()->SetIntegerValue("acceptable_iter",10);
+    context.app->Options()->SetStringValue("mu_strategy","adaptive");
+    context.app->Options()->SetIntegerValue("max_iter",max_iter);
+    context.app->Options()->SetStringValue("nlp_scaling_method","gradient-based");
+    context.app->Options()->SetStringValue("hessian_approximation","limited-memory");
+    context.app->Options()->SetIntegerValue("print_level",0);
+    context.app->Options()->SetStringValue("derivative_test","none");
+    if (!linear_solver.empty())
+        context.app->Options()->SetStringValue("linear_solver",linear_solver);
+    context.app->Initialize();
+
+    context.nlp=new FindToolTipNLP(p,H,min,max);
+    return context;
+}
+
+/****************************************************************/
+void FindToolTip::setBounds(const Vector &min, const Vector &max)
+{
+    size_t len_min=std::min(this->min.length(),min.length());
+    size_t len_max=std::min(this->max.length(),max.length());
+
+    for (size_t i=0; i<len_min; i++)
+        this->min[i]=min[i];
+
+    for (size_t i=0; i<len_max; i++)
+        this->max[i]=max[i];
+
+    for (size_t i=0; i<contexts.size(); i++)
+        contexts[i].nlp->set_bounds(this->min,this->max);
+}
+
+/****************************************************************/
+void FindToolTip::setWarmStart(const bool sw)
+{
+    warm_start=sw;
+}
+
+/****************************************************************/
+void FindToolTip::setSolverOptions(const double tol, const int max_iter)
+{
+    this->tol=tol;
+    this->max_iter=max_iter;
+
+    for (size_t i=0; i<contexts.size(); i++)
+    {
+        contexts[i].app->Options()->SetNumericValue("tol",tol);
+        contexts[i].app->Options()->SetNumericValue("acceptable_tol",tol);
+        contexts[i].app->Options()->SetIntegerValue("max_iter",max_iter);
+        contexts[i].app->Initialize();
+    }
+}
+
+/****************************************************************/
+void FindToolTip::setLinearSolver(const string &linear_solver)
+{
+    this->linear_solver=linear_solver;
+
+    for (size_t i=0; i<contexts.size(); i++)
+    {
+        contexts[i].app->Options()->SetStringValue("linear_solver",linear_solver);
+        contexts[i].app->Initialize();
+    }
+}
+
+/****************************************************************/
+void FindToolTip::setMultiStart(const bool sw, const int nThreads)
+{
+    stopWorkers();
+    contexts.resize(1);
+
+    multi_start=sw;
+    if (multi_start)
+    {
+        // one persistent context per thread, the calling one included
+        for (int i=1; i<nThreads; i++)
+        {
+            contexts.push_back(createContext());
+
+            FindToolTipWorker *worker=new FindToolTipWorker(this,i);
+            worker->start();
+            workers.push_back(worker);
+        }
+    }
+}
+
+/****************************************************************/
+void FindToolTip::stopWorkers()
+{
+    for (size_t i=0; i<workers.size(); i++)
+    {
+        workers[i]->stop();
+        delete workers[i];
+    }
+
+    workers.clear();
+}
+
+/****************************************************************/
+bool FindToolTip::addItem(const Vector &pi, const Matrix &Hi)
+{
+    if ((pi.length()>=2) && (Hi.rows()>=3) && (Hi.cols()>=4))
+    {
+        Vector _pi=pi.subVector(0,1);
+        Matrix _Hi=Hi.submatrix(0,2,0,3);
+
+        p.push_back(_pi);
+        H.push_back(_Hi);
+
+        return true;
+    }
+    else
+        return false;
+}
+
+/****************************************************************/
+void FindToolTip::clearItems()
+{
+    p.clear();
+    H.clear();
+}
+
+/****************************************************************/
+size_t FindToolTip::getNumItems() const
+{
+    return p.size();
+}
+
+/****************************************************************/
+bool FindToolTip::setInitialGuess(const Vector &x0)
+{
+    size_t len=std::min(x0.length(),this->x0.length());
+    for (size_t i=0; i<len; i++)
+        this->x0[i]=x0[i];
+
+    return true;
+}
+
+/****************************************************************/
+bool FindToolTip::isInBounds(const Vector &x) const
+{
+    if (x.length()<min.length())
+        return false;
+
+    bool in=true;
+    for (size_t i=0; i<min.length(); i++)
+        in&=(x[i]>=min[i]) && (x[i]<=max[i]);
+
+    return in;
+}
+
+/****************************************************************/
+bool FindToolTip::isInFront(const Vector &x) const
+{
+    // the third row of H yields the depth of the point
+    // in the camera frame, which has to be positive
+    for (size_t i=0; i<H.size(); i++)
+    {
+        double lambda=H[i](2,0)*x[0]+H[i](2,1)*x[1]+H[i](2,2)*x[2]+H[i](2,3);
+        if (lambda<=0.0)
+            return false;
+    }
+
+    return true;
+}
+
+/****************************************************************/
+bool FindToolTip::getLinearEstimate(Vector &x) const
+{
+    if (!triangulate(p,H,0,x))
+        return false;
+
+    // bring the estimate within the bounds
+    for (size_t i=0; i<x.length(); i++)
+        x[i]=std::max(min[i],std::min(max[i],x[i]));
+
+    return true;
+}
+
+/****************************************************************/
+void FindToolTip::processStarts(const int id)
+{
+    Context &context=contexts[id];
+    while (true)
+    {
+        mutexJobs.wait();
+        size_t k=nextJob++;
+        mutexJobs.post();
+
+        if (k>=starts.size())
+            break;
+
+        context.nlp->set_x0(starts[k]);
+        IpoptLock::lock();
+        Ipopt::ApplicationReturnStatus status=context.app->OptimizeTNLP(GetRawPtr(context.nlp));
+        IpoptLock::unlock();
+
+        results[k]=context.nlp->get_result();
+        statuses[k]=(status==Ipopt::Solve_Succeeded);
+
+        Ipopt::SmartPtr<Ipopt::SolveStatistics> stats=context.app->Statistics();
+        iterations[k]=Ipopt::IsValid(stats)?stats->IterationCount():0;
+    }
+}
+
+/****************************************************************/
+bool FindToolTip::solve(Vector &x, double &error, const bool fast)
+{
+    if (p.size()>0)
+    {
+        // start from the previous solution if requested,
+        // provided that it still lies within the bounds
+        Vector _x0=x0;
+        if (warm_start && isInBounds(xprev))
+            _x0=xprev;
+
+        starts.clear();
+        starts.push_back(_x0);
+
+        // multi-start: the linear estimate, the corners of the
+        // bounding box and the previous solution are also tried,
+        // unless a fast estimate is requested
+        if (multi_start && !fast)
+        {
+            Vector xl;
+            if (getLinearEstimate(xl))
+                starts.push_back(xl);
+
+            for (int k=0; k<8; k++)
+            {
+                Vector corner(3);
+                for (int i=0; i<3; i++)
+                    corner[i]=((k>>i)&0x01)?max[i]:min[i];
+                starts.push_back(corner);
+            }
+
+            if (!warm_start && isInBounds(xprev))
+                starts.push_back(xprev);
+        }
+
+        results.assign(starts.size(),Vector());
+        statuses.assign(starts.size(),false);
+        iterations.assign(starts.size(),0);
+        nextJob=0;
+
+        for (size_t i=0; i<workers.size(); i++)
+            workers[i]->trigger();
+
+        processStarts(0);
+
+        for (size_t i=0; i<workers.size(); i++)
+            workers[i]->waitDone();
+
+        // pick the best candidate, discarding those behind the
+        // camera unless no other choice is available
+        int best=-1;
+        double bestError=0.0;
+        bool bestOk=false,bestFront=false;
+        for (size_t k=0; k<results.size(); k++)
+        {
+            if (results[k].length()<3)
+                continue;
+
+            bool front=isInFront(results[k]);
+            double e=evalError(results[k]);
+
+            bool better;
+            if (best<0)
+                better=true;
+            else if (front!=bestFront)
+                better=front;
+            else if (statuses[k]!=bestOk)
+                better=statuses[k];
+            else
+                better=(e<bestError);
+
+            if (better)
+            {
+                best=(int)k;
+                bestError=e;
+                bestOk=statuses[k];
+                bestFront=front;
+            }
+        }
+
+        if (best<0)
+            return false;
+
+        x=results[best];
+        error=bestError;
+        lastIterations=iterations[best];
+
+        if (bestOk)
+            xprev=x;
+
+        return bestOk;
+    }
+    else
+        return false;
+}
+
+/****************************************************************/
+int FindToolTip::getNumIterations() const
+{
+    return lastIterations;
+}
+
+/****************************************************************/
+FindToolTip::~FindToolTip()
+{
+    stopWorkers();
+}
+
+/****************************************************************/
+static void toolRotation(const double *x, Matrix &R, Matrix *dR)
+{
+    // R=Rz(yaw)*Ry(pitch)*Rx(roll) along with its derivatives
+    // wrt the three angles, if requested
+    double ca=cos(x[3]),sa=sin(x[3]);
+    double cb=cos(x[4]),sb=sin(x[4]);
+    double cc=cos(x[5]),sc=sin(x[5]);
+
+    Matrix Rz=eye(3,3),Ry=eye(3,3),Rx=eye(3,3);
+    Rz(0,0)=ca; Rz(0,1)=-sa; Rz(1,0)=sa;  Rz(1,1)=ca;
+    Ry(0,0)=cb; Ry(0,2)=sb;  Ry(2,0)=-sb; Ry(2,2)=cb;
+    Rx(1,1)=cc; Rx(1,2)=-sc; Rx(2,1)=sc;  Rx(2,2)=cc;
+    R=Rz*Ry*Rx;
+
+    if (dR!=NULL)
+    {
+        Matrix dRz(3,3),dRy(3,3),dRx(3,3);
+        dRz.zero(); dRy.zero(); dRx.zero();
+        dRz(0,0)=-sa; dRz(0,1)=-ca; dRz(1,0)=ca;  dRz(1,1)=-sa;
+        dRy(0,0)=-sb; dRy(0,2)=cb;  dRy(2,0)=-cb; dRy(2,2)=-sb;
+        dRx(1,1)=-sc; dRx(1,2)=-cc; dRx(2,1)=cc;  dRx(2,2)=-sc;
+
+        dR[0]=dRz*Ry*Rx;
+        dR[1]=Rz*dRy*Rx;
+        dR[2]=Rz*Ry*dRx;
+    }
+}
+
+/****************************************************************/
+static Vector toolFeature(const double *x, const int j)
+{
+    // the features in the tool frame: the tip at the origin, the
+    // axis feature behind it along the x-axis and the side marker
+    // in the xz-plane
+    Vector f(3,0.0);
+    if (j==1)
+        f[0]=-x[6];
+    else if (j==2)
+    {
+        f[0]=x[7];
+        f[2]=x[8];
+    }
+
+    return f;
+}
+
+/****************************************************************/
+static double evalFrameResiduals(const deque<Vector> &p, const deque<Matrix> &H,
+                                 const int numFeatures, const int n,
+                                 const double *x, double *grad)
+{
+    // sum of the squared reprojection errors of all the features
+    // over the items, with the gradient if requested
+    Matrix R,dR[3];
+    toolRotation(x,R,(grad!=NULL)?dR:NULL);
+
+    if (grad!=NULL)
+    {
+        for (int k=0; k<n; k++)
+            grad[k]=0.0;
+    }
+
+    double f=0.0;
+    for (int j=0; j<numFeatures; j++)
+    {
+        Vector fj=toolFeature(x,j);
+        Vector Rf=R*fj;
+
+        Vector P(4);
+        P[0]=x[0]+Rf[0];
+        P[1]=x[1]+Rf[1];
+        P[2]=x[2]+Rf[2];
+        P[3]=1.0;
+
+        // jacobian of the feature position wrt the unknowns
+        Matrix dP(3,n); dP.zero();
+        if (grad!=NULL)
+        {
+            dP(0,0)=dP(1,1)=dP(2,2)=1.0;
+            for (int k=0; k<3; k++)
+                dP.setSubcol(dR[k]*fj,0,3+k);
+
+            if (j==1)
+                dP.setSubcol(-1.0*R.getCol(0),0,6);
+            else if (j==2)
+            {
+                dP.setSubcol(R.getCol(0),0,7);
+                dP.setSubcol(R.getCol(2),0,8);
+            }
+        }
+
+        for (size_t i=0; i<p.size(); i++)
+        {
+            const Matrix &Hi=H[i];
+            double u_num=dot(Hi.getRow(0),P);
+            double v_num=dot(Hi.getRow(1),P);
+            double lambda=dot(Hi.getRow(2),P);
+
+            double du=p[i][2*j]-u_num/lambda;
+            double dv=p[i][2*j+1]-v_num/lambda;
+            f+=du*du+dv*dv;
+
+            if (grad!=NULL)
+            {
+                double lambda2=lambda*lambda;
+                Vector Ju(3),Jv(3);
+                for (int k=0; k<3; k++)
+                {
+                    Ju[k]=(Hi(0,k)*lambda-Hi(2,k)*u_num)/lambda2;
+                    Jv[k]=(Hi(1,k)*lambda-Hi(2,k)*v_num)/lambda2;
+                }
+
+                Vector g=(du*Ju+dv*Jv)*dP;
+                for (int k=0; k<n; k++)
+                    grad[k]-=2.0*g[k];
+            }
+        }
+    }
+
+    return f;
+}
+
+/****************************************************************/
+FindToolFrameNLP::FindToolFrameNLP(const deque<Vector> &_p,
+                                   const deque<Matrix> &_H,
+                                   const int _numFeatures, const Vector &_min,
+                                   const Vector &_max) :
+                                   p(_p), H(_H), numFeatures(_numFeatures)
+{
+    min=_min;
+    max=_max;
+    x0=0.5*(min+max);
+}
+
+/****************************************************************/
+void FindToolFrameNLP::set_x0(const Vector &x0)
+{
+    size_t len=std::min(this->x0.length(),x0.length());
+    for (size_t i=0; i<len; i++)
+        this->x0[i]=x0[i];
+}
+
+/****************************************************************/
+Vector FindToolFrameNLP::get_result() const
+{
+    return x;
+}
+
+/****************************************************************/
+bool FindToolFrameNLP::get_nlp_info(Ipopt::Index &n, Ipopt::Index &m, Ipopt::Index &nnz_jac_g,
+                                    Ipopt::Index &nnz_h_lag, IndexStyleEnum &index_style)
+{
+    n=(Ipopt::Index)min.length();
+    m=nnz_jac_g=nnz_h_lag=0;
+    index_style=TNLP::C_STYLE;
+
+    return true;
+}
+
+/****************************************************************/
+bool FindToolFrameNLP::get_bounds_info(Ipopt::Index n, Ipopt::Number *x_l, Ipopt::Number *x_u,
+                                       Ipopt::Index m, Ipopt::Number *g_l, Ipopt::Number *g_u)
+{
+    for (Ipopt::Index i=0; i<n; i++)
+    {
+        x_l[i]=min[i];
+        x_u[i]=max[i];
+    }
+
+    return true;
+}
+
+/****************************************************************/
+bool FindToolFrameNLP::get_starting_point(Ipopt::Index n, bool init_x, Ipopt::Number *x,
+                                          bool init_z, Ipopt::Number *z_L, Ipopt::Number *z_U,
+                                          Ipopt::Index m, bool init_lambda, Ipopt::Number *lambda)
+{
+    for (Ipopt::Index i=0; i<n; i++)
+        x[i]=x0[i];
+
+    return true;
+}
+
+/****************************************************************/
+bool FindToolFrameNLP::eval_f(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                              Ipopt::Number &obj_value)
+{
+    obj_value=0.0;
+    if (p.size()>0)
+        obj_value=evalFrameResiduals(p,H,numFeatures,n,x,NULL)/p.size();
+
+    return true;
+}
+
+/****************************************************************/
+bool FindToolFrameNLP::eval_grad_f(Ipopt::Index n, const Ipopt::Number* x, bool new_x,
+                                   Ipopt::Number *grad_f)
+{
+    for (Ipopt::Index i=0; i<n; i++)
+        grad_f[i]=0.0;
+
+    if (p.size()>0)
+    {
+        evalFrameResiduals(p,H,numFeatures,n,x,grad_f);
+        for (Ipopt::Index i=0; i<n; i++)
+            grad_f[i]/=p.size();
+    }
+
+    return true;
+}
+
+/****************************************************************/
+bool FindToolFrameNLP::eval_g(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                              Ipopt::Index m, Ipopt::Number *g)
+{
+    return true;
+}
+
+/****************************************************************/
+bool FindToolFrameNLP::eval_jac_g(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                                  Ipopt::Index m, Ipopt::Index nele_jac, Ipopt::Index *iRow,
+                                  Ipopt::Index *jCol, Ipopt::Number *values)
+{
+    return true;
+}
+
+/****************************************************************/
+bool FindToolFrameNLP::eval_h(Ipopt::Index n, const Ipopt::Number *x, bool new_x,
+                              Ipopt::Number obj_factor, Ipopt::Index m, const Ipopt::Number *lambda,
+                              bool new_lambda, Ipopt::Index nele_hess, Ipopt::Index *iRow,
+                              Ipopt::Index *jCol, Ipopt::Number *values)
+{
+    return true;
+}
+
+/****************************************************************/
+void FindToolFrameNLP::finalize_solution(Ipopt::SolverReturn status, Ipopt::Index n,
+                                         const Ipopt::Number *x, const Ipopt::Number *z_L,
+                                         const Ipopt::Number *z_U, Ipopt::Index m,
+                                         const Ipopt::Number *g, const Ipopt::Number *lambda,
+                                         Ipopt::Number obj_value, const Ipopt::IpoptData *ip_data,
+                                         Ipopt::IpoptCalculatedQuantities *ip_cq)
+{
+    this->x.resize(n);
+    for (Ipopt::Index i=0; i<n; i++)
+        this->x[i]=x[i];
+}
+
+/****************************************************************/
+FindToolFrame::FindToolFrame(const int numFeatures)
+{
+    this->numFeatures=std::max(2,std::min(numFeatures,3));
+
+    int n=(this->numFeatures>2)?9:7;
+    min.resize(n); max.resize(n);
+    for (int i=0; i<3; i++)
+    {
+        min[i]=-1.0;
+        max[i]=1.0;
+    }
+
+    // yaw and roll have room beyond +/-pi not to get stuck at
+    // the bounds, whereas the pitch spans +/-pi/2
+    min[3]=-2.0*M_PI; max[3]=2.0*M_PI;
+    min[4]=-M_PI/2.0; max[4]=M_PI/2.0;
+    min[5]=-2.0*M_PI; max[5]=2.0*M_PI;
+
+    // the roll is not observable without the side marker,
+    // hence it is held at zero
+    if (this->numFeatures<3)
+        min[5]=max[5]=0.0;
+
+    min[6]=0.0; max[6]=1.0;
+    if (n>7)
+    {
+        min[7]=-1.0; max[7]=1.0;
+        min[8]=0.0;  max[8]=1.0;
+    }
+
+    app=new Ipopt::IpoptApplication;
+    app->Options()->SetNumericValue("tol",1e-8);
+    app->Options()->SetNumericValue("acceptable_tol",1e-8);
+    app->Options()->SetIntegerValue("acceptable_iter",10);
+    app->Options()->SetStringValue("mu_strategy","adaptive");
+    app->Options()->SetIntegerValue("max_iter",300);
+    app->Options()->SetStringValue("nlp_scaling_method","gradient-based");
+    app->Options()->SetStringValue("hessian_approximation","limited-memory");
+    app->Options()->SetIntegerValue("print_level",0);
+    app->Options()->SetStringValue("derivative_test","none");
+    app->Initialize();
+
+    nlp=new FindToolFrameNLP(p,H,this->numFeatures,min,max);
+}
+
+/****************************************************************/
+bool FindToolFrame::addItem(const Vector &pi, const Matrix &Hi)
+{
+    // only the items carrying all the features are retained
+    size_t len=2*numFeatures;
+    if ((pi.length()>=len) && (Hi.rows()>=3) && (Hi.cols()>=4))
+    {
+        p.push_back(pi.subVector(0,len-1));
+        H.push_back(Hi.submatrix(0,2,0,3));
+
+        return true;
+    }
+    else
+        return false;
+}
+
+/****************************************************************/
+void FindToolFrame::clearItems()
+{
+    p.clear();
+    H.clear();
+}
+
+/****************************************************************/
+size_t FindToolFrame::getNumItems() const
+{
+    return p.size();
+}
+
+/****************************************************************/
+double FindToolFrame::evalError(const Vector &x) const
+{
+    // mean reprojection error per feature
+    if ((p.size()==0) || (x.length()<min.length()))
+        return 0.0;
+
+    Matrix R;
+    toolRotation(x.data(),R,NULL);
+
+    double error=0.0;
+    for (int j=0; j<numFeatures; j++)
+    {
+        Vector P=x.subVector(0,2)+R*toolFeature(x.data(),j);
+        P.push_back(1.0);
+
+        for (size_t i=0; i<p.size(); i++)
+        {
+            Vector pi=H[i]*P;
+            pi=pi/pi[2];
+            pi.pop_back();
+
+            error+=norm(p[i].subVector(2*j,2*j+1)-pi);
+        }
+    }
+
+    return error/(p.size()*numFeatures);
+}
+
+/****************************************************************/
+bool FindToolFrame::getLinearEstimate(Vector &x) const
+{
+    // the features are triangulated one by one and the frame is
+    // derived from the resulting points
+    Vector P[3];
+    for (int j=0; j<numFeatures; j++)
+    {
+        if (!triangulate(p,H,j,P[j]))
+            return false;
+    }
+
+    Vector ax=P[0]-P[1];
+    double d=norm(ax);
+    if (d<1e-6)
+        return false;
+    ax=ax/d;
+
+    x.resize(min.length(),0.0);
+    x.setSubvector(0,P[0]);
+    x[3]=atan2(ax[1],ax[0]);
+    x[4]=atan2(-ax[2],sqrt(ax[0]*ax[0]+ax[1]*ax[1]));
+    x[6]=d;
+
+    if (numFeatures>2)
+    {
+        // the roll brings the z-axis toward the side marker
+        Vector s=P[2]-P[0];
+        x[7]=dot(s,ax);
+        s=s-x[7]*ax;
+        x[8]=norm(s);
+        if (x[8]>1e-6)
+        {
+            Matrix R;
+            toolRotation(x.data(),R,NULL);
+            Vector z=R.transposed()*(s/x[8]);
+            x[5]=atan2(-z[1],z[2]);
+        }
+    }
+
+    for (size_t i=0; i<x.length(); i++)
+        x[i]=std::max(min[i],std::min(max[i],x[i]));
+
+    return true;
+}
+
+/****************************************************************/
+bool FindToolFrame::solve(Vector &x, double &error)
+{
+    // the linear estimate and the previous solution are tried
+    // as starting points, retaining the best result
+    deque<Vector> starts;
+    Vector xl;
+    if (getLinearEstimate(xl))
+        starts.push_back(xl);
+    if (xprev.length()==min.length())
+        starts.push_back(xprev);
+
+    int best=-1;
+    double bestError=0.0;
+    bool bestOk=false;
+    Vector bestX;
+    for (size_t k=0; k<starts.size(); k++)
+    {
+        nlp->set_x0(starts[k]);
+        IpoptLock::lock();
+        Ipopt::ApplicationReturnStatus status=app->OptimizeTNLP(GetRawPtr(nlp));
+        IpoptLock::unlock();
+
+        Vector xk=nlp->get_result();
+        if (xk.length()<min.length())
+            continue;
+
+        bool ok=(status==Ipopt::Solve_Succeeded);
+        double e=evalError(xk);
+        if ((best<0) || (ok && !bestOk) || ((ok==bestOk) && (e<bestError)))
+        {
+            best=(int)k;
+            bestError=e;
+            bestOk=ok;
+            bestX=xk;
+        }
+    }
+
+    if (best<0)
+        return false;
+
+    x=bestX;
+    error=bestError;
+
+    if (bestOk)
+        xprev=x;
+
+    return bestOk;
+}
+
+/****************************************************************/
+Matrix FindToolFrame::getFrame(const Vector &x)
+{
+    Matrix R;
+    toolRotation(x.data(),R,NULL);
+
+    Matrix frame=eye(4,4);
+    frame.setSubmatrix(R,0,0);
+    frame.setSubcol(x.subVector(0,2),0,3);
+
+    return frame;
+}
+